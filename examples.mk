@@ -33,8 +33,25 @@ vpxenc.SRCS                 += vpx_ports/mem_ops_aligned.h
 vpxenc.SRCS                 += libmkv/EbmlIDs.h
 vpxenc.SRCS                 += libmkv/EbmlWriter.c
 vpxenc.SRCS                 += libmkv/EbmlWriter.h
+vpxenc.SRCS                 += libmkv/WebMStreamWriter.c
+vpxenc.SRCS                 += libmkv/WebMStreamWriter.h
 vpxenc.GUID                  = 548DEC74-7A15-4B2B-AFC3-AA102E7C25C1
 vpxenc.DESCRIPTION           = Full featured encoder
+# The kernel benchmark needs the codec's internal headers, which an
+# installed tree doesn't have.
+ifneq ($(HAVE_ALT_TREE_LAYOUT),yes)
+UTILS-$(CONFIG_VP8_ENCODER) += vp8_bench.c
+endif
+vp8_bench.SRCS              += args.c args.h y4minput.c y4minput.h
+vp8_bench.SRCS              += vpx_ports/config.h vpx_ports/mem.h
+vp8_bench.SRCS              += vpx_ports/vpx_timer.h vpx_ports/x86.h
+vp8_bench.GUID               = 2C3A1C7E-5B0D-4F2B-9E61-8D4A7F0B3E15
+vp8_bench.DESCRIPTION        = RTCD kernel micro-benchmark
+UTILS-$(CONFIG_VP8_ENCODER) += vp8_encode_bench.c
+vp8_encode_bench.SRCS       += args.c args.h y4minput.c y4minput.h
+vp8_encode_bench.SRCS       += vpx_ports/config.h vpx_ports/vpx_timer.h
+vp8_encode_bench.GUID        = 7E4B9D21-36C8-4A5F-B0E2-51F9C3D8A647
+vp8_encode_bench.DESCRIPTION = Encoder speed/quality benchmark
 
 # Clean up old ivfenc, ivfdec binaries.
 ifeq ($(CONFIG_MSVS),yes)
@@ -88,6 +105,9 @@ vp8_set_maps.DESCRIPTION            = VP8 set active and ROI maps
 GEN_EXAMPLES-$(CONFIG_VP8_ENCODER) += vp8cx_set_ref.c
 vp8cx_set_ref.GUID                  = C5E31F7F-96F6-48BD-BD3E-10EBF6E8057A
 vp8cx_set_ref.DESCRIPTION           = VP8 set encoder reference frame
+GEN_EXAMPLES-$(CONFIG_VP8_ENCODER) += vp8_simulcast.c
+vp8_simulcast.GUID                  = 5B2E8F1A-3C6D-4E9B-A7F0-1D4C8B2A6E93
+vp8_simulcast.DESCRIPTION           = VP8 simulcast of a lower resolution stream
 
 
 # Handle extra library flags depending on codec configuration
@@ -113,6 +133,7 @@ else
     INC_PATH := $(call enabled,INC_PATH)
 endif
 CFLAGS += $(addprefix -I,$(INC_PATH))
+$(BUILD_PFX)vp8_bench.c.d $(BUILD_PFX)vp8_bench.c.o: CFLAGS += -I$(SRC_PATH_BARE)/vp8/common
 LDFLAGS += $(addprefix -L,$(LIB_PATH))
 
 
@@ -0,0 +1,352 @@
+// Copyright (c) 2010 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+
+#include "WebMStreamWriter.h"
+#include "EbmlIDs.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(_MSC_VER)
+#define LITERALU64(n) n
+#else
+#define LITERALU64(n) n##LLU
+#endif
+
+//this is a key that says length unknown
+#define UNKNOWN_LEN LITERALU64(0x01FFFFFFFFFFFFFF)
+
+struct cue_entry
+{
+    uint64_t time;
+    uint64_t loc;
+};
+
+struct WebMStream
+{
+    WebMStreamWriteFn write_fn;
+    void             *user;
+    int               error;
+
+    // Output assembled for the current call
+    unsigned char    *buf;
+    unsigned long     len;
+    unsigned long     size;
+
+    // Bytes written so far, and where the Segment's data starts
+    uint64_t          position;
+    uint64_t          segment_start;
+
+    uint64_t          last_pts_ms;
+    uint64_t          cluster_timecode;
+    int               have_pts;
+    int               cluster_open;
+
+    struct cue_entry *cue_list;
+    unsigned int      cues;
+};
+
+
+static int reserve(WebMStream *stream, unsigned long len)
+{
+    if (stream->error)
+        return 0;
+
+    if (stream->len + len > stream->size)
+    {
+        unsigned long size = (stream->len + len) * 2;
+        unsigned char *buf = realloc(stream->buf, size);
+
+        if (!buf)
+        {
+            stream->error = -1;
+            return 0;
+        }
+
+        stream->buf = buf;
+        stream->size = size;
+    }
+
+    return 1;
+}
+
+static void put_bytes(WebMStream *stream, const void *data, unsigned long len)
+{
+    if (!reserve(stream, len))
+        return;
+
+    memcpy(stream->buf + stream->len, data, len);
+    stream->len += len;
+}
+
+// Big endian, the low `bytes` bytes of val
+static void put_uint(WebMStream *stream, uint64_t val, int bytes)
+{
+    unsigned char tmp[8];
+    int i;
+
+    for (i = bytes - 1; i >= 0; i--)
+    {
+        tmp[i] = (unsigned char)val;
+        val >>= 8;
+    }
+
+    put_bytes(stream, tmp, bytes);
+}
+
+static void put_id(WebMStream *stream, unsigned long class_id)
+{
+    if (class_id >= 0x01000000)
+        put_uint(stream, class_id, 4);
+    else if (class_id >= 0x00010000)
+        put_uint(stream, class_id, 3);
+    else if (class_id >= 0x00000100)
+        put_uint(stream, class_id, 2);
+    else
+        put_uint(stream, class_id, 1);
+}
+
+// Element data size in the shortest form that holds it
+static void put_len(WebMStream *stream, uint64_t len)
+{
+    int bytes = 1;
+
+    while (bytes < 8 && len >= (((uint64_t)1 << (7 * bytes)) - 1))
+        bytes++;
+
+    put_uint(stream, len | ((uint64_t)1 << (7 * bytes)), bytes);
+}
+
+// Opens a master element whose size is filled in by end_element(), once its
+// children are in the buffer.
+static unsigned long start_element(WebMStream *stream, unsigned long class_id)
+{
+    unsigned long loc;
+
+    put_id(stream, class_id);
+    loc = stream->len;
+    put_uint(stream, UNKNOWN_LEN, 8);
+    return loc;
+}
+
+static void end_element(WebMStream *stream, unsigned long loc)
+{
+    unsigned long len = stream->len;
+    uint64_t size = len - loc - 8;
+
+    if (stream->error)
+        return;
+
+    stream->len = loc;
+    put_uint(stream, size | LITERALU64(0x0100000000000000), 8);
+    stream->len = len;
+}
+
+static void put_uint_element(WebMStream *stream, unsigned long class_id, uint64_t ui)
+{
+    int bytes = 1;
+
+    while (bytes < 8 && (ui >> (8 * bytes)))
+        bytes++;
+
+    put_id(stream, class_id);
+    put_len(stream, bytes);
+    put_uint(stream, ui, bytes);
+}
+
+static void put_float_element(WebMStream *stream, unsigned long class_id, double d)
+{
+    uint64_t bits;
+
+    memcpy(&bits, &d, sizeof(bits));
+    put_id(stream, class_id);
+    put_len(stream, 8);
+    put_uint(stream, bits, 8);
+}
+
+static void put_string_element(WebMStream *stream, unsigned long class_id, const char *s)
+{
+    unsigned long len = strlen(s);
+
+    put_id(stream, class_id);
+    put_len(stream, len);
+    put_bytes(stream, s, len);
+}
+
+// Hands everything assembled by the current call to the application
+static int flush(WebMStream *stream)
+{
+    if (!stream->error && stream->len)
+    {
+        if (stream->write_fn(stream->user, stream->buf, stream->len))
+            stream->error = -1;
+        else
+            stream->position += stream->len;
+    }
+
+    stream->len = 0;
+    return stream->error;
+}
+
+
+WebMStream *WebMStream_Create(WebMStreamWriteFn write_fn, void *user)
+{
+    WebMStream *stream = calloc(1, sizeof(*stream));
+
+    if (stream)
+    {
+        stream->write_fn = write_fn;
+        stream->user = user;
+    }
+
+    return stream;
+}
+
+int WebMStream_WriteHeader(WebMStream *stream, const char *writing_app,
+                           unsigned int width, unsigned int height,
+                           double frame_rate, uint32_t track_uid)
+{
+    unsigned long start;
+
+    start = start_element(stream, EBML);
+    put_uint_element(stream, EBMLVersion, 1);
+    put_uint_element(stream, EBMLReadVersion, 1);
+    put_uint_element(stream, EBMLMaxIDLength, 4);
+    put_uint_element(stream, EBMLMaxSizeLength, 8);
+    put_string_element(stream, DocType, "webm");
+    put_uint_element(stream, DocTypeVersion, 2);
+    put_uint_element(stream, DocTypeReadVersion, 2);
+    end_element(stream, start);
+
+    // The segment runs to the end of the stream
+    put_id(stream, Segment);
+    put_uint(stream, UNKNOWN_LEN, 8);
+    stream->segment_start = stream->position + stream->len;
+
+    start = start_element(stream, Info);
+    put_uint_element(stream, TimecodeScale, 1000000);
+    put_string_element(stream, MuxingApp, writing_app);
+    put_string_element(stream, WritingApp, writing_app);
+    end_element(stream, start);
+
+    start = start_element(stream, Tracks);
+    {
+        unsigned long entry = start_element(stream, TrackEntry);
+
+        put_uint_element(stream, TrackNumber, 1);
+        put_id(stream, TrackUID);
+        put_len(stream, 4);
+        put_uint(stream, track_uid, 4);
+        put_uint_element(stream, TrackType, 1); //video is always 1
+        put_string_element(stream, CodecID, "V_VP8");
+        {
+            unsigned long video = start_element(stream, Video);
+
+            put_uint_element(stream, PixelWidth, width);
+            put_uint_element(stream, PixelHeight, height);
+            put_float_element(stream, FrameRate, frame_rate);
+            end_element(stream, video);
+        }
+        end_element(stream, entry);
+    }
+    end_element(stream, start);
+
+    return flush(stream);
+}
+
+int WebMStream_WriteBlock(WebMStream *stream, uint64_t pts_ms,
+                          int is_keyframe, int is_invisible,
+                          const unsigned char *data, unsigned long size)
+{
+    unsigned char flags;
+
+    if (stream->have_pts && pts_ms <= stream->last_pts_ms)
+        pts_ms = stream->last_pts_ms + 1;
+
+    stream->last_pts_ms = pts_ms;
+    stream->have_pts = 1;
+
+    if (!stream->cluster_open || is_keyframe
+        || pts_ms - stream->cluster_timecode > SHRT_MAX)
+    {
+        /* Save a cue point if this is a keyframe. */
+        if (is_keyframe)
+        {
+            struct cue_entry *cue_list;
+
+            cue_list = realloc(stream->cue_list,
+                               (stream->cues + 1) * sizeof(*cue_list));
+
+            if (!cue_list)
+                return stream->error = -1;
+
+            stream->cue_list = cue_list;
+            cue_list[stream->cues].time = pts_ms;
+            cue_list[stream->cues].loc = stream->position - stream->segment_start;
+            stream->cues++;
+        }
+
+        // The cluster runs until the next one, or the Cues
+        put_id(stream, Cluster);
+        put_uint(stream, UNKNOWN_LEN, 8);
+        put_uint_element(stream, Timecode, pts_ms);
+        stream->cluster_timecode = pts_ms;
+        stream->cluster_open = 1;
+    }
+
+    put_id(stream, SimpleBlock);
+    put_len(stream, size + 4);
+    put_uint(stream, 0x81, 1); // track number 1
+    put_uint(stream, pts_ms - stream->cluster_timecode, 2);
+
+    flags = 0;
+
+    if (is_keyframe)
+        flags |= 0x80;
+
+    if (is_invisible)
+        flags |= 0x08;
+
+    put_uint(stream, flags, 1);
+    put_bytes(stream, data, size);
+
+    return flush(stream);
+}
+
+int WebMStream_Close(WebMStream *stream, int write_cues)
+{
+    int error;
+
+    if (write_cues && stream->cues)
+    {
+        unsigned long start = start_element(stream, Cues);
+        unsigned int i;
+
+        for (i = 0; i < stream->cues; i++)
+        {
+            unsigned long point = start_element(stream, CuePoint);
+            unsigned long positions;
+
+            put_uint_element(stream, CueTime, stream->cue_list[i].time);
+            positions = start_element(stream, CueTrackPositions);
+            put_uint_element(stream, CueTrack, 1);
+            put_uint_element(stream, CueClusterPosition, stream->cue_list[i].loc);
+            end_element(stream, positions);
+            end_element(stream, point);
+        }
+
+        end_element(stream, start);
+    }
+
+    error = flush(stream);
+
+    free(stream->cue_list);
+    free(stream->buf);
+    free(stream);
+    return error;
+}
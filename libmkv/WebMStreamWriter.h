@@ -0,0 +1,55 @@
+// Copyright (c) 2010 The WebM project authors. All Rights Reserved.
+//
+// Use of this source code is governed by a BSD-style license
+// that can be found in the LICENSE file in the root of the source
+// tree. An additional intellectual property rights grant can be found
+// in the file PATENTS.  All contributing project authors may
+// be found in the AUTHORS file in the root of the source tree.
+
+
+#ifndef WEBMSTREAMWRITER_HPP
+#define WEBMSTREAMWRITER_HPP
+
+// Live WebM muxer for a single VP8 video track.
+//
+// Output never seeks: the Segment and Cluster elements are written with the
+// EBML "unknown size" length, and nothing already written is patched later,
+// so the stream can go to a pipe or socket as it is produced. Element
+// headers are assembled in memory and each call hands its output to the
+// write callback in a single piece. There is no SeekHead or segment
+// Duration. Cues can be appended when the stream is closed, for outputs
+// that are files after all.
+//
+// Unlike EbmlWriter, this does not require the application to provide
+// Ebml_Write()/Ebml_Serialize(), so it can be linked alongside them.
+
+#include "vpx/vpx_integer.h"
+
+typedef struct WebMStream WebMStream;
+
+// Returns 0 on success. A failure is reported back from the call that
+// produced the data, and the stream should then be closed.
+typedef int (*WebMStreamWriteFn)(void *user, const void *buf, unsigned long len);
+
+// Returns NULL if out of memory.
+WebMStream *WebMStream_Create(WebMStreamWriteFn write_fn, void *user);
+
+// Writes the EBML header, the start of the Segment, its Info and the video
+// Tracks. Must be called once, before the first block.
+int WebMStream_WriteHeader(WebMStream *stream, const char *writing_app,
+                           unsigned int width, unsigned int height,
+                           double frame_rate, uint32_t track_uid);
+
+// Writes one frame as a SimpleBlock. A new Cluster is started at every key
+// frame, or when the block's time can not be expressed relative to the
+// current Cluster. Timestamps are in milliseconds and are moved forward if
+// need be to keep them strictly increasing.
+int WebMStream_WriteBlock(WebMStream *stream, uint64_t pts_ms,
+                          int is_keyframe, int is_invisible,
+                          const unsigned char *data, unsigned long size);
+
+// Appends the Cues for the key frame Clusters if write_cues is set, then
+// frees the stream. Returns the status of the write.
+int WebMStream_Close(WebMStream *stream, int write_cues);
+
+#endif
@@ -143,6 +143,21 @@ typedef void (* nestegg_log)(nestegg * context, unsigned int severity, char cons
     @retval -1 Error. */
 int nestegg_init(nestegg ** context, nestegg_io io, nestegg_log callback);
 
+/** Initialize a nestegg context reading from a stream held in memory, such
+    as an mmap'ed file.  Packets returned by #nestegg_read_packet point
+    directly into @a buffer rather than holding a copy, and their storage is
+    recycled by the context.  @a buffer must stay valid and unchanged, and
+    all packets must be freed, before the context is destroyed.  Data
+    returned by #nestegg_packet_data must not be modified.
+    @param context  Storage for the new nestegg context.  @see nestegg_destroy
+    @param buffer   Start of the stream.
+    @param length   Length of the stream in bytes.
+    @param callback Optional logging callback function pointer.  May be NULL.
+    @retval  0 Success.
+    @retval -1 Error. */
+int nestegg_init_mem(nestegg ** context, unsigned char * buffer,
+                     size_t length, nestegg_log callback);
+
 /** Destroy a nestegg context and free associated memory.
     @param context #nestegg context to be freed.  @see nestegg_init */
 void nestegg_destroy(nestegg * context);
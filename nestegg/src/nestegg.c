@@ -281,6 +281,13 @@ struct frame {
   struct frame * next;
 };
 
+/* Stream held in memory by the caller, see nestegg_init_mem */
+struct mem_io {
+  unsigned char * data;
+  size_t length;
+  size_t offset;
+};
+
 /* Public (opaque) Structures */
 struct nestegg {
   nestegg_io * io;
@@ -293,12 +300,18 @@ struct nestegg {
   struct segment segment;
   int64_t segment_offset;
   unsigned int track_count;
+  struct mem_io * mem;
+  nestegg_packet * free_packets;
+  struct frame * free_frames;
 };
 
 struct nestegg_packet {
   uint64_t track;
   uint64_t timecode;
   struct frame * frame;
+  /* Context whose pools the packet returns to when freed, in memory mode */
+  nestegg * ctx;
+  nestegg_packet * next;
 };
 
 /* Element Descriptor */
@@ -1176,6 +1189,41 @@ ne_find_track_entry(nestegg * ctx, unsigned int track)
   return NULL;
 }
 
+static nestegg_packet *
+ne_alloc_packet(nestegg * ctx)
+{
+  nestegg_packet * pkt;
+
+  if (!ctx->mem)
+    return ne_alloc(sizeof(*pkt));
+
+  pkt = ctx->free_packets;
+  if (pkt) {
+    ctx->free_packets = pkt->next;
+    memset(pkt, 0, sizeof(*pkt));
+  } else {
+    pkt = ne_alloc(sizeof(*pkt));
+  }
+  pkt->ctx = ctx;
+
+  return pkt;
+}
+
+static struct frame *
+ne_alloc_frame(nestegg * ctx)
+{
+  struct frame * f;
+
+  if (!ctx->mem || !ctx->free_frames)
+    return ne_alloc(sizeof(*f));
+
+  f = ctx->free_frames;
+  ctx->free_frames = f->next;
+  memset(f, 0, sizeof(*f));
+
+  return f;
+}
+
 static int
 ne_read_block(nestegg * ctx, uint64_t block_id, uint64_t block_size, nestegg_packet ** data)
 {
@@ -1289,7 +1337,7 @@ ne_read_block(nestegg * ctx, uint64_t block_id, uint64_t block_size, nestegg_pac
   if (abs_timecode < 0)
     return -1;
 
-  pkt = ne_alloc(sizeof(*pkt));
+  pkt = ne_alloc_packet(ctx);
   pkt->track = track - 1;
   pkt->timecode = abs_timecode * tc_scale * track_scale;
 
@@ -1302,22 +1350,31 @@ ne_read_block(nestegg * ctx, uint64_t block_id, uint64_t block_size, nestegg_pac
       nestegg_free_packet(pkt);
       return -1;
     }
-    f = ne_alloc(sizeof(*f));
-    f->data = ne_alloc(frame_sizes[i]);
+    f = ne_alloc_frame(ctx);
     f->length = frame_sizes[i];
-    r = ne_io_read(ctx->io, f->data, frame_sizes[i]);
-    if (r != 1) {
-      free(f->data);
-      free(f);
-      nestegg_free_packet(pkt);
-      return -1;
-    }
 
     if (!last)
       pkt->frame = f;
     else
       last->next = f;
     last = f;
+
+    if (ctx->mem) {
+      /* point straight into the caller's copy of the stream */
+      if (frame_sizes[i] > ctx->mem->length - ctx->mem->offset) {
+        nestegg_free_packet(pkt);
+        return -1;
+      }
+      f->data = ctx->mem->data + ctx->mem->offset;
+      ctx->mem->offset += frame_sizes[i];
+    } else {
+      f->data = ne_alloc(frame_sizes[i]);
+      r = ne_io_read(ctx->io, f->data, frame_sizes[i]);
+      if (r != 1) {
+        nestegg_free_packet(pkt);
+        return -1;
+      }
+    }
   }
 
   *data = pkt;
@@ -1407,6 +1464,56 @@ ne_null_log_callback(nestegg * ctx, unsigned int severity, char const * fmt, ...
     return;
 }
 
+static int
+ne_mem_read(void * buffer, size_t length, void * userdata)
+{
+  struct mem_io * mem = userdata;
+
+  if (length > mem->length - mem->offset)
+    return 0;
+
+  memcpy(buffer, mem->data + mem->offset, length);
+  mem->offset += length;
+
+  return 1;
+}
+
+static int
+ne_mem_seek(int64_t offset, int whence, void * userdata)
+{
+  struct mem_io * mem = userdata;
+  int64_t pos;
+
+  switch (whence) {
+  case NESTEGG_SEEK_SET:
+    pos = offset;
+    break;
+  case NESTEGG_SEEK_CUR:
+    pos = mem->offset + offset;
+    break;
+  case NESTEGG_SEEK_END:
+    pos = mem->length + offset;
+    break;
+  default:
+    return -1;
+  }
+
+  if (pos < 0 || (uint64_t) pos > mem->length)
+    return -1;
+
+  mem->offset = pos;
+
+  return 0;
+}
+
+static int64_t
+ne_mem_tell(void * userdata)
+{
+  struct mem_io * mem = userdata;
+
+  return mem->offset;
+}
+
 int
 nestegg_init(nestegg ** context, nestegg_io io, nestegg_log callback)
 {
@@ -1490,12 +1597,49 @@ nestegg_init(nestegg ** context, nestegg_io io, nestegg_log callback)
   return 0;
 }
 
+int
+nestegg_init_mem(nestegg ** context, unsigned char * buffer,
+                 size_t length, nestegg_log callback)
+{
+  struct mem_io * mem;
+  nestegg_io io;
+
+  mem = ne_alloc(sizeof(*mem));
+  mem->data = buffer;
+  mem->length = length;
+
+  io.read = ne_mem_read;
+  io.seek = ne_mem_seek;
+  io.tell = ne_mem_tell;
+  io.userdata = mem;
+
+  if (nestegg_init(context, io, callback) != 0) {
+    free(mem);
+    return -1;
+  }
+
+  (*context)->mem = mem;
+
+  return 0;
+}
+
 void
 nestegg_destroy(nestegg * ctx)
 {
   while (ctx->ancestor)
     ne_ctx_pop(ctx);
   ne_pool_destroy(ctx->alloc_pool);
+  while (ctx->free_packets) {
+    nestegg_packet * pkt = ctx->free_packets;
+    ctx->free_packets = pkt->next;
+    free(pkt);
+  }
+  while (ctx->free_frames) {
+    struct frame * f = ctx->free_frames;
+    ctx->free_frames = f->next;
+    free(f);
+  }
+  free(ctx->mem);
   free(ctx->io);
   free(ctx);
 }
@@ -1874,6 +2018,21 @@ void
 nestegg_free_packet(nestegg_packet * pkt)
 {
   struct frame * frame;
+  nestegg * ctx = pkt->ctx;
+
+  if (ctx) {
+    /* data belongs to the caller's buffer, the structs go back to the pools */
+    while (pkt->frame) {
+      frame = pkt->frame;
+      pkt->frame = frame->next;
+      frame->next = ctx->free_frames;
+      ctx->free_frames = frame;
+    }
+
+    pkt->next = ctx->free_packets;
+    ctx->free_packets = pkt;
+    return;
+  }
 
   while (pkt->frame) {
     frame = pkt->frame;
@@ -12,7 +12,9 @@
 #include "vpx_ports/config.h"
 #include "blockd.h"
 #include "vpx_mem/vpx_mem.h"
+#include "vpx_ports/vpx_once.h"
 #include "onyxc_int.h"
+#include "alloccommon.h"
 #include "findnearmv.h"
 #include "entropymode.h"
 #include "systemdependent.h"
@@ -124,6 +126,32 @@ int vp8_alloc_frame_buffers(VP8_COMMON *oci, int width, int height)
 
     return 0;
 }
+/* Matches the allocation made by vp8_yv12_alloc_frame_buffer() */
+size_t vp8_frame_buffer_bytes(const YV12_BUFFER_CONFIG *ybf)
+{
+    if (!ybf->buffer_alloc)
+        return 0;
+
+    return ybf->frame_size + ybf->y_stride * 2 + 32;
+}
+
+void vp8_common_memory_usage(VP8_COMMON *oci, vp8_memory_usage_t *usage)
+{
+    int i;
+
+    for (i = 0; i < NUM_YV12_BUFFERS; i++)
+        usage->frame_buffers += vp8_frame_buffer_bytes(&oci->yv12_fb[i]);
+
+    usage->frame_buffers += vp8_frame_buffer_bytes(&oci->temp_scale_frame);
+    usage->frame_buffers += vp8_frame_buffer_bytes(&oci->post_proc_buffer);
+
+    if (oci->mip)
+        usage->mode_info += (oci->mb_cols + 1) * (oci->mb_rows + 1) * sizeof(MODE_INFO);
+
+    if (oci->above_context)
+        usage->mode_info += oci->mb_cols * sizeof(ENTROPY_CONTEXT_PLANES);
+}
+
 void vp8_setup_version(VP8_COMMON *cm)
 {
     switch (cm->version)
@@ -190,7 +218,7 @@ void vp8_remove_common(VP8_COMMON *oci)
     vp8_de_alloc_frame_buffers(oci);
 }
 
-void vp8_initialize_common()
+static void initialize_common(void)
 {
     vp8_coef_tree_initialize();
 
@@ -199,3 +227,12 @@ void vp8_initialize_common()
     vp8_init_scan_order_mask();
 
 }
+
+/* The tables built here are read-only once built and shared by every
+ * encoder and decoder instance, so they are built exactly once. */
+void vp8_initialize_common()
+{
+    static vpx_once_t once = VPX_ONCE_INIT;
+
+    vpx_once(&once, initialize_common);
+}
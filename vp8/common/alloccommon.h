@@ -13,11 +13,15 @@
 #define __INC_ALLOCCOMMON_H
 
 #include "onyxc_int.h"
+#include "vpx/vpx_codec.h"
+#include "vpx/vp8.h"
 
 void vp8_create_common(VP8_COMMON *oci);
 void vp8_remove_common(VP8_COMMON *oci);
 void vp8_de_alloc_frame_buffers(VP8_COMMON *oci);
 int vp8_alloc_frame_buffers(VP8_COMMON *oci, int width, int height);
 void vp8_setup_version(VP8_COMMON *oci);
+size_t vp8_frame_buffer_bytes(const YV12_BUFFER_CONFIG *ybf);
+void vp8_common_memory_usage(VP8_COMMON *oci, vp8_memory_usage_t *usage);
 
 #endif
@@ -21,6 +21,8 @@ extern "C"
 #include "vpx_scale/yv12config.h"
 #include "type_aliases.h"
 #include "ppflags.h"
+#include "vpx/vp8.h"
+#include "vpx/vp8cx.h"
     typedef int *VP8_PTR;
 
     /* Create/destroy static data structures. */
@@ -159,6 +161,10 @@ extern "C"
         int allow_df;
         int drop_frames_water_mark;
 
+        // hard cap on the size of each frame in bytes (0 disables). Met by
+        // raising the quantizer within the frame instead of recoding it.
+        int max_frame_size;
+
         // two pass datarate control
         int two_pass_vbrbias;        // two pass datarate control tweaks
         int two_pass_vbrmin_section;
@@ -186,6 +192,10 @@ extern "C"
         int arnr_strength ;
         int arnr_type     ;
 
+        // trade lookahead depth and scratch buffer borders for a smaller
+        // memory footprint
+        int low_memory;
+
 
         struct vpx_fixed_buf         two_pass_stats_in;
         struct vpx_codec_pkt_list  *output_pkt_list;
@@ -196,6 +206,10 @@ extern "C"
 
     VP8_PTR vp8_create_compressor(VP8_CONFIG *oxcf);
     void vp8_remove_compressor(VP8_PTR *comp);
+    // Prepares the compressor to encode a new stream, keeping its buffers
+    // and threads. Returns non-zero if the stream doesn't fit them, or on
+    // error, in which case the compressor must be removed and recreated.
+    int vp8_reset_compressor(VP8_PTR comp, VP8_CONFIG *oxcf);
 
     void vp8_init_config(VP8_PTR onyx, VP8_CONFIG *oxcf);
     void vp8_change_config(VP8_PTR onyx, VP8_CONFIG *oxcf);
@@ -215,6 +229,11 @@ extern "C"
     int vp8_set_active_map(VP8_PTR comp, unsigned char *map, unsigned int rows, unsigned int cols);
     int vp8_set_internal_size(VP8_PTR comp, VPX_SCALING horiz_mode, VPX_SCALING vert_mode);
     int vp8_get_quantizer(VP8_PTR c);
+    void vp8_get_memory_usage(VP8_PTR comp, vp8_memory_usage_t *usage);
+    void vp8_set_frame_stats(VP8_PTR comp, int enable);
+    // Statistics of the last frame returned by vp8_get_compressed_data()
+    void vp8_get_frame_stats(VP8_PTR comp, vp8e_frame_stats_t *stats);
+    void vp8_set_simulcast_parent(VP8_PTR comp, VP8_PTR parent);
 
 #ifdef __cplusplus
 }
@@ -22,6 +22,9 @@ extern "C"
 #include "vpx_scale/yv12config.h"
 #include "ppflags.h"
 #include "vpx_ports/mem.h"
+#include "vpx/vpx_codec.h"
+#include "vpx/vp8.h"
+#include "vpx/vp8dx.h"
 
     typedef void   *VP8D_PTR;
     typedef struct
@@ -60,6 +63,11 @@ extern "C"
 
     void vp8dx_remove_decompressor(VP8D_PTR comp);
 
+    void vp8dx_get_memory_usage(VP8D_PTR comp, vp8_memory_usage_t *usage);
+
+    void vp8dx_set_timing(VP8D_PTR comp, int enable);
+    void vp8dx_get_timing(VP8D_PTR comp, vp8d_timing_t *timing);
+
 #ifdef __cplusplus
 }
 #endif
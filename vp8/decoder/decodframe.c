@@ -34,6 +34,7 @@
 #include "threading.h"
 #include "decoderthreading.h"
 #include "dboolhuff.h"
+#include "vpx_ports/vpx_timer.h"
 
 #include <assert.h>
 #include <stdio.h>
@@ -185,6 +186,15 @@ void vp8_decode_macroblock(VP8D_COMP *pbi, MACROBLOCKD *xd)
     {
         vp8_reset_mb_tokens_context(xd);
     }
+    else if (pbi->timing_enabled)
+    {
+        struct vpx_usec_timer timer;
+
+        vpx_usec_timer_start(&timer);
+        eobtotal = vp8_decode_mb_tokens(pbi, xd);
+        vpx_usec_timer_mark(&timer);
+        pbi->timing.tokens += vpx_usec_timer_elapsed64(&timer);
+    }
     else
     {
         eobtotal = vp8_decode_mb_tokens(pbi, xd);
@@ -566,6 +576,7 @@ int vp8_decode_frame(VP8D_COMP *pbi)
     const unsigned char *data = (const unsigned char *)pbi->Source;
     const unsigned char *const data_end = data + pbi->source_sz;
     ptrdiff_t first_partition_length_in_bytes;
+    struct vpx_usec_timer timer;
 
     int mb_row;
     int i, j, k, l;
@@ -605,8 +616,6 @@ int vp8_decode_frame(VP8D_COMP *pbi)
 
         if (Width != pc->Width  ||  Height != pc->Height)
         {
-            int prev_mb_rows = pc->mb_rows;
-
             if (pc->Width <= 0)
             {
                 pc->Width = Width;
@@ -627,7 +636,7 @@ int vp8_decode_frame(VP8D_COMP *pbi)
 
 #if CONFIG_MULTITHREAD
             if (pbi->b_multithreaded_rd)
-                vp8mt_alloc_temp_buffers(pbi, pc->Width, prev_mb_rows);
+                vp8mt_alloc_temp_buffers(pbi, pc->Width);
 #endif
         }
     }
@@ -848,7 +857,12 @@ int vp8_decode_frame(VP8D_COMP *pbi)
     pc->mb_no_coeff_skip = (int)vp8_read_bit(bc);
 
 
+    vpx_usec_timer_start(&timer);
     vp8_decode_mode_mvs(pbi);
+    vpx_usec_timer_mark(&timer);
+
+    if (pbi->timing_enabled)
+        pbi->timing.modes += vpx_usec_timer_elapsed64(&timer);
 
     vpx_memset(pc->above_context, 0, sizeof(ENTROPY_CONTEXT_PLANES) * pc->mb_cols);
 
@@ -856,7 +870,13 @@ int vp8_decode_frame(VP8D_COMP *pbi)
 
     if (pbi->b_multithreaded_rd && pc->multi_token_partition != ONE_PARTITION)
     {
+        vpx_usec_timer_start(&timer);
         vp8mt_decode_mb_rows(pbi, xd);
+        vpx_usec_timer_mark(&timer);
+
+        if (pbi->timing_enabled)
+            pbi->timing.mt_decode += vpx_usec_timer_elapsed64(&timer);
+
         if(pbi->common.filter_level)
         {
             /*vp8_mt_loop_filter_frame(pbi);*/ /*cm, &pbi->mb, cm->filter_level);*/
@@ -865,12 +885,21 @@ int vp8_decode_frame(VP8D_COMP *pbi)
             pc->last_filter_type = pc->filter_type;
             pc->last_sharpness_level = pc->sharpness_level;
         }
+
+        vpx_usec_timer_start(&timer);
         vp8_yv12_extend_frame_borders_ptr(&pc->yv12_fb[pc->new_fb_idx]);    /*cm->frame_to_show);*/
+        vpx_usec_timer_mark(&timer);
+
+        if (pbi->timing_enabled)
+            pbi->timing.extend += vpx_usec_timer_elapsed64(&timer);
     }
     else
     {
         int ibc = 0;
         int num_part = 1 << pc->multi_token_partition;
+        uint64_t tokens = pbi->timing.tokens;
+
+        vpx_usec_timer_start(&timer);
 
         /* Decode the individual macro block */
         for (mb_row = 0; mb_row < pc->mb_rows; mb_row++)
@@ -887,6 +916,13 @@ int vp8_decode_frame(VP8D_COMP *pbi)
 
             vp8_decode_mb_row(pbi, pc, mb_row, xd);
         }
+
+        vpx_usec_timer_mark(&timer);
+
+        /* Tokens are decoded as the rows are reconstructed */
+        if (pbi->timing_enabled)
+            pbi->timing.recon += vpx_usec_timer_elapsed64(&timer)
+                                 - (pbi->timing.tokens - tokens);
     }
 
 
@@ -29,6 +29,7 @@
 #include "vpx_scale/vpxscale.h"
 #include "systemdependent.h"
 #include "vpx_ports/vpx_timer.h"
+#include "vpx_ports/vpx_once.h"
 #include "detokenize.h"
 #if ARCH_ARM
 #include "vpx_ports/arm.h"
@@ -75,16 +76,17 @@ void vp8_recon_write_yuv_frame(unsigned char *name, YV12_BUFFER_CONFIG *s)
 }
 #endif
 
+static void initialize_dec(void)
+{
+    vp8_initialize_common();
+    vp8_scale_machine_specific_config();
+}
+
 void vp8dx_initialize()
 {
-    static int init_done = 0;
+    static vpx_once_t once = VPX_ONCE_INIT;
 
-    if (!init_done)
-    {
-        vp8_initialize_common();
-        vp8_scale_machine_specific_config();
-        init_done = 1;
-    }
+    vpx_once(&once, initialize_dec);
 }
 
 
@@ -139,6 +141,73 @@ VP8D_PTR vp8dx_create_decompressor(VP8D_CONFIG *oxcf)
 }
 
 
+void vp8dx_get_memory_usage(VP8D_PTR ptr, vp8_memory_usage_t *usage)
+{
+    VP8D_COMP *pbi = (VP8D_COMP *) ptr;
+
+    vpx_memset(usage, 0, sizeof(*usage));
+    vp8_common_memory_usage(&pbi->common, usage);
+
+    usage->context = sizeof(VP8D_COMP);
+
+#if CONFIG_MULTITHREAD
+    vp8mt_memory_usage(pbi, usage);
+#endif
+
+    usage->total = usage->context + usage->frame_buffers + usage->mode_info
+                   + usage->threading;
+}
+
+
+void vp8dx_set_timing(VP8D_PTR ptr, int enable)
+{
+    VP8D_COMP *pbi = (VP8D_COMP *) ptr;
+#if CONFIG_MULTITHREAD
+    int i;
+
+    for (i = 0; i < pbi->allocated_decoding_thread_count; i++)
+    {
+        pbi->mb_row_di[i].time_tokens = 0;
+        pbi->mb_row_di[i].time_busy = 0;
+    }
+#endif
+
+    vpx_memset(&pbi->timing, 0, sizeof(pbi->timing));
+    pbi->timing_enabled = enable;
+}
+
+
+void vp8dx_get_timing(VP8D_PTR ptr, vp8d_timing_t *timing)
+{
+    VP8D_COMP *pbi = (VP8D_COMP *) ptr;
+
+    *timing = pbi->timing;
+    timing->threads = 1;
+
+#if CONFIG_MULTITHREAD
+
+    if (pbi->b_multithreaded_rd)
+    {
+        int i;
+
+        timing->threads += pbi->decoding_thread_count;
+
+        /* The other threads' rows, which count towards recon what isn't
+         * spent on tokens */
+        for (i = 0; i < pbi->allocated_decoding_thread_count; i++)
+        {
+            MB_ROW_DEC *mbrd = &pbi->mb_row_di[i];
+
+            timing->tokens += mbrd->time_tokens;
+            timing->recon += mbrd->time_busy - mbrd->time_tokens;
+            timing->mt_busy += mbrd->time_busy;
+        }
+    }
+
+#endif
+}
+
+
 void vp8dx_remove_decompressor(VP8D_PTR ptr)
 {
     VP8D_COMP *pbi = (VP8D_COMP *) ptr;
@@ -148,7 +217,7 @@ void vp8dx_remove_decompressor(VP8D_PTR ptr)
 
 #if CONFIG_MULTITHREAD
     if (pbi->b_multithreaded_rd)
-        vp8mt_de_alloc_temp_buffers(pbi, pbi->common.mb_rows);
+        vp8mt_de_alloc_temp_buffers(pbi);
 #endif
     vp8_decoder_remove_threads(pbi);
     vp8_remove_common(&pbi->common);
@@ -432,11 +501,24 @@ int vp8dx_receive_compressed_data(VP8D_PTR ptr, unsigned long size, const unsign
             vpx_usec_timer_mark(&lpftimer);
             pbi->time_loop_filtering += vpx_usec_timer_elapsed(&lpftimer);
 
+            if (pbi->timing_enabled)
+                pbi->timing.loop_filter += vpx_usec_timer_elapsed64(&lpftimer);
+
             cm->last_frame_type = cm->frame_type;
             cm->last_filter_type = cm->filter_type;
             cm->last_sharpness_level = cm->sharpness_level;
         }
-        vp8_yv12_extend_frame_borders_ptr(cm->frame_to_show);
+
+        {
+            struct vpx_usec_timer extendtimer;
+
+            vpx_usec_timer_start(&extendtimer);
+            vp8_yv12_extend_frame_borders_ptr(cm->frame_to_show);
+            vpx_usec_timer_mark(&extendtimer);
+
+            if (pbi->timing_enabled)
+                pbi->timing.extend += vpx_usec_timer_elapsed64(&extendtimer);
+        }
     }
 
 #if 0
@@ -453,6 +535,12 @@ int vp8dx_receive_compressed_data(VP8D_PTR ptr, unsigned long size, const unsign
 
     pbi->time_decoding += pbi->decode_microseconds;
 
+    if (pbi->timing_enabled)
+    {
+        pbi->timing.frames++;
+        pbi->timing.decode += vpx_usec_timer_elapsed64(&timer);
+    }
+
     /*vp8_print_modes_and_motion_vectors( cm->mi, cm->mb_rows,cm->mb_cols, cm->current_video_frame);*/
 
     if (cm->show_frame)
@@ -524,7 +612,16 @@ int vp8dx_get_raw_frame(VP8D_PTR ptr, YV12_BUFFER_CONFIG *sd, INT64 *time_stamp,
 
     sd->clrtype = pbi->common.clr_type;
 #if CONFIG_POSTPROC
-    ret = vp8_post_proc_frame(&pbi->common, sd, deblock_level, noise_level, flags);
+    {
+        struct vpx_usec_timer timer;
+
+        vpx_usec_timer_start(&timer);
+        ret = vp8_post_proc_frame(&pbi->common, sd, deblock_level, noise_level, flags);
+        vpx_usec_timer_mark(&timer);
+
+        if (pbi->timing_enabled)
+            pbi->timing.postproc += vpx_usec_timer_elapsed64(&timer);
+    }
 #else
 
     if (pbi->common.frame_to_show)
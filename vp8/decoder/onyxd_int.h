@@ -31,6 +31,10 @@ typedef struct
     int mb_row;
     int current_mb_col;
     short *coef_ptr;
+
+    /* This thread's share of the timing, while it is enabled */
+    uint64_t time_tokens;
+    uint64_t time_busy;
 } MB_ROW_DEC;
 
 typedef struct
@@ -87,6 +91,10 @@ typedef struct VP8Decompressor
     unsigned int time_decoding;
     unsigned int time_loop_filtering;
 
+    /* Per stage timing, collected while timing_enabled is set */
+    int timing_enabled;
+    vp8d_timing_t timing;
+
     volatile int b_multithreaded_rd;
     int max_threads;
     int current_mb_col_main;
@@ -99,12 +107,14 @@ typedef struct VP8Decompressor
     int sync_range;
     int *mt_current_mb_col;                  /* Each row remembers its already decoded column. */
 
-    unsigned char **mt_yabove_row;           /* mb_rows x width */
+    /* Intra prediction context of the rows in flight, indexed by
+     * MT_ROW_CONTEXT() */
+    unsigned char **mt_yabove_row;           /* MT_ROW_CONTEXTS x width */
     unsigned char **mt_uabove_row;
     unsigned char **mt_vabove_row;
-    unsigned char **mt_yleft_col;            /* mb_rows x 16 */
-    unsigned char **mt_uleft_col;            /* mb_rows x 8 */
-    unsigned char **mt_vleft_col;            /* mb_rows x 8 */
+    unsigned char **mt_yleft_col;            /* MT_ROW_CONTEXTS x 16 */
+    unsigned char **mt_uleft_col;            /* MT_ROW_CONTEXTS x 8 */
+    unsigned char **mt_vleft_col;            /* MT_ROW_CONTEXTS x 8 */
 
     MB_ROW_DEC           *mb_row_di;
     DECODETHREAD_DATA    *de_thread_data;
@@ -136,6 +146,13 @@ typedef struct VP8Decompressor
 
 } VP8D_COMP;
 
+/* Rows are handed to the threads in turn and a row only needs its intra
+ * prediction context while it is being decoded, so the context buffers are
+ * shared by rows a thread count apart.
+ */
+#define MT_ROW_CONTEXTS(pbi) ((pbi)->allocated_decoding_thread_count + 1)
+#define MT_ROW_CONTEXT(pbi, mb_row) ((mb_row) % ((pbi)->decoding_thread_count + 1))
+
 int vp8_decode_frame(VP8D_COMP *cpi);
 void vp8_dmachine_specific_config(VP8D_COMP *pbi);
 
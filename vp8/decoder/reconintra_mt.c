@@ -31,8 +31,8 @@ void vp8mt_build_intra_predictors_mby(VP8D_COMP *pbi, MACROBLOCKD *x, int mb_row
 
     if (pbi->common.filter_level)
     {
-        yabove_row = pbi->mt_yabove_row[mb_row] + mb_col*16 +32;
-        yleft_col = pbi->mt_yleft_col[mb_row];
+        yabove_row = pbi->mt_yabove_row[MT_ROW_CONTEXT(pbi, mb_row)] + mb_col*16 +32;
+        yleft_col = pbi->mt_yleft_col[MT_ROW_CONTEXT(pbi, mb_row)];
     } else
     {
         yabove_row = x->dst.y_buffer - x->dst.y_stride;
@@ -169,8 +169,8 @@ void vp8mt_build_intra_predictors_mby_s(VP8D_COMP *pbi, MACROBLOCKD *x, int mb_r
 
     if (pbi->common.filter_level)
     {
-        yabove_row = pbi->mt_yabove_row[mb_row] + mb_col*16 +32;
-        yleft_col = pbi->mt_yleft_col[mb_row];
+        yabove_row = pbi->mt_yabove_row[MT_ROW_CONTEXT(pbi, mb_row)] + mb_col*16 +32;
+        yleft_col = pbi->mt_yleft_col[MT_ROW_CONTEXT(pbi, mb_row)];
     } else
     {
         yabove_row = x->dst.y_buffer - x->dst.y_stride;
@@ -314,10 +314,10 @@ void vp8mt_build_intra_predictors_mbuv(VP8D_COMP *pbi, MACROBLOCKD *x, int mb_ro
 
     if (pbi->common.filter_level)
     {
-        uabove_row = pbi->mt_uabove_row[mb_row] + mb_col*8 +16;
-        vabove_row = pbi->mt_vabove_row[mb_row] + mb_col*8 +16;
-        uleft_col = pbi->mt_uleft_col[mb_row];
-        vleft_col = pbi->mt_vleft_col[mb_row];
+        uabove_row = pbi->mt_uabove_row[MT_ROW_CONTEXT(pbi, mb_row)] + mb_col*8 +16;
+        vabove_row = pbi->mt_vabove_row[MT_ROW_CONTEXT(pbi, mb_row)] + mb_col*8 +16;
+        uleft_col = pbi->mt_uleft_col[MT_ROW_CONTEXT(pbi, mb_row)];
+        vleft_col = pbi->mt_vleft_col[MT_ROW_CONTEXT(pbi, mb_row)];
     } else
     {
         uabove_row = x->dst.u_buffer - x->dst.uv_stride;
@@ -478,10 +478,10 @@ void vp8mt_build_intra_predictors_mbuv_s(VP8D_COMP *pbi, MACROBLOCKD *x, int mb_
 
     if (pbi->common.filter_level)
     {
-        uabove_row = pbi->mt_uabove_row[mb_row] + mb_col*8 +16;
-        vabove_row = pbi->mt_vabove_row[mb_row] + mb_col*8 +16;
-        uleft_col = pbi->mt_uleft_col[mb_row];
-        vleft_col = pbi->mt_vleft_col[mb_row];
+        uabove_row = pbi->mt_uabove_row[MT_ROW_CONTEXT(pbi, mb_row)] + mb_col*8 +16;
+        vabove_row = pbi->mt_vabove_row[MT_ROW_CONTEXT(pbi, mb_row)] + mb_col*8 +16;
+        uleft_col = pbi->mt_uleft_col[MT_ROW_CONTEXT(pbi, mb_row)];
+        vleft_col = pbi->mt_vleft_col[MT_ROW_CONTEXT(pbi, mb_row)];
     } else
     {
         uabove_row = x->dst.u_buffer - x->dst.uv_stride;
@@ -649,14 +649,14 @@ void vp8mt_predict_intra4x4(VP8D_COMP *pbi,
 
     /*Caution: For some b_mode, it needs 8 pixels (4 above + 4 above-right).*/
     if (num < 4 && pbi->common.filter_level)
-        Above = pbi->mt_yabove_row[mb_row] + mb_col*16 + num*4 + 32;
+        Above = pbi->mt_yabove_row[MT_ROW_CONTEXT(pbi, mb_row)] + mb_col*16 + num*4 + 32;
     else
         Above = *(x->base_dst) + x->dst - x->dst_stride;
 
     if (num%4==0 && pbi->common.filter_level)
     {
         for (i=0; i<4; i++)
-            Left[i] = pbi->mt_yleft_col[mb_row][num + i];
+            Left[i] = pbi->mt_yleft_col[MT_ROW_CONTEXT(pbi, mb_row)][num + i];
     }else
     {
         Left[0] = (*(x->base_dst))[x->dst - 1];
@@ -666,7 +666,7 @@ void vp8mt_predict_intra4x4(VP8D_COMP *pbi,
     }
 
     if ((num==4 || num==8 || num==12) && pbi->common.filter_level)
-        top_left = pbi->mt_yleft_col[mb_row][num-1];
+        top_left = pbi->mt_yleft_col[MT_ROW_CONTEXT(pbi, mb_row)][num-1];
     else
         top_left = Above[-1];
 
@@ -959,7 +959,7 @@ void vp8mt_intra_prediction_down_copy(VP8D_COMP *pbi, MACROBLOCKD *x, int mb_row
     unsigned int *dst_ptr2;
 
     if (pbi->common.filter_level)
-        above_right = pbi->mt_yabove_row[mb_row] + mb_col*16 + 32 +16;
+        above_right = pbi->mt_yabove_row[MT_ROW_CONTEXT(pbi, mb_row)] + mb_col*16 + 32 +16;
     else
         above_right = *(x->block[0].base_dst) + x->block[0].dst - x->block[0].dst_stride + 16;
 
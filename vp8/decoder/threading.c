@@ -97,6 +97,53 @@ void vp8_setup_decoding_thread_data(VP8D_COMP *pbi, MACROBLOCKD *xd, MB_ROW_DEC
 }
 
 
+#if CONFIG_MULTITHREAD
+/* A row context is reused by the rows a thread count apart, so each row
+ * starts by putting back the values the first row of the frame sees.
+ */
+static void mt_reset_left_col(VP8D_COMP *pbi, int mb_row)
+{
+    vpx_memset(pbi->mt_yleft_col[MT_ROW_CONTEXT(pbi, mb_row)], (unsigned char)129, 16);
+    vpx_memset(pbi->mt_uleft_col[MT_ROW_CONTEXT(pbi, mb_row)], (unsigned char)129, 8);
+    vpx_memset(pbi->mt_vleft_col[MT_ROW_CONTEXT(pbi, mb_row)], (unsigned char)129, 8);
+}
+
+static void mt_reset_above_left(VP8D_COMP *pbi, int mb_row)
+{
+    pbi->mt_yabove_row[MT_ROW_CONTEXT(pbi, mb_row)][VP8BORDERINPIXELS-1] = 129;
+    pbi->mt_uabove_row[MT_ROW_CONTEXT(pbi, mb_row)][(VP8BORDERINPIXELS>>1)-1] = 129;
+    pbi->mt_vabove_row[MT_ROW_CONTEXT(pbi, mb_row)][(VP8BORDERINPIXELS>>1)-1] = 129;
+}
+
+/* Waits for the row above to be far enough ahead of mb_col, adding the time
+ * spent waiting to *wait while timing is enabled.
+ */
+static void mt_wait_for_row_above(VP8D_COMP *pbi,
+                                  volatile int *last_row_current_mb_col,
+                                  int mb_col, int nsync, uint64_t *wait)
+{
+    VP8_COMMON *pc = &pbi->common;
+    struct vpx_usec_timer timer;
+
+    if (mb_col <= (*last_row_current_mb_col - nsync) || *last_row_current_mb_col == pc->mb_cols - 1)
+        return;
+
+    vpx_usec_timer_start(&timer);
+
+    while (mb_col > (*last_row_current_mb_col - nsync) && *last_row_current_mb_col != pc->mb_cols - 1)
+    {
+        x86_pause_hint();
+        thread_sleep(0);
+    }
+
+    vpx_usec_timer_mark(&timer);
+
+    if (pbi->timing_enabled)
+        *wait += vpx_usec_timer_elapsed64(&timer);
+}
+#endif
+
+
 void vp8mt_decode_macroblock(VP8D_COMP *pbi, MACROBLOCKD *xd, int mb_row, int mb_col)
 {
 #if CONFIG_MULTITHREAD
@@ -108,6 +155,21 @@ void vp8mt_decode_macroblock(VP8D_COMP *pbi, MACROBLOCKD *xd, int mb_row, int mb
     {
         vp8_reset_mb_tokens_context(xd);
     }
+    else if (pbi->timing_enabled)
+    {
+        /* Rows are handed out in turn, the first to the calling thread */
+        int ithread = mb_row % (pbi->decoding_thread_count + 1);
+        struct vpx_usec_timer timer;
+
+        vpx_usec_timer_start(&timer);
+        eobtotal = vp8_decode_mb_tokens(pbi, xd);
+        vpx_usec_timer_mark(&timer);
+
+        if (ithread)
+            pbi->mb_row_di[ithread - 1].time_tokens += vpx_usec_timer_elapsed64(&timer);
+        else
+            pbi->timing.tokens += vpx_usec_timer_elapsed64(&timer);
+    }
     else
     {
         eobtotal = vp8_decode_mb_tokens(pbi, xd);
@@ -258,6 +320,10 @@ THREAD_FUNCTION vp8_thread_decoding_proc(void *p_data)
                 int num_part = 1 << pbi->common.multi_token_partition;
                 volatile int *last_row_current_mb_col;
                 int nsync = pbi->sync_range;
+                struct vpx_usec_timer timer;
+                uint64_t wait = 0;
+
+                vpx_usec_timer_start(&timer);
 
                 for (mb_row = ithread+1; mb_row < pc->mb_rows; mb_row += (pbi->decoding_thread_count + 1))
                 {
@@ -286,6 +352,9 @@ THREAD_FUNCTION vp8_thread_decoding_proc(void *p_data)
                     xd->above_context = pc->above_context;
                     xd->left_context = &mb_row_left_context;
                     vpx_memset(&mb_row_left_context, 0, sizeof(mb_row_left_context));
+
+                    if (pbi->common.filter_level)
+                        mt_reset_left_col(pbi, mb_row);
                     xd->up_available = (mb_row != 0);
 
                     xd->mb_to_top_edge = -((mb_row * 16)) << 3;
@@ -294,13 +363,7 @@ THREAD_FUNCTION vp8_thread_decoding_proc(void *p_data)
                     for (mb_col = 0; mb_col < pc->mb_cols; mb_col++)
                     {
                         if ((mb_col & (nsync-1)) == 0)
-                        {
-                            while (mb_col > (*last_row_current_mb_col - nsync) && *last_row_current_mb_col != pc->mb_cols - 1)
-                            {
-                                x86_pause_hint();
-                                thread_sleep(0);
-                            }
-                        }
+                            mt_wait_for_row_above(pbi, last_row_current_mb_col, mb_col, nsync, &wait);
 
                         if (xd->mode_info_context->mbmi.mode == SPLITMV || xd->mode_info_context->mbmi.mode == B_PRED)
                         {
@@ -355,9 +418,12 @@ THREAD_FUNCTION vp8_thread_decoding_proc(void *p_data)
                             if( mb_row != pc->mb_rows-1 )
                             {
                                 /* Save decoded MB last row data for next-row decoding */
-                                vpx_memcpy((pbi->mt_yabove_row[mb_row + 1] + 32 + mb_col*16), (xd->dst.y_buffer + 15 * recon_y_stride), 16);
-                                vpx_memcpy((pbi->mt_uabove_row[mb_row + 1] + 16 + mb_col*8), (xd->dst.u_buffer + 7 * recon_uv_stride), 8);
-                                vpx_memcpy((pbi->mt_vabove_row[mb_row + 1] + 16 + mb_col*8), (xd->dst.v_buffer + 7 * recon_uv_stride), 8);
+                                if (mb_col == 0)
+                                    mt_reset_above_left(pbi, mb_row + 1);
+
+                                vpx_memcpy((pbi->mt_yabove_row[MT_ROW_CONTEXT(pbi, mb_row + 1)] + 32 + mb_col*16), (xd->dst.y_buffer + 15 * recon_y_stride), 16);
+                                vpx_memcpy((pbi->mt_uabove_row[MT_ROW_CONTEXT(pbi, mb_row + 1)] + 16 + mb_col*8), (xd->dst.u_buffer + 7 * recon_uv_stride), 8);
+                                vpx_memcpy((pbi->mt_vabove_row[MT_ROW_CONTEXT(pbi, mb_row + 1)] + 16 + mb_col*8), (xd->dst.v_buffer + 7 * recon_uv_stride), 8);
                             }
 
                             /* save left_col for next MB decoding */
@@ -368,11 +434,11 @@ THREAD_FUNCTION vp8_thread_decoding_proc(void *p_data)
                                 if (xd->frame_type == KEY_FRAME  ||  next->mbmi.ref_frame == INTRA_FRAME)
                                 {
                                     for (i = 0; i < 16; i++)
-                                        pbi->mt_yleft_col[mb_row][i] = xd->dst.y_buffer [i* recon_y_stride + 15];
+                                        pbi->mt_yleft_col[MT_ROW_CONTEXT(pbi, mb_row)][i] = xd->dst.y_buffer [i* recon_y_stride + 15];
                                     for (i = 0; i < 8; i++)
                                     {
-                                        pbi->mt_uleft_col[mb_row][i] = xd->dst.u_buffer [i* recon_uv_stride + 7];
-                                        pbi->mt_vleft_col[mb_row][i] = xd->dst.v_buffer [i* recon_uv_stride + 7];
+                                        pbi->mt_uleft_col[MT_ROW_CONTEXT(pbi, mb_row)][i] = xd->dst.u_buffer [i* recon_uv_stride + 7];
+                                        pbi->mt_vleft_col[MT_ROW_CONTEXT(pbi, mb_row)][i] = xd->dst.v_buffer [i* recon_uv_stride + 7];
                                     }
                                 }
                             }
@@ -416,9 +482,9 @@ THREAD_FUNCTION vp8_thread_decoding_proc(void *p_data)
 
                             for (i = 0; i < 4; i++)
                             {
-                                pbi->mt_yabove_row[mb_row +1][lasty + i] = pbi->mt_yabove_row[mb_row +1][lasty -1];
-                                pbi->mt_uabove_row[mb_row +1][lastuv + i] = pbi->mt_uabove_row[mb_row +1][lastuv -1];
-                                pbi->mt_vabove_row[mb_row +1][lastuv + i] = pbi->mt_vabove_row[mb_row +1][lastuv -1];
+                                pbi->mt_yabove_row[MT_ROW_CONTEXT(pbi, mb_row + 1)][lasty + i] = pbi->mt_yabove_row[MT_ROW_CONTEXT(pbi, mb_row + 1)][lasty -1];
+                                pbi->mt_uabove_row[MT_ROW_CONTEXT(pbi, mb_row + 1)][lastuv + i] = pbi->mt_uabove_row[MT_ROW_CONTEXT(pbi, mb_row + 1)][lastuv -1];
+                                pbi->mt_vabove_row[MT_ROW_CONTEXT(pbi, mb_row + 1)][lastuv + i] = pbi->mt_vabove_row[MT_ROW_CONTEXT(pbi, mb_row + 1)][lastuv -1];
                             }
                         }
                     } else
@@ -429,6 +495,11 @@ THREAD_FUNCTION vp8_thread_decoding_proc(void *p_data)
                     /* since we have multithread */
                     xd->mode_info_context += xd->mode_info_stride * pbi->decoding_thread_count;
                 }
+
+                vpx_usec_timer_mark(&timer);
+
+                if (pbi->timing_enabled)
+                    mbrd->time_busy += vpx_usec_timer_elapsed64(&timer) - wait;
             }
         }
         /*  add this to each frame */
@@ -490,10 +561,9 @@ void vp8_decoder_create_threads(VP8D_COMP *pbi)
 }
 
 
-void vp8mt_de_alloc_temp_buffers(VP8D_COMP *pbi, int mb_rows)
+void vp8mt_de_alloc_temp_buffers(VP8D_COMP *pbi)
 {
 #if CONFIG_MULTITHREAD
-    VP8_COMMON *const pc = & pbi->common;
     int i;
 
     if (pbi->b_multithreaded_rd)
@@ -507,7 +577,7 @@ void vp8mt_de_alloc_temp_buffers(VP8D_COMP *pbi, int mb_rows)
         /* Free above_row buffers. */
         if (pbi->mt_yabove_row)
         {
-            for (i=0; i< mb_rows; i++)
+            for (i=0; i< MT_ROW_CONTEXTS(pbi); i++)
             {
                 if (pbi->mt_yabove_row[i])
                 {
@@ -521,7 +591,7 @@ void vp8mt_de_alloc_temp_buffers(VP8D_COMP *pbi, int mb_rows)
 
         if (pbi->mt_uabove_row)
         {
-            for (i=0; i< mb_rows; i++)
+            for (i=0; i< MT_ROW_CONTEXTS(pbi); i++)
             {
                 if (pbi->mt_uabove_row[i])
                 {
@@ -535,7 +605,7 @@ void vp8mt_de_alloc_temp_buffers(VP8D_COMP *pbi, int mb_rows)
 
         if (pbi->mt_vabove_row)
         {
-            for (i=0; i< mb_rows; i++)
+            for (i=0; i< MT_ROW_CONTEXTS(pbi); i++)
             {
                 if (pbi->mt_vabove_row[i])
                 {
@@ -550,7 +620,7 @@ void vp8mt_de_alloc_temp_buffers(VP8D_COMP *pbi, int mb_rows)
         /* Free left_col buffers. */
         if (pbi->mt_yleft_col)
         {
-            for (i=0; i< mb_rows; i++)
+            for (i=0; i< MT_ROW_CONTEXTS(pbi); i++)
             {
                 if (pbi->mt_yleft_col[i])
                 {
@@ -564,7 +634,7 @@ void vp8mt_de_alloc_temp_buffers(VP8D_COMP *pbi, int mb_rows)
 
         if (pbi->mt_uleft_col)
         {
-            for (i=0; i< mb_rows; i++)
+            for (i=0; i< MT_ROW_CONTEXTS(pbi); i++)
             {
                 if (pbi->mt_uleft_col[i])
                 {
@@ -578,7 +648,7 @@ void vp8mt_de_alloc_temp_buffers(VP8D_COMP *pbi, int mb_rows)
 
         if (pbi->mt_vleft_col)
         {
-            for (i=0; i< mb_rows; i++)
+            for (i=0; i< MT_ROW_CONTEXTS(pbi); i++)
             {
                 if (pbi->mt_vleft_col[i])
                 {
@@ -596,7 +666,7 @@ void vp8mt_de_alloc_temp_buffers(VP8D_COMP *pbi, int mb_rows)
 }
 
 
-int vp8mt_alloc_temp_buffers(VP8D_COMP *pbi, int width, int prev_mb_rows)
+int vp8mt_alloc_temp_buffers(VP8D_COMP *pbi, int width)
 {
 #if CONFIG_MULTITHREAD
     VP8_COMMON *const pc = & pbi->common;
@@ -605,7 +675,7 @@ int vp8mt_alloc_temp_buffers(VP8D_COMP *pbi, int width, int prev_mb_rows)
 
     if (pbi->b_multithreaded_rd)
     {
-        vp8mt_de_alloc_temp_buffers(pbi, prev_mb_rows);
+        vp8mt_de_alloc_temp_buffers(pbi);
 
         /* our internal buffers are always multiples of 16 */
         if ((width & 0xf) != 0)
@@ -621,30 +691,30 @@ int vp8mt_alloc_temp_buffers(VP8D_COMP *pbi, int width, int prev_mb_rows)
         /* Allocate an int for each mb row. */
         CHECK_MEM_ERROR(pbi->mt_current_mb_col, vpx_malloc(sizeof(int) * pc->mb_rows));
 
-        /* Allocate memory for above_row buffers. */
-        CHECK_MEM_ERROR(pbi->mt_yabove_row, vpx_malloc(sizeof(unsigned char *) * pc->mb_rows));
-        for (i=0; i< pc->mb_rows; i++)
+        /* Allocate memory for above_row buffers, one per row in flight. */
+        CHECK_MEM_ERROR(pbi->mt_yabove_row, vpx_malloc(sizeof(unsigned char *) * MT_ROW_CONTEXTS(pbi)));
+        for (i=0; i< MT_ROW_CONTEXTS(pbi); i++)
             CHECK_MEM_ERROR(pbi->mt_yabove_row[i], vpx_calloc(sizeof(unsigned char) * (width + (VP8BORDERINPIXELS<<1)), 1));
 
-        CHECK_MEM_ERROR(pbi->mt_uabove_row, vpx_malloc(sizeof(unsigned char *) * pc->mb_rows));
-        for (i=0; i< pc->mb_rows; i++)
+        CHECK_MEM_ERROR(pbi->mt_uabove_row, vpx_malloc(sizeof(unsigned char *) * MT_ROW_CONTEXTS(pbi)));
+        for (i=0; i< MT_ROW_CONTEXTS(pbi); i++)
             CHECK_MEM_ERROR(pbi->mt_uabove_row[i], vpx_calloc(sizeof(unsigned char) * (uv_width + VP8BORDERINPIXELS), 1));
 
-        CHECK_MEM_ERROR(pbi->mt_vabove_row, vpx_malloc(sizeof(unsigned char *) * pc->mb_rows));
-        for (i=0; i< pc->mb_rows; i++)
+        CHECK_MEM_ERROR(pbi->mt_vabove_row, vpx_malloc(sizeof(unsigned char *) * MT_ROW_CONTEXTS(pbi)));
+        for (i=0; i< MT_ROW_CONTEXTS(pbi); i++)
             CHECK_MEM_ERROR(pbi->mt_vabove_row[i], vpx_calloc(sizeof(unsigned char) * (uv_width + VP8BORDERINPIXELS), 1));
 
         /* Allocate memory for left_col buffers. */
-        CHECK_MEM_ERROR(pbi->mt_yleft_col, vpx_malloc(sizeof(unsigned char *) * pc->mb_rows));
-        for (i=0; i< pc->mb_rows; i++)
+        CHECK_MEM_ERROR(pbi->mt_yleft_col, vpx_malloc(sizeof(unsigned char *) * MT_ROW_CONTEXTS(pbi)));
+        for (i=0; i< MT_ROW_CONTEXTS(pbi); i++)
             CHECK_MEM_ERROR(pbi->mt_yleft_col[i], vpx_calloc(sizeof(unsigned char) * 16, 1));
 
-        CHECK_MEM_ERROR(pbi->mt_uleft_col, vpx_malloc(sizeof(unsigned char *) * pc->mb_rows));
-        for (i=0; i< pc->mb_rows; i++)
+        CHECK_MEM_ERROR(pbi->mt_uleft_col, vpx_malloc(sizeof(unsigned char *) * MT_ROW_CONTEXTS(pbi)));
+        for (i=0; i< MT_ROW_CONTEXTS(pbi); i++)
             CHECK_MEM_ERROR(pbi->mt_uleft_col[i], vpx_calloc(sizeof(unsigned char) * 8, 1));
 
-        CHECK_MEM_ERROR(pbi->mt_vleft_col, vpx_malloc(sizeof(unsigned char *) * pc->mb_rows));
-        for (i=0; i< pc->mb_rows; i++)
+        CHECK_MEM_ERROR(pbi->mt_vleft_col, vpx_malloc(sizeof(unsigned char *) * MT_ROW_CONTEXTS(pbi)));
+        for (i=0; i< MT_ROW_CONTEXTS(pbi); i++)
             CHECK_MEM_ERROR(pbi->mt_vleft_col[i], vpx_calloc(sizeof(unsigned char) * 8, 1));
     }
     return 0;
@@ -655,6 +725,34 @@ int vp8mt_alloc_temp_buffers(VP8D_COMP *pbi, int width, int prev_mb_rows)
 }
 
 
+void vp8mt_memory_usage(VP8D_COMP *pbi, vp8_memory_usage_t *usage)
+{
+#if CONFIG_MULTITHREAD
+    int width = (pbi->common.Width + 15) & ~15;
+
+    if (!pbi->b_multithreaded_rd)
+        return;
+
+    usage->threading += pbi->allocated_decoding_thread_count
+                        * (sizeof(pthread_t) + sizeof(sem_t)
+                           + sizeof(MB_ROW_DEC) + sizeof(DECODETHREAD_DATA));
+
+    if (pbi->mt_current_mb_col)
+        usage->threading += pbi->common.mb_rows * sizeof(int);
+
+    if (pbi->mt_yabove_row)
+        usage->threading += MT_ROW_CONTEXTS(pbi)
+                            * (6 * sizeof(unsigned char *)
+                               + width + (VP8BORDERINPIXELS << 1)
+                               + 2 * ((width >> 1) + VP8BORDERINPIXELS)
+                               + 16 + 8 + 8);
+#else
+    (void) pbi;
+    (void) usage;
+#endif
+}
+
+
 void vp8_decoder_remove_threads(VP8D_COMP *pbi)
 {
 #if CONFIG_MULTITHREAD
@@ -778,6 +876,9 @@ void vp8mt_decode_mb_rows( VP8D_COMP *pbi, MACROBLOCKD *xd)
     loop_filter_info *lfi = pc->lf_info;
     int alt_flt_enabled = xd->segmentation_enabled;
     int Segment;
+    struct vpx_usec_timer timer;
+    uint64_t wait = 0;
+    uint64_t tokens = pbi->timing.tokens;
 
     if(pbi->common.filter_level)
     {
@@ -786,20 +887,13 @@ void vp8mt_decode_mb_rows( VP8D_COMP *pbi, MACROBLOCKD *xd)
         vpx_memset(pbi->mt_uabove_row[0] + (VP8BORDERINPIXELS>>1)-1, 127, (pc->yv12_fb[pc->lst_fb_idx].y_width>>1) +5);
         vpx_memset(pbi->mt_vabove_row[0] + (VP8BORDERINPIXELS>>1)-1, 127, (pc->yv12_fb[pc->lst_fb_idx].y_width>>1) +5);
 
-        for (i=1; i<pc->mb_rows; i++)
+        for (i=1; i<MT_ROW_CONTEXTS(pbi); i++)
         {
             vpx_memset(pbi->mt_yabove_row[i] + VP8BORDERINPIXELS-1, (unsigned char)129, 1);
             vpx_memset(pbi->mt_uabove_row[i] + (VP8BORDERINPIXELS>>1)-1, (unsigned char)129, 1);
             vpx_memset(pbi->mt_vabove_row[i] + (VP8BORDERINPIXELS>>1)-1, (unsigned char)129, 1);
         }
 
-        /* Set left_col to 129 initially */
-        for (i=0; i<pc->mb_rows; i++)
-        {
-            vpx_memset(pbi->mt_yleft_col[i], (unsigned char)129, 16);
-            vpx_memset(pbi->mt_uleft_col[i], (unsigned char)129, 8);
-            vpx_memset(pbi->mt_vleft_col[i], (unsigned char)129, 8);
-        }
         vp8mt_lpf_init(pbi, pc->filter_level);
     }
 
@@ -808,6 +902,8 @@ void vp8mt_decode_mb_rows( VP8D_COMP *pbi, MACROBLOCKD *xd)
     for (i = 0; i < pbi->decoding_thread_count; i++)
         sem_post(&pbi->h_event_start_decoding[i]);
 
+    vpx_usec_timer_start(&timer);
+
     for (mb_row = 0; mb_row < pc->mb_rows; mb_row += (pbi->decoding_thread_count + 1))
     {
         int i;
@@ -829,6 +925,10 @@ void vp8mt_decode_mb_rows( VP8D_COMP *pbi, MACROBLOCKD *xd)
                 last_row_current_mb_col = &pbi->mt_current_mb_col[mb_row -1];
 
             vpx_memset(&pc->left_context, 0, sizeof(pc->left_context));
+
+            if (pbi->common.filter_level)
+                mt_reset_left_col(pbi, mb_row);
+
             recon_yoffset = mb_row * recon_y_stride * 16;
             recon_uvoffset = mb_row * recon_uv_stride * 8;
             /* reset above block coeffs */
@@ -841,13 +941,8 @@ void vp8mt_decode_mb_rows( VP8D_COMP *pbi, MACROBLOCKD *xd)
 
             for (mb_col = 0; mb_col < pc->mb_cols; mb_col++)
             {
-                if ( mb_row > 0 && (mb_col & (nsync-1)) == 0){
-                    while (mb_col > (*last_row_current_mb_col - nsync) && *last_row_current_mb_col != pc->mb_cols - 1)
-                    {
-                        x86_pause_hint();
-                        thread_sleep(0);
-                    }
-                }
+                if ( mb_row > 0 && (mb_col & (nsync-1)) == 0)
+                    mt_wait_for_row_above(pbi, last_row_current_mb_col, mb_col, nsync, &wait);
 
                 if (xd->mode_info_context->mbmi.mode == SPLITMV || xd->mode_info_context->mbmi.mode == B_PRED)
                 {
@@ -902,9 +997,12 @@ void vp8mt_decode_mb_rows( VP8D_COMP *pbi, MACROBLOCKD *xd)
                     /* Save decoded MB last row data for next-row decoding */
                     if(mb_row != pc->mb_rows-1)
                     {
-                        vpx_memcpy((pbi->mt_yabove_row[mb_row +1] + 32 + mb_col*16), (xd->dst.y_buffer + 15 * recon_y_stride), 16);
-                        vpx_memcpy((pbi->mt_uabove_row[mb_row +1] + 16 + mb_col*8), (xd->dst.u_buffer + 7 * recon_uv_stride), 8);
-                        vpx_memcpy((pbi->mt_vabove_row[mb_row +1] + 16 + mb_col*8), (xd->dst.v_buffer + 7 * recon_uv_stride), 8);
+                        if (mb_col == 0)
+                            mt_reset_above_left(pbi, mb_row + 1);
+
+                        vpx_memcpy((pbi->mt_yabove_row[MT_ROW_CONTEXT(pbi, mb_row + 1)] + 32 + mb_col*16), (xd->dst.y_buffer + 15 * recon_y_stride), 16);
+                        vpx_memcpy((pbi->mt_uabove_row[MT_ROW_CONTEXT(pbi, mb_row + 1)] + 16 + mb_col*8), (xd->dst.u_buffer + 7 * recon_uv_stride), 8);
+                        vpx_memcpy((pbi->mt_vabove_row[MT_ROW_CONTEXT(pbi, mb_row + 1)] + 16 + mb_col*8), (xd->dst.v_buffer + 7 * recon_uv_stride), 8);
                     }
 
                     /* save left_col for next MB decoding */
@@ -915,11 +1013,11 @@ void vp8mt_decode_mb_rows( VP8D_COMP *pbi, MACROBLOCKD *xd)
                         if (xd->frame_type == KEY_FRAME  ||  next->mbmi.ref_frame == INTRA_FRAME)
                         {
                             for (i = 0; i < 16; i++)
-                                pbi->mt_yleft_col[mb_row][i] = xd->dst.y_buffer [i* recon_y_stride + 15];
+                                pbi->mt_yleft_col[MT_ROW_CONTEXT(pbi, mb_row)][i] = xd->dst.y_buffer [i* recon_y_stride + 15];
                             for (i = 0; i < 8; i++)
                             {
-                                pbi->mt_uleft_col[mb_row][i] = xd->dst.u_buffer [i* recon_uv_stride + 7];
-                                pbi->mt_vleft_col[mb_row][i] = xd->dst.v_buffer [i* recon_uv_stride + 7];
+                                pbi->mt_uleft_col[MT_ROW_CONTEXT(pbi, mb_row)][i] = xd->dst.u_buffer [i* recon_uv_stride + 7];
+                                pbi->mt_vleft_col[MT_ROW_CONTEXT(pbi, mb_row)][i] = xd->dst.v_buffer [i* recon_uv_stride + 7];
                             }
                         }
                     }
@@ -962,9 +1060,9 @@ void vp8mt_decode_mb_rows( VP8D_COMP *pbi, MACROBLOCKD *xd)
 
                     for (i = 0; i < 4; i++)
                     {
-                        pbi->mt_yabove_row[mb_row +1][lasty + i] = pbi->mt_yabove_row[mb_row +1][lasty -1];
-                        pbi->mt_uabove_row[mb_row +1][lastuv + i] = pbi->mt_uabove_row[mb_row +1][lastuv -1];
-                        pbi->mt_vabove_row[mb_row +1][lastuv + i] = pbi->mt_vabove_row[mb_row +1][lastuv -1];
+                        pbi->mt_yabove_row[MT_ROW_CONTEXT(pbi, mb_row + 1)][lasty + i] = pbi->mt_yabove_row[MT_ROW_CONTEXT(pbi, mb_row + 1)][lasty -1];
+                        pbi->mt_uabove_row[MT_ROW_CONTEXT(pbi, mb_row + 1)][lastuv + i] = pbi->mt_uabove_row[MT_ROW_CONTEXT(pbi, mb_row + 1)][lastuv -1];
+                        pbi->mt_vabove_row[MT_ROW_CONTEXT(pbi, mb_row + 1)][lastuv + i] = pbi->mt_vabove_row[MT_ROW_CONTEXT(pbi, mb_row + 1)][lastuv -1];
                     }
                 }
             }else
@@ -975,6 +1073,17 @@ void vp8mt_decode_mb_rows( VP8D_COMP *pbi, MACROBLOCKD *xd)
         xd->mode_info_context += xd->mode_info_stride * pbi->decoding_thread_count;
     }
 
+    vpx_usec_timer_mark(&timer);
+
+    /* This thread's rows; the others' are added in by vp8dx_get_timing() */
+    if (pbi->timing_enabled)
+    {
+        uint64_t busy = vpx_usec_timer_elapsed64(&timer) - wait;
+
+        pbi->timing.mt_busy += busy;
+        pbi->timing.recon += busy - (pbi->timing.tokens - tokens);
+    }
+
     sem_wait(&pbi->h_event_end_decoding);   /* add back for each frame */
 #else
     (void) pbi;
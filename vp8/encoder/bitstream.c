@@ -1128,6 +1128,14 @@ static void write_kfmodes(VP8_COMP *cpi)
         m++;    // skip L prediction border
     }
 }
+/* Cost of signalling a coefficient probability update: the 8 bit literal
+ * plus the difference between the update and no-update flags.
+ */
+static __inline int update_bits(vp8_prob upd)
+{
+    return 8 + ((vp8_cost_one(upd) - vp8_cost_zero(upd)) >> 8);
+}
+
 int vp8_estimate_entropy_savings(VP8_COMP *cpi)
 {
     int i = 0;
@@ -1201,43 +1209,64 @@ int vp8_estimate_entropy_savings(VP8_COMP *cpi)
             do
             {
                 /* at every context */
+                const unsigned int *counts = cpi->coef_counts [i][j][k];
+                unsigned char *update = cpi->coef_prob_update [i][j][k];
+                int t = 0;      /* token/prob index */
 
-                /* calc probs and branch cts for this frame only */
-                //vp8_prob new_p           [vp8_coef_tokens-1];
-                //unsigned int branch_ct   [vp8_coef_tokens-1] [2];
+                /* A context with no tokens this frame costs nothing with
+                 * either probability, so an update can only be paid for
+                 * and its new probabilities are all one half.
+                 */
+                while (t < vp8_coef_tokens && !counts[t])
+                    t++;
 
-                int t = 0;      /* token/prob index */
+                if (t == vp8_coef_tokens)
+                {
+                    t = 0;
+
+                    do
+                    {
+                        const int s = -update_bits(vp8_coef_update_probs [i][j][k][t]);
 
+                        update[t] = s > 0;
+
+                        if (s > 0)
+                        {
+                            cpi->frame_coef_probs [i][j][k][t] = vp8_prob_half;
+                            savings += s;
+                        }
+                    }
+                    while (++t < vp8_coef_tokens - 1);
+
+                    continue;
+                }
+
+                /* calc probs and branch cts for this frame only */
                 vp8_tree_probs_from_distribution(
                     vp8_coef_tokens, vp8_coef_encodings, vp8_coef_tree,
                     cpi->frame_coef_probs [i][j][k], cpi->frame_branch_ct [i][j][k], cpi->coef_counts [i][j][k],
                     256, 1
                 );
 
+                t = 0;
+
                 do
                 {
                     const unsigned int *ct  = cpi->frame_branch_ct [i][j][k][t];
                     const vp8_prob newp = cpi->frame_coef_probs [i][j][k][t];
-
                     const vp8_prob old = cpi->common.fc.coef_probs [i][j][k][t];
-                    const vp8_prob upd = vp8_coef_update_probs [i][j][k][t];
-
-                    const int old_b = vp8_cost_branch(ct, old);
-                    const int new_b = vp8_cost_branch(ct, newp);
+                    int s = -update_bits(vp8_coef_update_probs [i][j][k][t]);
 
-                    const int update_b = 8 +
-                                         ((vp8_cost_one(upd) - vp8_cost_zero(upd)) >> 8);
+                    /* Nothing to gain when the probability is unchanged */
+                    if (newp != old)
+                        s += vp8_cost_branch(ct, old) - vp8_cost_branch(ct, newp);
 
-                    const int s = old_b - new_b - update_b;
+                    update[t] = s > 0;
 
                     if (s > 0)
                         savings += s;
-
-
                 }
                 while (++t < vp8_coef_tokens - 1);
-
-
             }
             while (++k < PREV_COEF_CONTEXTS);
         }
@@ -1252,7 +1281,6 @@ static void update_coef_probs(VP8_COMP *cpi)
 {
     int i = 0;
     vp8_writer *const w = & cpi->bc;
-    int savings = 0;
 
     vp8_clear_system_state(); //__asm emms;
 
@@ -1267,40 +1295,16 @@ static void update_coef_probs(VP8_COMP *cpi)
 
             do
             {
-                //note: use result from vp8_estimate_entropy_savings, so no need to call vp8_tree_probs_from_distribution here.
+                //note: use the decisions made by vp8_estimate_entropy_savings, so no need to recost the branches here.
                 /* at every context */
-
-                /* calc probs and branch cts for this frame only */
-                //vp8_prob new_p           [vp8_coef_tokens-1];
-                //unsigned int branch_ct   [vp8_coef_tokens-1] [2];
-
+                const unsigned char *update = cpi->coef_prob_update [i][j][k];
                 int t = 0;      /* token/prob index */
 
-                //vp8_tree_probs_from_distribution(
-                //    vp8_coef_tokens, vp8_coef_encodings, vp8_coef_tree,
-                //    new_p, branch_ct, (unsigned int *)cpi->coef_counts [i][j][k],
-                //    256, 1
-                //    );
-
                 do
                 {
-                    const unsigned int *ct  = cpi->frame_branch_ct [i][j][k][t];
-                    const vp8_prob newp = cpi->frame_coef_probs [i][j][k][t];
-
-                    vp8_prob *Pold = cpi->common.fc.coef_probs [i][j][k] + t;
-                    const vp8_prob old = *Pold;
-                    const vp8_prob upd = vp8_coef_update_probs [i][j][k][t];
-
-                    const int old_b = vp8_cost_branch(ct, old);
-                    const int new_b = vp8_cost_branch(ct, newp);
+                    const int u = update[t];
 
-                    const int update_b = 8 +
-                                         ((vp8_cost_one(upd) - vp8_cost_zero(upd)) >> 8);
-
-                    const int s = old_b - new_b - update_b;
-                    const int u = s > 0 ? 1 : 0;
-
-                    vp8_write(w, u, upd);
+                    vp8_write(w, u, vp8_coef_update_probs [i][j][k][t]);
 
 
 #ifdef ENTROPY_STATS
@@ -1310,12 +1314,10 @@ static void update_coef_probs(VP8_COMP *cpi)
                     if (u)
                     {
                         /* send/use new probability */
+                        const vp8_prob newp = cpi->frame_coef_probs [i][j][k][t];
 
-                        *Pold = newp;
+                        cpi->common.fc.coef_probs [i][j][k][t] = newp;
                         vp8_write_literal(w, newp, 8);
-
-                        savings += s;
-
                     }
 
                 }
@@ -17,6 +17,7 @@
 #include "entropymv.h"
 #include "entropy.h"
 #include "vpx_ports/mem.h"
+#include "vpx_ports/vpx_timer.h"
 
 // motion search site
 typedef struct
@@ -25,6 +26,16 @@ typedef struct
     int offset;
 } search_site;
 
+// Per MB statistics gathered from the source before the frame is coded
+typedef struct
+{
+    unsigned int variance;      // Luma variance (sum of squared deviations from the mean)
+    unsigned int zero_mv_sse;   // Luma SSE against the last frame at zero motion
+    unsigned int zero_mv_var;   // Variance of the same zero motion residual
+    unsigned int edge_energy;   // Sum of absolute horizontal and vertical luma gradients
+    unsigned char dc;           // Mean luma value
+} MB_ANALYSIS;
+
 typedef struct
 {
     // 16 Y blocks, 4 U blocks, 4 V blocks each with 16 entries
@@ -84,7 +95,6 @@ typedef struct
 
     int mvcosts[2][MVvals+1];
     int *mvcost[2];
-    int mvsadcosts[2][MVvals+1];
     int *mvsadcost[2];
     int mbmode_cost[2][MB_MODE_COUNT];
     int intra_uv_mode_cost[2][MB_MODE_COUNT];
@@ -106,16 +116,28 @@ typedef struct
     signed char *gf_active_ptr;
 
     unsigned char *active_ptr;
+    MB_ANALYSIS *mb_analysis;
     MV_CONTEXT *mvc;
 
     unsigned int token_costs[BLOCK_TYPES] [COEF_BANDS] [PREV_COEF_CONTEXTS] [vp8_coef_tokens];
     int optimize;
+    int fast_optimize;    // Trellis skips single coefficient blocks and prunes unlikely roundings
 
     void (*vp8_short_fdct4x4)(short *input, short *output, int pitch);
     void (*vp8_short_fdct8x4)(short *input, short *output, int pitch);
     void (*short_walsh4x4)(short *input, short *output, int pitch);
     void (*quantize_b)(BLOCK *b, BLOCKD *d);
 
+    // Frame statistics, kept per thread and gathered by vp8_encode_frame()
+    int collect_stats;
+    struct vpx_usec_timer stats_timer;    // Started at each MB, advanced by vp8_mb_stats_mark()
+    unsigned int time_motion_search;
+    unsigned int time_mode_decision;
+    unsigned int time_transform;
+    unsigned int time_tokenize;
+    unsigned int mode_count[MB_MODE_COUNT];
+    unsigned int skip_count;
+
 } MACROBLOCK;
 
 
@@ -41,11 +41,13 @@ extern void vp8_stuff_mb(VP8_COMP *cpi, MACROBLOCKD *x, TOKENEXTRA **t) ;
 
 extern void vp8cx_initialize_me_consts(VP8_COMP *cpi, int QIndex);
 extern void vp8_auto_select_speed(VP8_COMP *cpi);
+extern void vp8_raise_speed_in_frame(VP8_COMP *cpi, int speed);
 extern void vp8cx_init_mbrthread_data(VP8_COMP *cpi,
                                       MACROBLOCK *x,
                                       MB_ROW_COMP *mbr_ei,
                                       int mb_row,
                                       int count);
+extern const int vp8_bits_per_mb[2][QINDEX_RANGE];
 void vp8_build_block_offsets(MACROBLOCK *x);
 void vp8_setup_block_ptrs(MACROBLOCK *x);
 int vp8cx_encode_inter_macroblock(VP8_COMP *cpi, MACROBLOCK *x, TOKENEXTRA **t, int recon_yoffset, int recon_uvoffset);
@@ -441,6 +443,7 @@ void encode_mb_row(VP8_COMP *cpi,
             xd->mode_info_context->mbmi.segment_id = 0;         // Set to Segment 0 by default
 
         x->active_ptr = cpi->active_map + seg_map_index + mb_col;
+        x->mb_analysis = cpi->mb_analysis + seg_map_index + mb_col;
 
         if (cm->frame_type == KEY_FRAME)
         {
@@ -475,7 +478,7 @@ void encode_mb_row(VP8_COMP *cpi,
             // Special case code for cyclic refresh
             // If cyclic update enabled then copy xd->mbmi.segment_id; (which may have been updated based on mode
             // during vp8cx_encode_inter_macroblock()) back into the global sgmentation map
-            if (cpi->cyclic_refresh_mode_enabled && xd->segmentation_enabled)
+            if (cpi->cyclic_refresh_mode_enabled && !cpi->row_rc_active && xd->segmentation_enabled)
             {
                 cpi->segmentation_map[seg_map_index+mb_col] = xd->mode_info_context->mbmi.segment_id;
 
@@ -535,7 +538,186 @@ void encode_mb_row(VP8_COMP *cpi,
 
 
 
+// Estimate the cost (in 1/256 bit units) of the tokens produced for an MB
+// row, walking its token list the same way they are packed.
+static int cost_row_tokens(VP8_COMP *cpi, int mb_row)
+{
+    const TOKENEXTRA *p = cpi->tplist[mb_row].start;
+    const TOKENEXTRA *const stop = cpi->tplist[mb_row].stop;
+    int cost = 0;
+
+    while (p < stop)
+    {
+        const int t = p->Token;
+        const vp8_token *const a = vp8_coef_encodings + t;
+        const vp8_extra_bit_struct *const b = vp8_extra_bits + t;
+        const vp8_prob *const pp = p->context_tree;
+        int v = a->value;
+        int n = a->Len;
+        int i = 0;
+
+        if (p->skip_eob_node)
+        {
+            n--;
+            i = 2;
+        }
+
+        do
+        {
+            const int bb = (v >> --n) & 1;
+            cost += vp8_cost_bit(pp[i>>1], bb);
+            i = vp8_coef_tree[i+bb];
+        }
+        while (n);
+
+        if (b->base_val)
+        {
+            if (b->Len)
+                cost += vp8_treed_cost(b->tree, b->prob, p->Extra >> 1, b->Len);
+
+            cost += vp8_cost_bit(128, p->Extra & 1);
+        }
+
+        ++p;
+    }
+
+    return cost;
+}
+
+static int cost_frame_tokens(VP8_COMP *cpi)
+{
+    int mb_row;
+    int cost = 0;
+
+    for (mb_row = 0; mb_row < cpi->common.mb_rows; mb_row++)
+        cost += cost_row_tokens(cpi, mb_row);
+
+    return cost;
+}
+
+// In frame rate control for a frame size cap. Accounts for the MB rows
+// coded since the last call, then picks the segment (and so the quantizer)
+// for the next 'rows' rows starting at mb_row: the lowest Q segment whose
+// projected cost for all the remaining rows fits what is left of the
+// budget. The rows coded so far, scaled to the frame Q, give the expected
+// cost of a row, along with one row at the cost expected when the frame
+// was set up so the first rows are not left to a guess.
+static void row_rate_control(VP8_COMP *cpi, int mb_row, int rows)
+{
+    VP8_COMMON *const cm = &cpi->common;
+    const int *const bpm = vp8_bits_per_mb[cm->frame_type];
+    const int base_q = cpi->row_rc_q[0];
+    int segment = 0;
+
+    while (cpi->row_rc_rows_done < mb_row)
+    {
+        const int r = cpi->row_rc_rows_done++;
+        const int q = cpi->row_rc_q[cpi->segmentation_map[r * cm->mb_cols]];
+        const int token_bits = cost_row_tokens(cpi, r) >> 8;
+        const int bits = token_bits + ((cpi->row_rc_mode_rate[cm->frame_type] * cm->mb_cols) >> 8);
+
+        cpi->row_rc_token_bits += token_bits;
+        cpi->row_rc_spent += bits;
+        cpi->row_rc_base_spent += (double)bits * bpm[base_q] / bpm[q];
+    }
 
+    if (mb_row >= cm->mb_rows)
+        return;
+
+    {
+        const double row_bits = (cpi->row_rc_base_spent + cpi->row_rc_row_bits) / (mb_row + 1);
+        const double remaining = (double)(cpi->row_rc_budget - cpi->row_rc_spent) / (cm->mb_rows - mb_row);
+
+        while (segment < MAX_MB_SEGMENTS - 1 &&
+               row_bits * bpm[cpi->row_rc_q[segment]] / bpm[base_q] > remaining)
+            segment++;
+    }
+
+    if (rows > cm->mb_rows - mb_row)
+        rows = cm->mb_rows - mb_row;
+
+    vpx_memset(cpi->segmentation_map + mb_row * cm->mb_cols, segment, rows * cm->mb_cols);
+}
+
+// Deadline scheduling of the MB rows of a real-time frame. The time to
+// finish the frame is projected from the rate rows have been coded at since
+// the speed was last set. If that misses the deadline the remaining rows
+// move to a faster speed, by one step per quarter of the deadline the frame
+// is projected to overrun, at most four at a time.
+static void schedule_mb_rows(VP8_COMP *cpi, struct vpx_usec_timer *timer,
+                             int mb_row, int *start_row, unsigned int *start_time)
+{
+    const unsigned int deadline = cpi->mb_row_deadline;
+    unsigned int elapsed;
+    unsigned int projected;
+    int step;
+
+    if (mb_row - *start_row < 2 || cpi->Speed >= 16)
+        return;
+
+    vpx_usec_timer_mark(timer);
+    elapsed = (unsigned int)vpx_usec_timer_elapsed(timer);
+    projected = elapsed + (elapsed - *start_time) * (cpi->common.mb_rows - mb_row)
+                / (mb_row - *start_row);
+
+    if (projected <= deadline)
+        return;
+
+    step = 1 + (projected - deadline) * 4 / deadline;
+
+    if (step > 4)
+        step = 4;
+
+    vp8_raise_speed_in_frame(cpi, (cpi->Speed + step < 16) ? cpi->Speed + step : 16);
+
+    *start_row = mb_row;
+    *start_time = elapsed;
+}
+
+// Restore the mode decisions made for this MB in the first iteration of the
+// recode loop so it can be re-encoded at the new quantizer.
+static void restore_fixed_modes(MACROBLOCKD *xd)
+{
+    int i;
+
+    for (i = 0; i < 16; i++)
+        vpx_memcpy(&xd->block[i].bmi, &xd->mode_info_context->bmi[i], sizeof(xd->block[i].bmi));
+}
+
+// Moves the statistics of the MBs just coded, kept by each thread, into
+// cpi->frame_stats. The times add up over the recode loop while the counts
+// are those of the last iteration.
+static void gather_frame_stats(VP8_COMP *cpi)
+{
+    vp8e_frame_stats_t *stats = &cpi->frame_stats;
+    int threads = cpi->b_multi_threaded ? cpi->encoding_thread_count : 0;
+    int i, j;
+
+    vp8_zero(stats->modes)
+    stats->skips = 0;
+
+    for (i = 0; i <= threads; i++)
+    {
+        MACROBLOCK *x = i ? &cpi->mb_row_ei[i - 1].mb : &cpi->mb;
+
+        stats->motion_search += x->time_motion_search;
+        stats->mode_decision += x->time_mode_decision;
+        stats->transform += x->time_transform;
+        stats->tokenize += x->time_tokenize;
+
+        for (j = 0; j < MB_MODE_COUNT; j++)
+            stats->modes[j] += x->mode_count[j];
+
+        stats->skips += x->skip_count;
+
+        x->time_motion_search = 0;
+        x->time_mode_decision = 0;
+        x->time_transform = 0;
+        x->time_tokenize = 0;
+        vp8_zero(x->mode_count)
+        x->skip_count = 0;
+    }
+}
 
 void vp8_encode_frame(VP8_COMP *cpi)
 {
@@ -548,6 +730,9 @@ void vp8_encode_frame(VP8_COMP *cpi)
     TOKENEXTRA *tp = cpi->tok;
     int segment_counts[MAX_MB_SEGMENTS];
     int totalrate;
+    int frame_speed;
+    int sched_row = 0;
+    unsigned int sched_time = 0;
 
     // Functions setup for all frame types so we can use MC in AltRef
     if (cm->mcomp_filter_type == SIXTAP)
@@ -585,8 +770,13 @@ void vp8_encode_frame(VP8_COMP *cpi)
 
     vpx_memset(segment_counts, 0, sizeof(segment_counts));
 
-    cpi->prediction_error = 0;
-    cpi->intra_error = 0;
+    // When re-encoding with fixed modes keep the errors from mode selection
+    if (!cpi->fixed_mode_recode)
+    {
+        cpi->prediction_error = 0;
+        cpi->intra_error = 0;
+    }
+
     cpi->skip_true_count = 0;
     cpi->skip_false_count = 0;
 
@@ -618,6 +808,8 @@ void vp8_encode_frame(VP8_COMP *cpi)
 
     vp8cx_frame_init_quantizer(cpi);
 
+    cpi->mb_row_deadline = 0;
+
     if (cpi->compressor_speed == 2)
     {
         if (cpi->oxcf.cpu_used < 0)
@@ -626,6 +818,8 @@ void vp8_encode_frame(VP8_COMP *cpi)
             vp8_auto_select_speed(cpi);
     }
 
+    frame_speed = cpi->Speed;
+
     vp8_initialize_rd_consts(cpi, vp8_dc_quant(cm->base_qindex, cm->y1dc_delta_q));
     //vp8_initialize_rd_consts( cpi, vp8_dc_quant(cpi->avg_frame_qindex, cm->y1dc_delta_q) );
     vp8cx_initialize_me_consts(cpi, cm->base_qindex);
@@ -664,8 +858,11 @@ void vp8_encode_frame(VP8_COMP *cpi)
     //x->rdmult = (int)(cpi->RDMULT * pow( (cpi->rate_correction_factor * 2.0), 0.75 ));
 #endif
 
-    xd->mode_info_context->mbmi.mode = DC_PRED;
-    xd->mode_info_context->mbmi.uv_mode = DC_PRED;
+    if (!cpi->fixed_mode_recode)
+    {
+        xd->mode_info_context->mbmi.mode = DC_PRED;
+        xd->mode_info_context->mbmi.uv_mode = DC_PRED;
+    }
 
     xd->left_context = &cm->left_context;
 
@@ -689,6 +886,12 @@ void vp8_encode_frame(VP8_COMP *cpi)
 
                 vp8_zero(cm->left_context)
 
+                if (cpi->row_rc_active)
+                    row_rate_control(cpi, mb_row, 1);
+
+                if (cpi->mb_row_deadline)
+                    schedule_mb_rows(cpi, &emr_timer, mb_row, &sched_row, &sched_time);
+
                 encode_mb_row(cpi, cm, mb_row, x, xd, &tp, segment_counts, &totalrate);
 
                 // adjust to the next row of mbs
@@ -705,12 +908,27 @@ void vp8_encode_frame(VP8_COMP *cpi)
 #if CONFIG_MULTITHREAD
             vp8cx_init_mbrthread_data(cpi, x, cpi->mb_row_ei, 1,  cpi->encoding_thread_count);
 
-            for (mb_row = 0; mb_row < cm->mb_rows; mb_row += (cpi->encoding_thread_count + 1))
+            // Each batch of rows is coded at one Q under the size cap, so
+            // keep the batches to about an eighth of the frame.
+            cpi->batch_thread_count = cpi->encoding_thread_count;
+
+            if (cpi->row_rc_active && cpi->batch_thread_count > cm->mb_rows / 8 - 1)
+                cpi->batch_thread_count = cm->mb_rows / 8 > 1 ? cm->mb_rows / 8 - 1 : 1;
+
+            for (mb_row = 0; mb_row < cm->mb_rows; mb_row += (cpi->batch_thread_count + 1))
             {
                 int i;
                 cpi->current_mb_col_main = -1;
 
-                for (i = 0; i < cpi->encoding_thread_count; i++)
+                // The previous group of rows has completed, so its cost is
+                // known before this group is started.
+                if (cpi->row_rc_active)
+                    row_rate_control(cpi, mb_row, cpi->batch_thread_count + 1);
+
+                if (cpi->mb_row_deadline)
+                    schedule_mb_rows(cpi, &emr_timer, mb_row, &sched_row, &sched_time);
+
+                for (i = 0; i < cpi->batch_thread_count; i++)
                 {
                     if ((mb_row + i + 1) >= cm->mb_rows)
                         break;
@@ -729,12 +947,12 @@ void vp8_encode_frame(VP8_COMP *cpi)
                 encode_mb_row(cpi, cm, mb_row, x, xd, &tp, segment_counts, &totalrate);
 
                 // adjust to the next row of mbs
-                x->src.y_buffer += 16 * x->src.y_stride * (cpi->encoding_thread_count + 1) - 16 * cm->mb_cols;
-                x->src.u_buffer +=  8 * x->src.uv_stride * (cpi->encoding_thread_count + 1) - 8 * cm->mb_cols;
-                x->src.v_buffer +=  8 * x->src.uv_stride * (cpi->encoding_thread_count + 1) - 8 * cm->mb_cols;
+                x->src.y_buffer += 16 * x->src.y_stride * (cpi->batch_thread_count + 1) - 16 * cm->mb_cols;
+                x->src.u_buffer +=  8 * x->src.uv_stride * (cpi->batch_thread_count + 1) - 8 * cm->mb_cols;
+                x->src.v_buffer +=  8 * x->src.uv_stride * (cpi->batch_thread_count + 1) - 8 * cm->mb_cols;
 
-                xd->mode_info_context += xd->mode_info_stride * cpi->encoding_thread_count;
-                x->partition_info  += xd->mode_info_stride * cpi->encoding_thread_count;
+                xd->mode_info_context += xd->mode_info_stride * cpi->batch_thread_count;
+                x->partition_info  += xd->mode_info_stride * cpi->batch_thread_count;
 
                 if (mb_row < cm->mb_rows - 1)
                     //WaitForSingleObject(cpi->h_event_main, INFINITE);
@@ -790,7 +1008,19 @@ void vp8_encode_frame(VP8_COMP *cpi)
         }
 
         vpx_usec_timer_mark(&emr_timer);
-        cpi->time_encode_mb_row += vpx_usec_timer_elapsed(&emr_timer);
+        cpi->last_mb_row_time = (int)vpx_usec_timer_elapsed(&emr_timer);
+        cpi->time_encode_mb_row += cpi->last_mb_row_time;
+
+        if (x->collect_stats)
+            gather_frame_stats(cpi);
+
+        // Account for the last rows coded
+        if (cpi->row_rc_active)
+            row_rate_control(cpi, cm->mb_rows, 0);
+
+        // Any speed up was for this frame only. Speed selection for the next
+        // frame carries on from the frame level choice.
+        cpi->Speed = frame_speed;
 
     }
 
@@ -831,6 +1061,18 @@ void vp8_encode_frame(VP8_COMP *cpi)
         }
     }
 
+    // With fixed modes only the residual is recoded. Take the mode and MV
+    // signalling cost from the first pass and re-cost the new tokens.
+    if (cpi->sf.recode_fixed_modes)
+    {
+        int token_rate = cost_frame_tokens(cpi);
+
+        if (cpi->fixed_mode_recode)
+            totalrate = cpi->fixed_mode_rate + token_rate;
+        else
+            cpi->fixed_mode_rate = (totalrate > token_rate) ? totalrate - token_rate : 0;
+    }
+
     // 256 rate units to the bit
     cpi->projected_frame_size = totalrate >> 8;   // projected_frame_size in units of BYTES
 
@@ -1007,6 +1249,25 @@ void vp8_build_block_offsets(MACROBLOCK *x)
     }
 }
 
+void vp8_mb_stats_mark(MACROBLOCK *x, unsigned int *counter)
+{
+    if (x->collect_stats)
+    {
+        vpx_usec_timer_mark(&x->stats_timer);
+        *counter += vpx_usec_timer_elapsed(&x->stats_timer);
+        x->stats_timer.begin = x->stats_timer.end;
+    }
+}
+
+static void count_mb_stats(MACROBLOCK *x, int skip)
+{
+    if (x->collect_stats)
+    {
+        ++x->mode_count[x->e_mbd.mode_info_context->mbmi.mode];
+        x->skip_count += skip;
+    }
+}
+
 static void sum_intra_stats(VP8_COMP *cpi, MACROBLOCK *x)
 {
     const MACROBLOCKD *xd = & x->e_mbd;
@@ -1051,6 +1312,31 @@ int vp8cx_encode_intra_macro_block(VP8_COMP *cpi, MACROBLOCK *x, TOKENEXTRA **t)
 
     x->e_mbd.mode_info_context->mbmi.ref_frame = INTRA_FRAME;
 
+    if (x->collect_stats)
+        vpx_usec_timer_start(&x->stats_timer);
+
+    if (cpi->fixed_mode_recode)
+    {
+        restore_fixed_modes(&x->e_mbd);
+
+        vp8_encode_intra16x16mbuv(IF_RTCD(&cpi->rtcd), x);
+
+        if (x->e_mbd.mode_info_context->mbmi.mode == B_PRED)
+            vp8_encode_intra4x4mby(IF_RTCD(&cpi->rtcd), x);
+        else
+            vp8_encode_intra16x16mby(IF_RTCD(&cpi->rtcd), x);
+
+        vp8_mb_stats_mark(x, &x->time_transform);
+
+        sum_intra_stats(cpi, x);
+        vp8_tokenize_mb(cpi, &x->e_mbd, t);
+
+        vp8_mb_stats_mark(x, &x->time_tokenize);
+        count_mb_stats(x, x->e_mbd.mode_info_context->mbmi.mb_skip_coeff);
+
+        return 0;
+    }
+
 #if !(CONFIG_REALTIME_ONLY)
 
     if (cpi->sf.RD || cpi->compressor_speed != 2)
@@ -1065,6 +1351,8 @@ int vp8cx_encode_intra_macro_block(VP8_COMP *cpi, MACROBLOCK *x, TOKENEXTRA **t)
 
         error_uv = vp8_rd_pick_intra_mbuv_mode(cpi, x, &rateuv, &rateuv_tokenonly, &distuv);
 
+        vp8_mb_stats_mark(x, &x->time_mode_decision);
+
         vp8_encode_intra16x16mbuv(IF_RTCD(&cpi->rtcd), x);
         rate += rateuv;
 
@@ -1096,6 +1384,8 @@ int vp8cx_encode_intra_macro_block(VP8_COMP *cpi, MACROBLOCK *x, TOKENEXTRA **t)
 #endif
         }
 
+        vp8_mb_stats_mark(x, &x->time_transform);
+
         sum_intra_stats(cpi, x);
 
         vp8_tokenize_mb(cpi, &x->e_mbd, t);
@@ -1131,6 +1421,8 @@ int vp8cx_encode_intra_macro_block(VP8_COMP *cpi, MACROBLOCK *x, TOKENEXTRA **t)
         else
             Error4x4 = RD_ESTIMATE(x->rdmult, x->rddiv, rate2, distortion2);
 
+        vp8_mb_stats_mark(x, &x->time_mode_decision);
+
         if (Error4x4 < Error16x16)
         {
             x->e_mbd.mode_info_context->mbmi.mode = B_PRED;
@@ -1144,12 +1436,18 @@ int vp8cx_encode_intra_macro_block(VP8_COMP *cpi, MACROBLOCK *x, TOKENEXTRA **t)
             cpi->prediction_error += Error16x16;
         }
 
+        vp8_mb_stats_mark(x, &x->time_transform);
         vp8_pick_intra_mbuv_mode(x);
+        vp8_mb_stats_mark(x, &x->time_mode_decision);
         vp8_encode_intra16x16mbuv(IF_RTCD(&cpi->rtcd), x);
+        vp8_mb_stats_mark(x, &x->time_transform);
         sum_intra_stats(cpi, x);
         vp8_tokenize_mb(cpi, &x->e_mbd, t);
     }
 
+    vp8_mb_stats_mark(x, &x->time_tokenize);
+    count_mb_stats(x, x->e_mbd.mode_info_context->mbmi.mb_skip_coeff);
+
     return rate;
 }
 #ifdef SPEEDSTATS
@@ -1165,6 +1463,7 @@ int vp8cx_encode_inter_macroblock
 )
 {
     MACROBLOCKD *const xd = &x->e_mbd;
+    const int mi_index = xd->mode_info_context - cpi->common.mi;
     int inter_error;
     int intra_error = 0;
     int rate;
@@ -1172,24 +1471,41 @@ int vp8cx_encode_inter_macroblock
 
     x->skip = 0;
 
+    if (x->collect_stats)
+        vpx_usec_timer_start(&x->stats_timer);
+
     if (xd->segmentation_enabled)
         x->encode_breakout = cpi->segment_encode_breakout[xd->mode_info_context->mbmi.segment_id];
     else
         x->encode_breakout = cpi->oxcf.encode_breakout;
 
-#if !(CONFIG_REALTIME_ONLY)
-
-    if (cpi->sf.RD)
+    if (cpi->fixed_mode_recode)
     {
-        inter_error = vp8_rd_pick_inter_mode(cpi, x, recon_yoffset, recon_uvoffset, &rate, &distortion, &intra_error);
+        // Reuse the modes, MVs and partitioning of the first pass
+        restore_fixed_modes(xd);
+        x->skip = cpi->fixed_mode_skip_map[mi_index];
+        rate = 0;
     }
     else
+    {
+#if !(CONFIG_REALTIME_ONLY)
+
+        if (cpi->sf.RD)
+        {
+            inter_error = vp8_rd_pick_inter_mode(cpi, x, recon_yoffset, recon_uvoffset, &rate, &distortion, &intra_error);
+        }
+        else
 #endif
-        inter_error = vp8_pick_inter_mode(cpi, x, recon_yoffset, recon_uvoffset, &rate, &distortion, &intra_error);
+            inter_error = vp8_pick_inter_mode(cpi, x, recon_yoffset, recon_uvoffset, &rate, &distortion, &intra_error);
 
+        cpi->prediction_error += inter_error;
+        cpi->intra_error += intra_error;
 
-    cpi->prediction_error += inter_error;
-    cpi->intra_error += intra_error;
+        if (cpi->sf.recode_fixed_modes)
+            cpi->fixed_mode_skip_map[mi_index] = (unsigned char)x->skip;
+    }
+
+    vp8_mb_stats_mark(x, &x->time_mode_decision);
 
 #if 0
     // Experimental RD code
@@ -1201,7 +1517,7 @@ int vp8cx_encode_inter_macroblock
     if (xd->segmentation_enabled || cpi->zbin_mode_boost_enabled)
     {
         // If cyclic update enabled
-        if (cpi->cyclic_refresh_mode_enabled)
+        if (cpi->cyclic_refresh_mode_enabled && !cpi->row_rc_active)
         {
             // Clear segment_id back to 0 if not coded (last frame 0,0)
             if ((xd->mode_info_context->mbmi.segment_id == 1) &&
@@ -1295,6 +1611,8 @@ int vp8cx_encode_inter_macroblock
             vp8_stuff_inter16x16(x);
     }
 
+    vp8_mb_stats_mark(x, &x->time_transform);
+
     if (!x->skip)
         vp8_tokenize_mb(cpi, xd, t);
     else
@@ -1318,5 +1636,8 @@ int vp8cx_encode_inter_macroblock
         }
     }
 
+    vp8_mb_stats_mark(x, &x->time_tokenize);
+    count_mb_stats(x, x->skip || xd->mode_info_context->mbmi.mb_skip_coeff);
+
     return rate;
 }
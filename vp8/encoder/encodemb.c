@@ -290,6 +290,7 @@ void vp8_optimize_b(MACROBLOCK *mb, int ib, int type,
     int pt;
     int i;
     int err_mult = plane_rd_mult[type];
+    unsigned int (*const type_costs)[PREV_COEF_CONTEXTS][vp8_coef_tokens] = mb->token_costs[type];
 
     b = &mb->block[ib];
     d = &mb->e_mbd.block[ib];
@@ -308,6 +309,24 @@ void vp8_optimize_b(MACROBLOCK *mb, int ib, int type,
     i0 = !type;
     eob = d->eob;
 
+    /* Nothing to optimize in an empty block. The fast variant also leaves
+     *  alone blocks with a single coefficient, unless it is a +/-1 that
+     *  may be better dropped.
+     */
+    if (eob <= i0)
+    {
+        d->eob = i0;
+        *a = *l = 0;
+        return;
+    }
+
+    if (mb->fast_optimize && eob == i0 + 1 &&
+        abs(qcoeff_ptr[vp8_default_zig_zag1d[i0]]) > 1)
+    {
+        *a = *l = 1;
+        return;
+    }
+
     /* Now set up a Viterbi trellis to evaluate alternative roundings. */
     /* TODO: These should vary with the block type, since the quantizer does. */
     rdmult = (mb->rdmult << 2)*err_mult;
@@ -345,9 +364,9 @@ void vp8_optimize_b(MACROBLOCK *mb, int ib, int type,
                 band = vp8_coef_bands[i + 1];
                 pt = vp8_prev_token_class[t0];
                 rate0 +=
-                    mb->token_costs[type][band][pt][tokens[next][0].token];
+                    type_costs[band][pt][tokens[next][0].token];
                 rate1 +=
-                    mb->token_costs[type][band][pt][tokens[next][1].token];
+                    type_costs[band][pt][tokens[next][1].token];
             }
             rd_cost0 = RDCOST(rdmult, rddiv, rate0, error0);
             rd_cost1 = RDCOST(rdmult, rddiv, rate1, error1);
@@ -377,6 +396,30 @@ void vp8_optimize_b(MACROBLOCK *mb, int ib, int type,
             else
                 shortcut = 0;
 
+            /* The fast variant does not try lowering a coefficient above two
+             *  when the added distortion alone outweighs everything it could
+             *  save: its extra bits and the largest cost of its token. Its
+             *  token class, and so the following context, does not change.
+             */
+            if (shortcut && mb->fast_optimize && (x > 2 || x < -2))
+            {
+                unsigned int (*const tc)[vp8_coef_tokens] = type_costs[vp8_coef_bands[i]];
+                int max_save = tc[0][t0];
+                int dx_low = dx - (x > 0 ? dequant_ptr[rc] : -dequant_ptr[rc]);
+
+                if (max_save < (int)tc[1][t0])
+                    max_save = tc[1][t0];
+
+                if (max_save < (int)tc[2][t0])
+                    max_save = tc[2][t0];
+
+                max_save += base_bits;
+
+                if (RDCOST(rdmult, rddiv, 0, dx_low * dx_low - d2) >
+                    RDCOST(rdmult, rddiv, max_save, 0))
+                    shortcut = 0;
+            }
+
             if(shortcut)
             {
                 sz = -(x < 0);
@@ -404,13 +447,13 @@ void vp8_optimize_b(MACROBLOCK *mb, int ib, int type,
                 if(t0!=DCT_EOB_TOKEN)
                 {
                     pt = vp8_prev_token_class[t0];
-                    rate0 += mb->token_costs[type][band][pt][
+                    rate0 += type_costs[band][pt][
                         tokens[next][0].token];
                 }
                 if(t1!=DCT_EOB_TOKEN)
                 {
                     pt = vp8_prev_token_class[t1];
-                    rate1 += mb->token_costs[type][band][pt][
+                    rate1 += type_costs[band][pt][
                         tokens[next][1].token];
                 }
             }
@@ -451,12 +494,12 @@ void vp8_optimize_b(MACROBLOCK *mb, int ib, int type,
             /* Update the cost of each path if we're past the EOB token. */
             if (t0 != DCT_EOB_TOKEN)
             {
-                tokens[next][0].rate += mb->token_costs[type][band][0][t0];
+                tokens[next][0].rate += type_costs[band][0][t0];
                 tokens[next][0].token = ZERO_TOKEN;
             }
             if (t1 != DCT_EOB_TOKEN)
             {
-                tokens[next][1].rate += mb->token_costs[type][band][0][t1];
+                tokens[next][1].rate += type_costs[band][0][t1];
                 tokens[next][1].token = ZERO_TOKEN;
             }
             /* Don't update next, because we didn't add a new node. */
@@ -472,8 +515,8 @@ void vp8_optimize_b(MACROBLOCK *mb, int ib, int type,
     error1 = tokens[next][1].error;
     t0 = tokens[next][0].token;
     t1 = tokens[next][1].token;
-    rate0 += mb->token_costs[type][band][pt][t0];
-    rate1 += mb->token_costs[type][band][pt][t1];
+    rate0 += type_costs[band][pt][t0];
+    rate1 += type_costs[band][pt][t1];
     rd_cost0 = RDCOST(rdmult, rddiv, rate0, error0);
     rd_cost1 = RDCOST(rdmult, rddiv, rate1, error1);
     if (rd_cost0 == rd_cost1)
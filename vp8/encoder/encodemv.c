@@ -15,6 +15,7 @@
 #include "systemdependent.h"
 
 #include <math.h>
+#include <string.h>
 
 #ifdef ENTROPY_STATS
 extern unsigned int active_section;
@@ -420,6 +421,26 @@ static void write_component_probs(
     }
 }
 
+// Rebuilds the MV cost table of each component whose probabilities differ
+// from those the table was last built from.
+void vp8_update_mv_cost_tables(VP8_COMP *cpi)
+{
+    const MV_CONTEXT *mvc = cpi->common.fc.mvc;
+    int flags[2];
+    int i;
+
+    for (i = 0; i < 2; i++)
+    {
+        flags[i] = memcmp(cpi->mvcost_mvc[i].prob, mvc[i].prob, sizeof(mvc[i].prob)) != 0;
+
+        if (flags[i])
+            vpx_memcpy(&cpi->mvcost_mvc[i], &mvc[i], sizeof(mvc[i]));
+    }
+
+    if (flags[0] || flags[1])
+        vp8_build_component_cost_table(cpi->mb.mvcost, cpi->mb.mvsadcost, mvc, flags);
+}
+
 void vp8_write_mvprobs(VP8_COMP *cpi)
 {
     vp8_writer *const w  = & cpi->bc;
@@ -436,7 +457,7 @@ void vp8_write_mvprobs(VP8_COMP *cpi)
     );
 
     if (flags[0] || flags[1])
-        vp8_build_component_cost_table(cpi->mb.mvcost, cpi->mb.mvsadcost, (const MV_CONTEXT *) cpi->common.fc.mvc, flags);
+        vp8_update_mv_cost_tables(cpi);
 
 #ifdef ENTROPY_STATS
     active_section = 5;
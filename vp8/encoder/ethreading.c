@@ -126,6 +126,7 @@ THREAD_FUNCTION thread_encoding_proc(void *p_data)
                         else
                             xd->mode_info_context->mbmi.segment_id = 0;         // Set to Segment 0 by default
 
+                        x->mb_analysis = cpi->mb_analysis + seg_map_index + mb_col;
 
                         if (cm->frame_type == KEY_FRAME)
                         {
@@ -198,14 +199,14 @@ THREAD_FUNCTION thread_encoding_proc(void *p_data)
                     xd->mode_info_context++;
                     x->partition_info++;
 
-                    x->src.y_buffer += 16 * x->src.y_stride * (cpi->encoding_thread_count + 1) - 16 * cm->mb_cols;
-                    x->src.u_buffer +=  8 * x->src.uv_stride * (cpi->encoding_thread_count + 1) - 8 * cm->mb_cols;
-                    x->src.v_buffer +=  8 * x->src.uv_stride * (cpi->encoding_thread_count + 1) - 8 * cm->mb_cols;
+                    x->src.y_buffer += 16 * x->src.y_stride * (cpi->batch_thread_count + 1) - 16 * cm->mb_cols;
+                    x->src.u_buffer +=  8 * x->src.uv_stride * (cpi->batch_thread_count + 1) - 8 * cm->mb_cols;
+                    x->src.v_buffer +=  8 * x->src.uv_stride * (cpi->batch_thread_count + 1) - 8 * cm->mb_cols;
 
-                    xd->mode_info_context += xd->mode_info_stride * cpi->encoding_thread_count;
-                    x->partition_info += xd->mode_info_stride * cpi->encoding_thread_count;
+                    xd->mode_info_context += xd->mode_info_stride * cpi->batch_thread_count;
+                    x->partition_info += xd->mode_info_stride * cpi->batch_thread_count;
 
-                    if (ithread == (cpi->encoding_thread_count - 1) || mb_row == cm->mb_rows - 1)
+                    if (ithread == (cpi->batch_thread_count - 1) || mb_row == cm->mb_rows - 1)
                     {
                         //SetEvent(cpi->h_event_main);
                         sem_post(&cpi->h_event_main);
@@ -255,6 +256,9 @@ static void setup_mbby_copy(MACROBLOCK *mbdst, MACROBLOCK *mbsrc)
     z->vp8_short_fdct8x4     = x->vp8_short_fdct8x4;
     z->short_walsh4x4    = x->short_walsh4x4;
     z->quantize_b        = x->quantize_b;
+    z->optimize          = x->optimize;
+    z->fast_optimize     = x->fast_optimize;
+    z->collect_stats     = x->collect_stats;
 
     /*
     z->mvc              = x->mvc;
@@ -267,8 +271,8 @@ static void setup_mbby_copy(MACROBLOCK *mbdst, MACROBLOCK *mbsrc)
     vpx_memcpy(z->mvcosts,          x->mvcosts,         sizeof(x->mvcosts));
     z->mvcost[0] = &z->mvcosts[0][mv_max+1];
     z->mvcost[1] = &z->mvcosts[1][mv_max+1];
-    z->mvsadcost[0] = &z->mvsadcosts[0][mv_max+1];
-    z->mvsadcost[1] = &z->mvsadcosts[1][mv_max+1];
+    z->mvsadcost[0] = x->mvsadcost[0];
+    z->mvsadcost[1] = x->mvsadcost[1];
 
 
     vpx_memcpy(z->token_costs,       x->token_costs,      sizeof(x->token_costs));
@@ -414,7 +418,10 @@ void vp8cx_create_encoder_threads(VP8_COMP *cpi)
 
 #if CONFIG_MULTITHREAD
 
-    if (cpi->processor_core_count > 1 && cpi->oxcf.multi_threaded > 1)
+    // Rows are handed out round robin, so threads beyond one per row would
+    // never get any work
+    if (cpi->processor_core_count > 1 && cpi->oxcf.multi_threaded > 1
+        && cpi->common.mb_rows > 1)
     {
         int ithread;
 
@@ -423,6 +430,10 @@ void vp8cx_create_encoder_threads(VP8_COMP *cpi)
         else
             cpi->encoding_thread_count = cpi->oxcf.multi_threaded - 1;
 
+        if (cpi->encoding_thread_count > cpi->common.mb_rows - 1)
+            cpi->encoding_thread_count = cpi->common.mb_rows - 1;
+
+        cpi->batch_thread_count = cpi->encoding_thread_count;
 
         CHECK_MEM_ERROR(cpi->h_encoding_thread, vpx_malloc(sizeof(pthread_t) * cpi->encoding_thread_count));
         CHECK_MEM_ERROR(cpi->h_event_mbrencoding, vpx_malloc(sizeof(sem_t) * cpi->encoding_thread_count));
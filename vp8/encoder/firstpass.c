@@ -472,7 +472,7 @@ void vp8_first_pass_motion_search(VP8_COMP *cpi, MACROBLOCK *x, MV *ref_mv, MV *
     xd->pre.y_buffer = recon_buffer->y_buffer + recon_yoffset;
 
     // Initial step/diamond search centred on best mv
-    tmp_err = cpi->diamond_search_sad(x, b, d, ref_mv, &tmp_mv, step_param, x->errorperbit, &num00, &v_fn_ptr, x->mvsadcost, x->mvcost);
+    tmp_err = cpi->diamond_search_sad(x, b, d, ref_mv, &tmp_mv, step_param, x->errorperbit, &num00, &v_fn_ptr, x->mvsadcost, x->mvcost, ref_mv);
     if ( tmp_err < INT_MAX-new_mv_mode_penalty )
         tmp_err += new_mv_mode_penalty;
 
@@ -495,7 +495,7 @@ void vp8_first_pass_motion_search(VP8_COMP *cpi, MACROBLOCK *x, MV *ref_mv, MV *
             num00--;
         else
         {
-            tmp_err = cpi->diamond_search_sad(x, b, d, ref_mv, &tmp_mv, step_param + n, x->errorperbit, &num00, &v_fn_ptr, x->mvsadcost, x->mvcost);
+            tmp_err = cpi->diamond_search_sad(x, b, d, ref_mv, &tmp_mv, step_param + n, x->errorperbit, &num00, &v_fn_ptr, x->mvsadcost, x->mvcost, ref_mv);
             if ( tmp_err < INT_MAX-new_mv_mode_penalty )
                 tmp_err += new_mv_mode_penalty;
 
@@ -565,10 +565,9 @@ void vp8_first_pass(VP8_COMP *cpi)
     //if( cm->current_video_frame == 0)
     //if ( 0 )
     {
-        int flag[2] = {1, 1};
         vp8_initialize_rd_consts(cpi, vp8_dc_quant(cm->base_qindex, cm->y1dc_delta_q));
         vpx_memcpy(cm->fc.mvc, vp8_default_mv_context, sizeof(vp8_default_mv_context));
-        vp8_build_component_cost_table(cpi->mb.mvcost, cpi->mb.mvsadcost, (const MV_CONTEXT *) cm->fc.mvc, flag);
+        vp8_update_mv_cost_tables(cpi);
     }
 
     // for each macroblock row in image
@@ -2658,3 +2657,147 @@ void vp8_find_next_key_frame(VP8_COMP *cpi, FIRSTPASS_STATS *this_frame)
         }
     }
 }
+
+// Motion compensated error of a 16x16 source block against a full pixel
+// offset in the previous frame.
+static unsigned int lookahead_block_err(VP8_COMP *cpi, unsigned char *src, unsigned char *ref, int stride, int row, int col)
+{
+    unsigned int sse;
+
+    VARIANCE_INVOKE(&cpi->rtcd.variance, mse16x16)(src, stride, ref + row * stride + col, stride, &sse);
+    return sse;
+}
+
+// Lightweight first pass style analysis of a frame entering the one pass
+// lookahead buffer. The intra error of each macroblock is taken as its
+// variance and the inter error from a small full pixel search against the
+// previously buffered source frame (if any), seeded with the vector of the
+// macroblock to the left.
+void vp8_lookahead_frame_stats(VP8_COMP *cpi, YV12_BUFFER_CONFIG *this_frame, YV12_BUFFER_CONFIG *last_frame, ONEPASS_FRAMESTATS *last_stats, ONEPASS_FRAMESTATS *stats)
+{
+    DECLARE_ALIGNED(16, static const unsigned char, mid_grey[16]) =
+    {
+        128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128, 128
+    };
+    int stride = this_frame->y_stride;
+    int mb_rows = this_frame->y_height >> 4;
+    int mb_cols = this_frame->y_width >> 4;
+    int max_row = (mb_rows - 1) * 16;
+    int max_col = (mb_cols - 1) * 16;
+    double intra_error = 1.0;
+    double coded_error = 1.0;
+    int inter_count = 0;
+    int motion_count = 0;
+    int mb_row, mb_col;
+
+    // Partial macroblocks at the right and bottom edges are not analysed
+    for (mb_row = 0; mb_row < mb_rows; mb_row++)
+    {
+        int pred_row = 0;
+        int pred_col = 0;
+
+        for (mb_col = 0; mb_col < mb_cols; mb_col++)
+        {
+            int y = mb_row * 16;
+            int x = mb_col * 16;
+            unsigned char *src = this_frame->y_buffer + y * stride + x;
+            unsigned int sse;
+            unsigned int intra_err;
+            unsigned int inter_err;
+
+            intra_err = VARIANCE_INVOKE(&cpi->rtcd.variance, var16x16)(src, stride, mid_grey, 0, &sse);
+            intra_error += intra_err;
+
+            if (last_frame)
+            {
+                unsigned char *ref = last_frame->y_buffer + y * stride + x;
+                int best_row = 0;
+                int best_col = 0;
+                int step;
+
+                inter_err = lookahead_block_err(cpi, src, ref, stride, 0, 0);
+
+                if (pred_row || pred_col)
+                {
+                    unsigned int err = lookahead_block_err(cpi, src, ref, stride, pred_row, pred_col);
+
+                    if (err < inter_err)
+                    {
+                        inter_err = err;
+                        best_row = pred_row;
+                        best_col = pred_col;
+                    }
+                }
+
+                for (step = 4; step > 0; step >>= 1)
+                {
+                    static const int dr[4] = { -1, 0, 0, 1};
+                    static const int dc[4] = { 0, -1, 1, 0};
+                    int centre_row = best_row;
+                    int centre_col = best_col;
+                    int i;
+
+                    for (i = 0; i < 4; i++)
+                    {
+                        int r = centre_row + dr[i] * step;
+                        int c = centre_col + dc[i] * step;
+                        unsigned int err;
+
+                        if (y + r < 0 || y + r > max_row || x + c < 0 || x + c > max_col)
+                            continue;
+
+                        err = lookahead_block_err(cpi, src, ref, stride, r, c);
+
+                        if (err < inter_err)
+                        {
+                            inter_err = err;
+                            best_row = r;
+                            best_col = c;
+                        }
+                    }
+                }
+
+                pred_row = best_row;
+                pred_col = best_col;
+
+                if (inter_err < intra_err)
+                {
+                    inter_count++;
+
+                    if (best_row || best_col)
+                        motion_count++;
+                }
+                else
+                    inter_err = intra_err;
+            }
+            else
+                inter_err = intra_err;
+
+            coded_error += inter_err;
+        }
+    }
+
+    vp8_clear_system_state();  //__asm emms;
+
+    stats->frame_intra_error = intra_error;
+    stats->frame_coded_error = coded_error;
+    stats->frame_pcnt_inter = (mb_rows && mb_cols) ? (double)inter_count / (mb_rows * mb_cols) : 1.0;
+    stats->frame_pcnt_motion = (mb_rows && mb_cols) ? (double)motion_count / (mb_rows * mb_cols) : 0.0;
+
+    // A frame that is predicted markedly worse than its predecessor is a
+    // scene cut candidate. It is confirmed when the next frame arrives and
+    // turns out to be predicted well again (ruling out a change of motion).
+    stats->scene_cut = 0;
+
+    if (last_frame)
+    {
+        double this_ratio = stats->frame_coded_error / stats->frame_intra_error;
+        double last_ratio = last_stats->frame_coded_error / last_stats->frame_intra_error;
+
+        if (last_stats->scene_cut && last_stats->frame_pcnt_inter >= 0.25
+            && last_ratio < 1.4 * this_ratio)
+            last_stats->scene_cut = 0;
+
+        stats->scene_cut = (stats->frame_pcnt_inter < 0.25) || (this_ratio > 1.4 * last_ratio);
+    }
+}
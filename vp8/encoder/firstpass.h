@@ -21,4 +21,6 @@ extern void vp8_second_pass(VP8_COMP *cpi);
 extern void vp8_end_second_pass(VP8_COMP *cpi);
 
 extern size_t vp8_firstpass_stats_sz(unsigned int mb_count);
+
+extern void vp8_lookahead_frame_stats(VP8_COMP *cpi, YV12_BUFFER_CONFIG *this_frame, YV12_BUFFER_CONFIG *last_frame, ONEPASS_FRAMESTATS *last_stats, ONEPASS_FRAMESTATS *stats);
 #endif
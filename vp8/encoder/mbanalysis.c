@@ -0,0 +1,85 @@
+/*
+ *  Copyright (c) 2010 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+#include <stdlib.h>
+#include <limits.h>
+#include "mbanalysis.h"
+#include "vpx_ports/mem.h"
+
+#if CONFIG_RUNTIME_CPU_DETECT
+#define IF_RTCD(x) (x)
+#else
+#define IF_RTCD(x) NULL
+#endif
+
+static unsigned int edge_energy16x16(const unsigned char *src, int stride)
+{
+    unsigned int energy = 0;
+    int r, c;
+
+    for (r = 0; r < 16; r++)
+    {
+        for (c = 0; c < 16; c++)
+        {
+            if (c < 15)
+                energy += abs(src[c + 1] - src[c]);
+
+            if (r < 15)
+                energy += abs(src[c + stride] - src[c]);
+        }
+
+        src += stride;
+    }
+
+    return energy;
+}
+
+void vp8_analyse_source_mbs(VP8_COMP *cpi)
+{
+    VP8_COMMON *const cm = &cpi->common;
+    YV12_BUFFER_CONFIG *src_yv12 = cpi->Source;
+    YV12_BUFFER_CONFIG *lst_yv12 = &cm->yv12_fb[cm->lst_fb_idx];
+    MB_ANALYSIS *a = cpi->mb_analysis;
+    int inter = (cm->frame_type != KEY_FRAME);
+    int mb_row, mb_col;
+
+    DECLARE_ALIGNED(16, static const unsigned char, zero_block[16]) = { 0 };
+
+    for (mb_row = 0; mb_row < cm->mb_rows; mb_row++)
+    {
+        unsigned char *src = src_yv12->y_buffer + mb_row * 16 * src_yv12->y_stride;
+        unsigned char *lst = lst_yv12->y_buffer + mb_row * 16 * lst_yv12->y_stride;
+
+        for (mb_col = 0; mb_col < cm->mb_cols; mb_col++)
+        {
+            unsigned int sse;
+            int sum;
+
+            // Against an all zero block the sum is the pixel total
+            VARIANCE_INVOKE(IF_RTCD(&cpi->rtcd.variance), get16x16var)(src, src_yv12->y_stride, zero_block, 0, &sse, &sum);
+            a->variance = sse - (((unsigned int)sum * sum) >> 8);
+            a->dc = (unsigned char)((sum + 128) >> 8);
+            a->edge_energy = edge_energy16x16(src, src_yv12->y_stride);
+
+            if (inter)
+                a->zero_mv_var = VARIANCE_INVOKE(IF_RTCD(&cpi->rtcd.variance), var16x16)(src, src_yv12->y_stride, lst, lst_yv12->y_stride, &a->zero_mv_sse);
+            else
+            {
+                a->zero_mv_var = UINT_MAX;
+                a->zero_mv_sse = UINT_MAX;
+            }
+
+            src += 16;
+            lst += 16;
+            a++;
+        }
+    }
+}
@@ -0,0 +1,28 @@
+/*
+ *  Copyright (c) 2010 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+#ifndef __INC_MBANALYSIS_H
+#define __INC_MBANALYSIS_H
+
+#include "onyx_int.h"
+
+// Fills cpi->mb_analysis for the frame in cpi->Source. The zero motion
+// fields are measured against the last frame and are UINT_MAX on key
+// frames.
+//
+// The mode pickers read the zero motion error from here. The first pass
+// (real intra coding error) and the temporal filter (errors between motion
+// searched source frames) measure other things and keep their own code.
+// The variance, DC and edge energy are not read by the encoder yet; they
+// are there for content adaptive tuning.
+extern void vp8_analyse_source_mbs(VP8_COMP *cpi);
+
+#endif
@@ -752,11 +752,42 @@ int vp8_find_best_half_pixel_step(MACROBLOCK *mb, BLOCK *b, BLOCKD *d, MV *bestm
 }
 
 
+// Candidate points are gathered per search step and their SADs worked out
+// together, four at a time through the sdx4df kernel. A trailing group of
+// three is padded out to use it as well, anything smaller goes through sdf.
+// Every SAD is exact, so the decisions made from them match testing each
+// point in turn against the running best.
+#define MAX_SAD_CANDIDATES 8
+
+static void sad_candidates
+(
+    const vp8_variance_fn_ptr_t *fn_ptr,
+    unsigned char *what,
+    int what_stride,
+    unsigned char *blocks[MAX_SAD_CANDIDATES + 1],
+    int in_what_stride,
+    int n,
+    unsigned int sads[MAX_SAD_CANDIDATES + 1]
+)
+{
+    int i = 0;
+
+    while (n - i >= 3)
+    {
+        if (n - i == 3)
+            blocks[i + 3] = blocks[i + 2];
+
+        fn_ptr->sdx4df(what, what_stride, blocks + i, in_what_stride, sads + i);
+        i += 4;
+    }
+
+    for (; i < n; i++)
+        sads[i] = fn_ptr->sdf(what, what_stride, blocks[i], in_what_stride, 0x7fffffff);
+}
+
 #define MVC(r,c) (((mvsadcost[0][((r)<<2)-rr] + mvsadcost[1][((c)<<2) - rc]) * error_per_bit + 128 )>>8 ) // estimated cost of a motion vector (r,c)
 #define PRE(r,c) (*(d->base_pre) + d->pre + (r) * d->pre_stride + (c)) // pointer to predictor base of a motionvector
-#define DIST(r,c,v) vfp->sdf( src,src_stride,PRE(r,c),d->pre_stride, v) // returns sad error score.
-#define ERR(r,c,v) (MVC(r,c)+DIST(r,c,v)) // returns distortion + motion vector cost
-#define CHECK_BETTER(v,r,c) if ((v = ERR(r,c,besterr)) < besterr) { besterr = v; br=r; bc=c; } // checks if (r,c) has better score than previous best
+#define IN_RANGE(r,c) ((c) >= x->mv_col_min && (c) <= x->mv_col_max && (r) >= x->mv_row_min && (r) <= x->mv_row_max)
 static const MV next_chkpts[6][3] =
 {
     {{ -2, 0}, { -1, -2}, {1, -2}},
@@ -766,6 +797,44 @@ static const MV next_chkpts[6][3] =
     {{1, 2}, { -1, 2}, { -2, 0}},
     {{ -1, 2}, { -2, 0}, { -1, -2}}
 };
+
+// Scores the points of a search pattern around (tr,tc) that lie within the
+// MV limits. Returns the number scored, with cand[] holding the index of
+// each in the pattern.
+static int hex_pattern_sads
+(
+    MACROBLOCK *x,
+    BLOCKD *d,
+    const vp8_variance_fn_ptr_t *vfp,
+    unsigned char *src,
+    int src_stride,
+    const MV *pattern,
+    int points,
+    int tr,
+    int tc,
+    int cand[MAX_SAD_CANDIDATES],
+    unsigned int sads[MAX_SAD_CANDIDATES + 1]
+)
+{
+    unsigned char *blocks[MAX_SAD_CANDIDATES + 1];
+    int i, n = 0;
+
+    for (i = 0; i < points; i++)
+    {
+        int nr = tr + pattern[i].row, nc = tc + pattern[i].col;
+
+        if (!IN_RANGE(nr, nc))
+            continue;
+
+        cand[n] = i;
+        blocks[n] = PRE(nr, nc);
+        n++;
+    }
+
+    sad_candidates(vfp, src, src_stride, blocks, d->pre_stride, n, sads);
+    return n;
+}
+
 int vp8_hex_search
 (
     MACROBLOCK *x,
@@ -778,17 +847,21 @@ int vp8_hex_search
     int *num00,
     const vp8_variance_fn_ptr_t *vfp,
     int *mvsadcost[2],
-    int *mvcost[2]
+    int *mvcost[2],
+    MV *center_mv
 )
 {
-    MV hex[6] = { { -1, -2}, {1, -2}, {2, 0}, {1, 2}, { -1, 2}, { -2, 0} } ;
-    MV neighbors[8] = { { -1, -1}, { -1, 0}, { -1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1} } ;
-    int i, j;
+    static const MV hex[6] = { { -1, -2}, {1, -2}, {2, 0}, {1, 2}, { -1, 2}, { -2, 0} } ;
+    static const MV neighbors[8] = { { -1, -1}, { -1, 0}, { -1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1} } ;
+    int i, j, n;
     unsigned char *src = (*(b->base_src) + b->src);
     int src_stride = b->src_stride;
-    int rr = ref_mv->row, rc = ref_mv->col, br = rr >> 3, bc = rc >> 3, tr, tc;
+    int rr = center_mv->row, rc = center_mv->col;
+    int br = ref_mv->row >> 3, bc = ref_mv->col >> 3, tr, tc;
     unsigned int besterr, thiserr = 0x7fffffff;
     int k = -1, tk;
+    int cand[MAX_SAD_CANDIDATES];
+    unsigned int sads[MAX_SAD_CANDIDATES + 1];
 
     if (bc < x->mv_col_min) bc = x->mv_col_min;
 
@@ -801,63 +874,49 @@ int vp8_hex_search
     rr >>= 1;
     rc >>= 1;
 
-    besterr = ERR(br, bc, thiserr);
+    besterr = MVC(br, bc) + vfp->sdf(src, src_stride, PRE(br, bc), d->pre_stride, thiserr);
 
     // hex search
     //j=0
     tr = br;
     tc = bc;
 
-    for (i = 0; i < 6; i++)
-    {
-        int nr = tr + hex[i].row, nc = tc + hex[i].col;
-
-        if (nc < x->mv_col_min) continue;
-
-        if (nc > x->mv_col_max) continue;
+    n = hex_pattern_sads(x, d, vfp, src, src_stride, hex, 6, tr, tc, cand, sads);
 
-        if (nr < x->mv_row_min) continue;
-
-        if (nr > x->mv_row_max) continue;
+    for (j = 0; j < n; j++)
+    {
+        int nr = tr + hex[cand[j]].row, nc = tc + hex[cand[j]].col;
 
-        //CHECK_BETTER(thiserr,nr,nc);
-        if ((thiserr = ERR(nr, nc, besterr)) < besterr)
+        if ((thiserr = MVC(nr, nc) + sads[j]) < besterr)
         {
             besterr = thiserr;
             br = nr;
             bc = nc;
-            k = i;
+            k = cand[j];
         }
     }
 
     if (tr == br && tc == bc)
         goto cal_neighbors;
 
-    for (j = 1; j < 127; j++)
+    for (i = 1; i < 127; i++)
     {
         tr = br;
         tc = bc;
         tk = k;
 
-        for (i = 0; i < 3; i++)
-        {
-            int nr = tr + next_chkpts[tk][i].row, nc = tc + next_chkpts[tk][i].col;
-
-            if (nc < x->mv_col_min) continue;
+        n = hex_pattern_sads(x, d, vfp, src, src_stride, next_chkpts[tk], 3, tr, tc, cand, sads);
 
-            if (nc > x->mv_col_max) continue;
-
-            if (nr < x->mv_row_min) continue;
-
-            if (nr > x->mv_row_max) continue;
+        for (j = 0; j < n; j++)
+        {
+            int nr = tr + next_chkpts[tk][cand[j]].row, nc = tc + next_chkpts[tk][cand[j]].col;
 
-            //CHECK_BETTER(thiserr,nr,nc);
-            if ((thiserr = ERR(nr, nc, besterr)) < besterr)
+            if ((thiserr = MVC(nr, nc) + sads[j]) < besterr)
             {
                 besterr = thiserr;
                 br = nr;
                 bc = nc; //k=(tk+5+i)%6;}
-                k = tk + 5 + i;
+                k = tk + 5 + cand[j];
 
                 if (k >= 12) k -= 12;
                 else if (k >= 6) k -= 6;
@@ -873,19 +932,18 @@ cal_neighbors:
     tr = br;
     tc = bc;
 
-    for (i = 0; i < 8; i++)
-    {
-        int nr = tr + neighbors[i].row, nc = tc + neighbors[i].col;
-
-        if (nc < x->mv_col_min) continue;
-
-        if (nc > x->mv_col_max) continue;
+    n = hex_pattern_sads(x, d, vfp, src, src_stride, neighbors, 8, tr, tc, cand, sads);
 
-        if (nr < x->mv_row_min) continue;
-
-        if (nr > x->mv_row_max) continue;
+    for (j = 0; j < n; j++)
+    {
+        int nr = tr + neighbors[cand[j]].row, nc = tc + neighbors[cand[j]].col;
 
-        CHECK_BETTER(thiserr, nr, nc);
+        if ((thiserr = MVC(nr, nc) + sads[j]) < besterr)
+        {
+            besterr = thiserr;
+            br = nr;
+            bc = nc;
+        }
     }
 
     best_mv->row = br;
@@ -895,10 +953,7 @@ cal_neighbors:
 }
 #undef MVC
 #undef PRE
-#undef SP
-#undef DIST
-#undef ERR
-#undef CHECK_BETTER
+#undef IN_RANGE
 
 
 int vp8_diamond_search_sad
@@ -913,7 +968,8 @@ int vp8_diamond_search_sad
     int *num00,
     vp8_variance_fn_ptr_t *fn_ptr,
     int *mvsadcost[2],
-    int *mvcost[2]
+    int *mvcost[2],
+    MV *center_mv
 )
 {
     int i, j, step;
@@ -949,7 +1005,7 @@ int vp8_diamond_search_sad
     (ref_row > x->mv_row_min) && (ref_row < x->mv_row_max))
     {
         // Check the starting position
-        bestsad = fn_ptr->sdf(what, what_stride, in_what, in_what_stride, 0x7fffffff) + vp8_mv_err_cost(ref_mv, ref_mv, mvsadcost, error_per_bit);
+        bestsad = fn_ptr->sdf(what, what_stride, in_what, in_what_stride, 0x7fffffff) + vp8_mv_err_cost(ref_mv, center_mv, mvsadcost, error_per_bit);
     }
 
     // search_param determines the length of the initial step and hence the number of iterations
@@ -982,7 +1038,7 @@ int vp8_diamond_search_sad
                 {
                     this_mv.row = this_row_offset << 3;
                     this_mv.col = this_col_offset << 3;
-                    thissad += vp8_mv_err_cost(&this_mv, ref_mv, mvsadcost, error_per_bit);
+                    thissad += vp8_mv_err_cost(&this_mv, center_mv, mvsadcost, error_per_bit);
 
                     if (thissad < bestsad)
                     {
@@ -1013,7 +1069,7 @@ int vp8_diamond_search_sad
         return INT_MAX;
 
     return fn_ptr->vf(what, what_stride, best_address, in_what_stride, (unsigned int *)(&thissad))
-    + vp8_mv_err_cost(&this_mv, ref_mv, mvcost, error_per_bit);
+    + vp8_mv_err_cost(&this_mv, center_mv, mvcost, error_per_bit);
 }
 
 int vp8_diamond_search_sadx4
@@ -1028,7 +1084,8 @@ int vp8_diamond_search_sadx4
     int *num00,
     vp8_variance_fn_ptr_t *fn_ptr,
     int *mvsadcost[2],
-    int *mvcost[2]
+    int *mvcost[2],
+    MV *center_mv
 )
 {
     int i, j, step;
@@ -1052,7 +1109,6 @@ int vp8_diamond_search_sadx4
     int this_col_offset;
     search_site *ss;
 
-    unsigned char *check_here;
     unsigned int thissad;
 
     // Work out the start point for the search
@@ -1064,7 +1120,7 @@ int vp8_diamond_search_sadx4
     (ref_row > x->mv_row_min) && (ref_row < x->mv_row_max))
     {
         // Check the starting position
-        bestsad = fn_ptr->sdf(what, what_stride, in_what, in_what_stride, 0x7fffffff) + vp8_mv_err_cost(ref_mv, ref_mv, mvsadcost, error_per_bit);
+        bestsad = fn_ptr->sdf(what, what_stride, in_what, in_what_stride, 0x7fffffff) + vp8_mv_err_cost(ref_mv, center_mv, mvsadcost, error_per_bit);
     }
 
     // search_param determines the length of the initial step and hence the number of iterations
@@ -1108,7 +1164,7 @@ int vp8_diamond_search_sadx4
                     {
                         this_mv.row = (best_mv->row + ss[i].mv.row) << 3;
                         this_mv.col = (best_mv->col + ss[i].mv.col) << 3;
-                        sad_array[t] += vp8_mv_err_cost(&this_mv, ref_mv, mvsadcost, error_per_bit);
+                        sad_array[t] += vp8_mv_err_cost(&this_mv, center_mv, mvsadcost, error_per_bit);
 
                         if (sad_array[t] < bestsad)
                         {
@@ -1121,7 +1177,13 @@ int vp8_diamond_search_sadx4
         }
         else
         {
-            for (j = 0 ; j < x->searches_per_step ; j++)
+            // Batch the sites that are within the limits
+            unsigned char *block_offset[MAX_SAD_CANDIDATES + 1];
+            unsigned int sad_array[MAX_SAD_CANDIDATES + 1];
+            int site[MAX_SAD_CANDIDATES];
+            int n = 0;
+
+            for (j = 0 ; j < x->searches_per_step ; j++, i++)
             {
                 // Trap illegal vectors
                 this_row_offset = best_mv->row + ss[i].mv.row;
@@ -1130,23 +1192,30 @@ int vp8_diamond_search_sadx4
                 if ((this_col_offset > x->mv_col_min) && (this_col_offset < x->mv_col_max) &&
                 (this_row_offset > x->mv_row_min) && (this_row_offset < x->mv_row_max))
                 {
-                    check_here = ss[i].offset + best_address;
-                    thissad = fn_ptr->sdf(what, what_stride, check_here , in_what_stride, bestsad);
+                    site[n] = i;
+                    block_offset[n] = ss[i].offset + best_address;
+                    n++;
+                }
+            }
+
+            sad_candidates(fn_ptr, what, what_stride, block_offset, in_what_stride, n, sad_array);
+
+            for (t = 0; t < n; t++)
+            {
+                thissad = sad_array[t];
+
+                if (thissad < bestsad)
+                {
+                    this_mv.row = (best_mv->row + ss[site[t]].mv.row) << 3;
+                    this_mv.col = (best_mv->col + ss[site[t]].mv.col) << 3;
+                    thissad += vp8_mv_err_cost(&this_mv, center_mv, mvsadcost, error_per_bit);
 
                     if (thissad < bestsad)
                     {
-                        this_mv.row = this_row_offset << 3;
-                        this_mv.col = this_col_offset << 3;
-                        thissad += vp8_mv_err_cost(&this_mv, ref_mv, mvsadcost, error_per_bit);
-
-                        if (thissad < bestsad)
-                        {
-                            bestsad = thissad;
-                            best_site = i;
-                        }
+                        bestsad = thissad;
+                        best_site = site[t];
                     }
                 }
-                i++;
             }
         }
 
@@ -1168,7 +1237,7 @@ int vp8_diamond_search_sadx4
         return INT_MAX;
 
     return fn_ptr->vf(what, what_stride, best_address, in_what_stride, (unsigned int *)(&thissad))
-    + vp8_mv_err_cost(&this_mv, ref_mv, mvcost, error_per_bit);
+    + vp8_mv_err_cost(&this_mv, center_mv, mvcost, error_per_bit);
 }
 
 
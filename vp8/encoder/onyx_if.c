@@ -14,7 +14,10 @@
 #include "systemdependent.h"
 #include "quantize.h"
 #include "alloccommon.h"
+#include "entropymode.h"
+#include "common.h"
 #include "mcomp.h"
+#include "findnearmv.h"
 #include "firstpass.h"
 #include "psnr.h"
 #include "vpx_scale/vpxscale.h"
@@ -22,6 +25,7 @@
 #include "ratectrl.h"
 #include "quant_common.h"
 #include "segmentation.h"
+#include "mbanalysis.h"
 #include "g_common.h"
 #include "vpx_scale/yv12extend.h"
 #include "postproc.h"
@@ -29,6 +33,7 @@
 #include "swapyv12buffer.h"
 #include "threading.h"
 #include "vpx_ports/vpx_timer.h"
+#include "vpx_ports/vpx_once.h"
 #include "vpxerrors.h"
 #include "temporal_filter.h"
 #if ARCH_ARM
@@ -241,20 +246,53 @@ static const int inter_minq[QINDEX_RANGE] =
     69,70,71,71,72,73,74,75,76,76,77,78,79,80,81,81,
 };
 
-void vp8_initialize()
+// MV SAD costs, which depend on nothing but the MV range, shared by all
+// instances
+static int mvsadcosts[2][MVvals+1];
+
+#define M_LOG2_E 0.693147180559945309417
+#define log2f(x) (log (x) / (float) M_LOG2_E)
+static void cal_mvsadcosts(void)
 {
-    static int init_done = 0;
+    int *mvsadcost[2];
+    int i = 1;
 
-    if (!init_done)
-    {
-        vp8_scale_machine_specific_config();
-        vp8_initialize_common();
-        //vp8_dmachine_specific_config();
-        vp8_tokenize_initialize();
+    mvsadcost[0] = &mvsadcosts[0][mv_max+1];
+    mvsadcost[1] = &mvsadcosts[1][mv_max+1];
+
+    mvsadcost [0] [0] = 300;
+    mvsadcost [1] [0] = 300;
 
-        vp8cx_init_mv_bits_sadcost();
-        init_done = 1;
+    do
+    {
+        double z = 256 * (2 * (log2f(2 * i) + .6));
+        mvsadcost [0][i] = (int) z;
+        mvsadcost [1][i] = (int) z;
+        mvsadcost [0][-i] = (int) z;
+        mvsadcost [1][-i] = (int) z;
     }
+    while (++i <= mv_max);
+}
+
+static void initialize_enc(void)
+{
+    vp8_scale_machine_specific_config();
+    vp8_initialize_common();
+    //vp8_dmachine_specific_config();
+    vp8_tokenize_initialize();
+
+    vp8cx_init_mv_bits_sadcost();
+    cal_mvsadcosts();
+#if VP8_TEMPORAL_ALT_REF
+    vp8cx_init_temp_filter_tables();
+#endif
+}
+
+void vp8_initialize()
+{
+    static vpx_once_t once = VPX_ONCE_INIT;
+
+    vpx_once(&once, initialize_enc);
 }
 #ifdef PACKET_TESTING
 extern FILE *vpxlogc;
@@ -326,6 +364,12 @@ void vp8_dealloc_compressor_data(VP8_COMP *cpi)
 
     cpi->gf_active_flags = 0;
 
+    vpx_free(cpi->fixed_mode_skip_map);
+    cpi->fixed_mode_skip_map = 0;
+
+    vpx_free(cpi->mb_analysis);
+    cpi->mb_analysis = 0;
+
     if(cpi->mb.pip)
         vpx_free(cpi->mb.pip);
 
@@ -536,6 +580,100 @@ static void cyclic_background_refresh(VP8_COMP *cpi, int Q, int lf_adjustment)
 
 }
 
+// Bits available to a frame under the size cap. A sixteenth is held back
+// for the error in the per row estimates.
+static int frame_size_cap_bits(VP8_COMP *cpi)
+{
+    int bits = cpi->oxcf.max_frame_size * 8;
+
+    return bits - (bits >> 4);
+}
+
+// Bits a frame coded under the size cap is expected to take at the given
+// Q. Scaled from the last capped frame of the same type where there is one,
+// otherwise from the bits per MB table and the rate correction factor
+// (taken as at least 1, so that a stale factor can not hide a frame that is
+// too large).
+static double row_rc_frame_bits(VP8_COMP *cpi, int Q)
+{
+    VP8_COMMON *cm = &cpi->common;
+    const int *bpm = vp8_bits_per_mb[cm->frame_type];
+    double correction_factor;
+
+    if (cpi->row_rc_frame_bits[cm->frame_type] > 0)
+        return cpi->row_rc_frame_bits[cm->frame_type] * bpm[Q] /
+               bpm[cpi->row_rc_frame_q[cm->frame_type]];
+
+    if (cm->frame_type == KEY_FRAME)
+        correction_factor = cpi->key_frame_rate_correction_factor;
+    else if (cm->refresh_alt_ref_frame || cm->refresh_golden_frame)
+        correction_factor = cpi->gf_rate_correction_factor;
+    else
+        correction_factor = cpi->rate_correction_factor;
+
+    if (correction_factor < 1.0)
+        correction_factor = 1.0;
+
+    return correction_factor * bpm[Q] * cm->MBs / (1 << 9);
+}
+
+// Set up the in frame rate control for a frame coded under the size cap,
+// and return the frame Q to use.
+//
+// The frame Q is first raised until the whole frame is expected to fit the
+// cap, as nothing is known of this frame's rows when the first ones are
+// coded. Segment 0 uses that Q, segments 1 and 2 the Q values expected to
+// give about 3/4 and 1/2 of its bits, and segment 3 MAXQ. The segment of
+// each MB row is chosen as the frame is coded (see row_rate_control()).
+static int setup_row_rate_control(VP8_COMP *cpi, int Q)
+{
+    VP8_COMMON *cm = &cpi->common;
+    const int *bpm = vp8_bits_per_mb[cm->frame_type];
+    signed char feature_data[MB_LVL_MAX][MAX_MB_SEGMENTS];
+    int q;
+    int i;
+
+    while (Q < MAXQ && row_rc_frame_bits(cpi, Q) > frame_size_cap_bits(cpi))
+        Q++;
+
+    cpi->row_rc_row_bits = row_rc_frame_bits(cpi, Q) / cm->mb_rows;
+
+    q = Q;
+    cpi->row_rc_q[0] = Q;
+
+    for (i = 1; i < MAX_MB_SEGMENTS - 1; i++)
+    {
+        while (q < MAXQ && bpm[q] > (bpm[Q] / 4) * (4 - i))
+            q++;
+
+        cpi->row_rc_q[i] = q;
+    }
+
+    cpi->row_rc_q[MAX_MB_SEGMENTS - 1] = MAXQ;
+
+    // Rows start in segment 0
+    vpx_memset(cpi->segmentation_map, 0, cm->mb_rows * cm->mb_cols);
+    enable_segmentation((VP8_PTR)cpi);
+
+    for (i = 0; i < MAX_MB_SEGMENTS; i++)
+    {
+        feature_data[MB_LVL_ALT_Q][i] = cpi->row_rc_q[i] - Q;
+        feature_data[MB_LVL_ALT_LF][i] = 0;
+    }
+
+    set_segment_data((VP8_PTR)cpi, &feature_data[0][0], SEGMENT_DELTADATA);
+
+    cpi->row_rc_active = 1;
+    cpi->row_rc_segmentation = 1;
+    cpi->row_rc_budget = frame_size_cap_bits(cpi);
+    cpi->row_rc_rows_done = 0;
+    cpi->row_rc_spent = 0;
+    cpi->row_rc_base_spent = 0;
+    cpi->row_rc_token_bits = 0;
+
+    return Q;
+}
+
 static void set_default_lf_deltas(VP8_COMP *cpi)
 {
     cpi->mb.e_mbd.mode_ref_lf_delta_enabled = 1;
@@ -581,6 +719,7 @@ void vp8_set_speed_features(VP8_COMP *cpi)
     sf->improved_dct = 1;
     sf->auto_filter = 1;
     sf->recode_loop = 1;
+    sf->recode_fixed_modes = 0;
     sf->quarter_pixel_search = 1;
     sf->half_pixel_search = 1;
     sf->full_freq[0] = 7;
@@ -589,6 +728,8 @@ void vp8_set_speed_features(VP8_COMP *cpi)
     sf->max_fs_radius = 32;
     sf->iterative_sub_pixel = 1;
     sf->optimize_coefficients = 1;
+    sf->bpred_prescreen_modes = 0;
+    sf->split_search_pruning = 0;
 
     sf->first_step = 0;
     sf->max_step_search_steps = MAX_MVSEARCH_STEPS;
@@ -725,8 +866,8 @@ void vp8_set_speed_features(VP8_COMP *cpi)
 
         if (Speed > 0)
         {
-            // Disable coefficient optimization above speed 0
-            sf->optimize_coefficients = 0;
+            // Use the fast coefficient optimization at speed 1, none above
+            sf->optimize_coefficients = (Speed == 1) ? 2 : 0;
 
             cpi->mode_check_freq[THR_SPLITG] = 4;
             cpi->mode_check_freq[THR_SPLITA] = 4;
@@ -766,6 +907,15 @@ void vp8_set_speed_features(VP8_COMP *cpi)
 
             sf->first_step = 1;
             sf->max_step_search_steps = MAX_MVSEARCH_STEPS;
+
+            // Recode iterations only requantize, keeping the modes and MVs
+            // chosen in the first iteration.
+            sf->recode_fixed_modes = 1;
+
+            // Only fully evaluate the B_PRED modes with the lowest SATD
+            sf->bpred_prescreen_modes = 4;
+
+            sf->split_search_pruning = 1;
         }
 
         if (Speed > 1)
@@ -1284,11 +1434,13 @@ void vp8_set_speed_features(VP8_COMP *cpi)
         cpi->find_fractional_mv_step = vp8_skip_fractional_mv_step;
     }
 
-    if (cpi->sf.optimize_coefficients == 1)
+    if (cpi->sf.optimize_coefficients)
         cpi->mb.optimize = 1 + cpi->is_next_src_alt_ref;
     else
         cpi->mb.optimize = 0;
 
+    cpi->mb.fast_optimize = (cpi->sf.optimize_coefficients == 2);
+
     if (cpi->common.full_pixel)
         cpi->find_fractional_mv_step = vp8_skip_fractional_mv_step;
 
@@ -1296,6 +1448,16 @@ void vp8_set_speed_features(VP8_COMP *cpi)
     frames_at_speed[cpi->Speed]++;
 #endif
 }
+#if VP8_TEMPORAL_ALT_REF
+static void alloc_alt_ref_buffer(VP8_COMP *cpi)
+{
+    if (vp8_yv12_alloc_frame_buffer(&cpi->alt_ref_buffer.source_buffer,
+                                    cpi->oxcf.Width, cpi->oxcf.Height, 16))
+        vpx_internal_error(&cpi->common.error, VPX_CODEC_MEM_ERROR,
+                           "Failed to allocate altref buffer");
+}
+#endif
+
 static void alloc_raw_frame_buffers(VP8_COMP *cpi)
 {
     int i, buffers;
@@ -1315,18 +1477,37 @@ static void alloc_raw_frame_buffers(VP8_COMP *cpi)
             vpx_internal_error(&cpi->common.error, VPX_CODEC_MEM_ERROR,
                                "Failed to allocate lag buffer");
 
+    // Release any left over from a deeper lag
+    for (; i < MAX_LAG_BUFFERS; i++)
+        vp8_yv12_de_alloc_frame_buffer(&cpi->src_buffer[i].source_buffer);
+
 #if VP8_TEMPORAL_ALT_REF
 
-    if (vp8_yv12_alloc_frame_buffer(&cpi->alt_ref_buffer.source_buffer,
-                                    cpi->oxcf.Width, cpi->oxcf.Height, 16))
-        vpx_internal_error(&cpi->common.error, VPX_CODEC_MEM_ERROR,
-                           "Failed to allocate altref buffer");
+    if (!cpi->oxcf.low_memory
+        || (cpi->oxcf.play_alternate && cpi->oxcf.lag_in_frames))
+        alloc_alt_ref_buffer(cpi);
+    else
+        vp8_yv12_de_alloc_frame_buffer(&cpi->alt_ref_buffer.source_buffer);
 
 #endif
 
     cpi->source_buffer_count = 0;
 }
 
+// The post processing buffer is only ever displayed or measured, never
+// predicted from, so in low memory mode it goes without the UMV border
+static void alloc_post_proc_buffer(VP8_COMP *cpi)
+{
+    VP8_COMMON *cm = &cpi->common;
+    int border = cpi->oxcf.low_memory ? 16 : VP8BORDERINPIXELS;
+
+    if (vp8_yv12_alloc_frame_buffer(&cm->post_proc_buffer,
+                                    (cm->Width + 15) & ~15,
+                                    (cm->Height + 15) & ~15, border))
+        vpx_internal_error(&cpi->common.error, VPX_CODEC_MEM_ERROR,
+                           "Failed to allocate post processing buffer");
+}
+
 static int vp8_alloc_partition_data(VP8_COMP *cpi)
 {
     cpi->mb.pip = vpx_calloc((cpi->common.mb_cols + 1) *
@@ -1372,6 +1553,9 @@ void vp8_alloc_compressor_data(VP8_COMP *cpi)
         vpx_internal_error(&cpi->common.error, VPX_CODEC_MEM_ERROR,
                            "Failed to allocate scaled source buffer");
 
+    if (cpi->oxcf.low_memory)
+        alloc_post_proc_buffer(cpi);
+
 
     if (cpi->tok != 0)
         vpx_free(cpi->tok);
@@ -1396,6 +1580,14 @@ void vp8_alloc_compressor_data(VP8_COMP *cpi)
 
     cpi->gf_active_count = cm->mb_rows * cm->mb_cols;
 
+    // Indexed by mode info position, so includes the border column
+    vpx_free(cpi->fixed_mode_skip_map);
+    CHECK_MEM_ERROR(cpi->fixed_mode_skip_map, vpx_calloc(1, cm->mode_info_stride * cm->mb_rows));
+    cpi->fixed_mode_recode = 0;
+
+    vpx_free(cpi->mb_analysis);
+    CHECK_MEM_ERROR(cpi->mb_analysis, vpx_calloc(cm->mb_rows * cm->mb_cols, sizeof(*cpi->mb_analysis)));
+
     cpi->total_stats = vpx_calloc(1, vp8_firstpass_stats_sz(cpi->common.MBs));
     cpi->this_frame_stats = vpx_calloc(1, vp8_firstpass_stats_sz(cpi->common.MBs));
     if(!cpi->total_stats || !cpi->this_frame_stats)
@@ -1675,6 +1867,13 @@ void vp8_init_config(VP8_PTR ptr, VP8_CONFIG *oxcf)
     cpi->bits_off_target              = cpi->oxcf.starting_buffer_level;
 
     vp8_new_frame_rate(cpi, cpi->oxcf.frame_rate);
+
+    // Frames further ahead than the longest golden frame group can't affect
+    // any coding decision, so in low memory mode don't buffer them
+    if (cpi->oxcf.low_memory
+        && cpi->oxcf.lag_in_frames > cpi->max_gf_interval + 1)
+        cpi->oxcf.lag_in_frames = cpi->max_gf_interval + 1;
+
     cpi->worst_quality               = cpi->oxcf.worst_allowed_q;
     cpi->active_worst_quality         = cpi->oxcf.worst_allowed_q;
     cpi->avg_frame_qindex             = cpi->oxcf.worst_allowed_q;
@@ -1691,7 +1890,7 @@ void vp8_init_config(VP8_PTR ptr, VP8_CONFIG *oxcf)
     cpi->total_target_vs_actual        = 0;
 
     // Only allow dropped frames in buffered mode
-    cpi->drop_frames_allowed          = cpi->oxcf.allow_df && cpi->buffered_mode;
+    cpi->drop_frames_allowed          = cpi->oxcf.allow_df && cpi->buffered_mode && !cpi->oxcf.max_frame_size;
 
     cm->filter_type      = (LOOPFILTERTYPE) cpi->filter_type;
 
@@ -1772,15 +1971,6 @@ void vp8_init_config(VP8_PTR ptr, VP8_CONFIG *oxcf)
 #if VP8_TEMPORAL_ALT_REF
 
     cpi->use_weighted_temporal_filter = 0;
-
-    {
-        int i;
-
-        cpi->fixed_divide[0] = 0;
-
-        for (i = 1; i < 512; i++)
-            cpi->fixed_divide[i] = 0x80000 / i;
-    }
 #endif
 }
 
@@ -1795,6 +1985,7 @@ void vp8_change_config(VP8_PTR ptr, VP8_CONFIG *oxcf)
 {
     VP8_COMP *cpi = (VP8_COMP *)(ptr);
     VP8_COMMON *cm = &cpi->common;
+    int old_lag, old_play_alternate, old_low_memory;
 
     if (!cpi)
         return;
@@ -1808,6 +1999,10 @@ void vp8_change_config(VP8_PTR ptr, VP8_CONFIG *oxcf)
         vp8_setup_version(cm);
     }
 
+    old_lag = cpi->oxcf.lag_in_frames;
+    old_play_alternate = cpi->oxcf.play_alternate;
+    old_low_memory = cpi->oxcf.low_memory;
+
     cpi->oxcf = *oxcf;
 
     switch (cpi->oxcf.Mode)
@@ -1961,6 +2156,13 @@ void vp8_change_config(VP8_PTR ptr, VP8_CONFIG *oxcf)
     cpi->bits_off_target              = cpi->oxcf.starting_buffer_level;
 
     vp8_new_frame_rate(cpi, cpi->oxcf.frame_rate);
+
+    // Frames further ahead than the longest golden frame group can't affect
+    // any coding decision, so in low memory mode don't buffer them
+    if (cpi->oxcf.low_memory
+        && cpi->oxcf.lag_in_frames > cpi->max_gf_interval + 1)
+        cpi->oxcf.lag_in_frames = cpi->max_gf_interval + 1;
+
     cpi->worst_quality               = cpi->oxcf.worst_allowed_q;
     cpi->active_worst_quality         = cpi->oxcf.worst_allowed_q;
     cpi->avg_frame_qindex             = cpi->oxcf.worst_allowed_q;
@@ -1977,7 +2179,7 @@ void vp8_change_config(VP8_PTR ptr, VP8_CONFIG *oxcf)
     cpi->total_target_vs_actual        = 0;
 
     // Only allow dropped frames in buffered mode
-    cpi->drop_frames_allowed          = cpi->oxcf.allow_df && cpi->buffered_mode;
+    cpi->drop_frames_allowed          = cpi->oxcf.allow_df && cpi->buffered_mode && !cpi->oxcf.max_frame_size;
 
     cm->filter_type                  = (LOOPFILTERTYPE) cpi->filter_type;
 
@@ -2022,6 +2224,29 @@ void vp8_change_config(VP8_PTR ptr, VP8_CONFIG *oxcf)
         alloc_raw_frame_buffers(cpi);
         vp8_alloc_compressor_data(cpi);
     }
+    else
+    {
+        // The lag buffers can only be resized while they're empty
+        if (cpi->source_buffer_count == 0)
+        {
+            if (cpi->oxcf.lag_in_frames != old_lag
+                || cpi->oxcf.play_alternate != old_play_alternate
+                || cpi->oxcf.low_memory != old_low_memory)
+                alloc_raw_frame_buffers(cpi);
+        }
+        else if (cpi->oxcf.lag_in_frames > old_lag)
+            cpi->oxcf.lag_in_frames = old_lag;
+
+        if (cpi->oxcf.low_memory != old_low_memory)
+            alloc_post_proc_buffer(cpi);
+    }
+
+#if VP8_TEMPORAL_ALT_REF
+    // Alt ref frames may have been enabled with frames already queued
+    if (cpi->oxcf.play_alternate && cpi->oxcf.lag_in_frames
+        && !cpi->alt_ref_buffer.source_buffer.buffer_alloc)
+        alloc_alt_ref_buffer(cpi);
+#endif
 
     // Clamp KF frame size to quarter of data rate
     if (cpi->intra_frame_target > cpi->target_bandwidth >> 2)
@@ -2057,65 +2282,131 @@ void vp8_change_config(VP8_PTR ptr, VP8_CONFIG *oxcf)
 
 }
 
-#define M_LOG2_E 0.693147180559945309417
-#define log2f(x) (log (x) / (float) M_LOG2_E)
-static void cal_mvsadcosts(int *mvsadcost[2])
-{
-    int i = 1;
-
-    mvsadcost [0] [0] = 300;
-    mvsadcost [1] [0] = 300;
-
-    do
-    {
-        double z = 256 * (2 * (log2f(2 * i) + .6));
-        mvsadcost [0][i] = (int) z;
-        mvsadcost [1][i] = (int) z;
-        mvsadcost [0][-i] = (int) z;
-        mvsadcost [1][-i] = (int) z;
-    }
-    while (++i <= mv_max);
-}
-
-VP8_PTR vp8_create_compressor(VP8_CONFIG *oxcf)
+// Sets up the state of a new stream: entropy contexts, rate control,
+// reference buffers and the statistics gathered while encoding. Used both
+// when creating the compressor and when resetting it for a new stream, so
+// everything here must assume a previous stream may have run.
+static void init_stream_state(VP8_COMP *cpi)
 {
+    VP8_COMMON *cm = &cpi->common;
     int i;
-    volatile union
-    {
-        VP8_COMP *cpi;
-        VP8_PTR   ptr;
-    } ctx;
 
-    VP8_COMP *cpi;
-    VP8_COMMON *cm;
+    // Default entropy contexts
+    vp8_default_coef_probs(cm);
+    vp8_init_mbmode_probs(cm);
+    vp8_default_bmode_probs(cm->fc.bmode_prob);
+    vpx_memcpy(cm->fc.mvc, vp8_default_mv_context, sizeof(vp8_default_mv_context));
+    vpx_memcpy(&cm->lfc, &cm->fc, sizeof(cm->fc));
 
-    cpi = ctx.cpi = vpx_memalign(32, sizeof(VP8_COMP));
-    // Check that the CPI instance is valid
-    if (!cpi)
-        return 0;
+    // Reference buffers and the per MB state carried between frames
+    cm->new_fb_idx = 0;
+    cm->lst_fb_idx = 1;
+    cm->gld_fb_idx = 2;
+    cm->alt_fb_idx = 3;
 
-    cm = &cpi->common;
+    for (i = 0; i < NUM_YV12_BUFFERS; i++)
+        cm->fb_idx_ref_cnt[i] = 1;
 
-    vpx_memset(cpi, 0, sizeof(VP8_COMP));
+    vpx_memset(cm->ref_frame_sign_bias, 0, sizeof(cm->ref_frame_sign_bias));
+    cm->copy_buffer_to_gf = 0;
+    cm->copy_buffer_to_arf = 0;
+    cm->frames_since_golden = 0;
+    cm->frame_type = KEY_FRAME;
+    cm->filter_level = 0;
 
-    if (setjmp(cm->error.jmp))
-    {
-        VP8_PTR ptr = ctx.ptr;
+    vpx_memset(cm->mip, 0, (cm->mb_cols + 1) * (cm->mb_rows + 1) * sizeof(MODE_INFO));
+    vpx_memset(cpi->segmentation_map, 0, cm->mb_rows * cm->mb_cols);
+    vpx_memset(cpi->active_map, 1, cm->mb_rows * cm->mb_cols);
+    cpi->active_map_enabled = 0;
 
-        ctx.cpi->common.error.setjmp = 0;
-        vp8_remove_compressor(&ptr);
-        return 0;
-    }
+    vpx_memset(cpi->gf_active_flags, 0, cm->mb_rows * cm->mb_cols);
+    cpi->gf_active_count = cm->mb_rows * cm->mb_cols;
+    cpi->inter_zz_count = 0;
+    cpi->gf_bad_count = 0;
+    cpi->gf_update_recommended = 0;
 
-    cpi->common.error.setjmp = 1;
+    // Should we use the cyclic refresh method.
+    // Currently this is tied to error resilliant mode
+    cpi->cyclic_refresh_mode_enabled = cpi->oxcf.error_resilient_mode;
+    cpi->cyclic_refresh_mode_max_mbs_perframe = (cm->mb_rows * cm->mb_cols) / 40;
+    cpi->cyclic_refresh_mode_index = 0;
+    cpi->cyclic_refresh_q = 32;
 
-    CHECK_MEM_ERROR(cpi->rdtok, vpx_calloc(256 * 3 / 2, sizeof(TOKENEXTRA)));
-    CHECK_MEM_ERROR(cpi->mb.ss, vpx_calloc(sizeof(search_site), (MAX_MVSEARCH_STEPS * 8) + 1));
+    if (cpi->cyclic_refresh_map)
+        vpx_memset(cpi->cyclic_refresh_map, 0, cm->mb_rows * cm->mb_cols);
 
-    vp8_create_common(&cpi->common);
-    vp8_cmachine_specific_config(cpi);
+    // Assume 4 bits per MB of modes, motion vectors and frame header until
+    // the first capped frames have been coded.
+    cpi->row_rc_active = 0;
+    cpi->row_rc_segmentation = 0;
+    cpi->row_rc_mode_rate[KEY_FRAME] = 4 << 8;
+    cpi->row_rc_mode_rate[INTER_FRAME] = 4 << 8;
+    cpi->row_rc_frame_bits[KEY_FRAME] = 0;
+    cpi->row_rc_frame_bits[INTER_FRAME] = 0;
 
-    vp8_init_config((VP8_PTR)cpi, oxcf);
+    // Rate control and source buffer state left behind by a previous stream
+    cpi->source_buffer_count = 0;
+    cpi->is_src_frame_alt_ref = 0;
+    cpi->is_next_src_alt_ref = 0;
+    cpi->last_alt_ref_sei = -1;
+    cpi->one_pass_frame_index = 0;
+    vp8_zero(cpi->one_pass_frame_stats);
+    cpi->last_time_stamp_seen = 0;
+    cpi->next_key = 0;
+
+    cpi->this_frame_target = 0;
+    cpi->projected_frame_size = 0;
+    cpi->last_key_frame_size = 0;
+    cpi->current_gf_interval = 0;
+    cpi->gf_group_bits = 0;
+    cpi->gf_bits = 0;
+    cpi->mid_gf_extra_bits = 0;
+    cpi->kf_group_bits = 0;
+    cpi->kf_group_error_left = 0;
+    cpi->kf_bits = 0;
+    cpi->gf_group_error_left = 0;
+    cpi->initial_gf_use = 0;
+    cpi->frames_to_key = 0;
+    cpi->gfu_boost = 0;
+    cpi->kf_boost = 0;
+    cpi->last_boost = 0;
+    cpi->zbin_over_quant = 0;
+    cpi->zbin_mode_boost = 0;
+    cpi->decimation_factor = 0;
+    cpi->decimation_count = 0;
+    cpi->prob_skip_false = 0;
+    vp8_zero(cpi->last_skip_false_probs);
+    vp8_zero(cpi->last_skip_probs_q);
+    vp8_zero(cpi->count_mb_ref_frame_usage);
+    cpi->this_frame_percent_intra = 0;
+    cpi->last_frame_percent_intra = 0;
+    cpi->last_key_frame_q = 0;
+    cpi->last_kffilt_lvl = 0;
+    cpi->last_auto_filt_val = 0;
+    cpi->last_auto_filt_q = 0;
+    cpi->frames_since_auto_filter = 0;
+    cpi->prediction_error = 0;
+    cpi->last_prediction_error = 0;
+    cpi->intra_error = 0;
+    cpi->last_intra_error = 0;
+    cpi->last_auto_filter_prediction_error = 0;
+    cpi->skip_true_count = 0;
+    cpi->skip_false_count = 0;
+    cpi->alt_qcount = 0;
+    cpi->next_iiratio = 0;
+    cpi->this_iiratio = 0;
+    cpi->section_is_low_motion = 0;
+    cpi->section_benefits_from_aggresive_q = 0;
+    cpi->section_is_fast_motion = 0;
+    cpi->section_intra_rating = 0;
+    cpi->first_pass_done = 0;
+    cpi->fixed_mode_recode = 0;
+    cpi->mbs_tested_so_far = 0;
+    vp8_zero(cpi->mode_check_freq);
+    vp8_zero(cpi->mode_test_hit_counts);
+    vp8_zero(cpi->mode_chosen_counts);
+    vp8_zero(cpi->do_full);
+    vp8_zero(cpi->error_bins);
 
     memcpy(cpi->base_skip_false_prob, vp8cx_base_skip_false_prob, sizeof(vp8cx_base_skip_false_prob));
     cpi->common.current_video_frame   = 0;
@@ -2145,63 +2436,6 @@ VP8_PTR vp8_create_compressor(VP8_CONFIG *oxcf)
     cpi->alt_is_last  = 0 ;
     cpi->gold_is_alt  = 0 ;
 
-
-
-    // Create the encoder segmentation map and set all entries to 0
-    CHECK_MEM_ERROR(cpi->segmentation_map, vpx_calloc(cpi->common.mb_rows * cpi->common.mb_cols, 1));
-    CHECK_MEM_ERROR(cpi->active_map, vpx_calloc(cpi->common.mb_rows * cpi->common.mb_cols, 1));
-    vpx_memset(cpi->active_map , 1, (cpi->common.mb_rows * cpi->common.mb_cols));
-    cpi->active_map_enabled = 0;
-
-    // Create the first pass motion map structure and set to 0
-    // Allocate space for maximum of 15 buffers
-    CHECK_MEM_ERROR(cpi->fp_motion_map, vpx_calloc(15*cpi->common.MBs, 1));
-
-#if 0
-    // Experimental code for lagged and one pass
-    // Initialise one_pass GF frames stats
-    // Update stats used for GF selection
-    if (cpi->pass == 0)
-    {
-        cpi->one_pass_frame_index = 0;
-
-        for (i = 0; i < MAX_LAG_BUFFERS; i++)
-        {
-            cpi->one_pass_frame_stats[i].frames_so_far = 0;
-            cpi->one_pass_frame_stats[i].frame_intra_error = 0.0;
-            cpi->one_pass_frame_stats[i].frame_coded_error = 0.0;
-            cpi->one_pass_frame_stats[i].frame_pcnt_inter = 0.0;
-            cpi->one_pass_frame_stats[i].frame_pcnt_motion = 0.0;
-            cpi->one_pass_frame_stats[i].frame_mvr = 0.0;
-            cpi->one_pass_frame_stats[i].frame_mvr_abs = 0.0;
-            cpi->one_pass_frame_stats[i].frame_mvc = 0.0;
-            cpi->one_pass_frame_stats[i].frame_mvc_abs = 0.0;
-        }
-    }
-#endif
-
-    // Should we use the cyclic refresh method.
-    // Currently this is tied to error resilliant mode
-    cpi->cyclic_refresh_mode_enabled = cpi->oxcf.error_resilient_mode;
-    cpi->cyclic_refresh_mode_max_mbs_perframe = (cpi->common.mb_rows * cpi->common.mb_cols) / 40;
-    cpi->cyclic_refresh_mode_index = 0;
-    cpi->cyclic_refresh_q = 32;
-
-    if (cpi->cyclic_refresh_mode_enabled)
-    {
-        CHECK_MEM_ERROR(cpi->cyclic_refresh_map, vpx_calloc((cpi->common.mb_rows * cpi->common.mb_cols), 1));
-    }
-    else
-        cpi->cyclic_refresh_map = (signed char *) NULL;
-
-    // Test function for segmentation
-    //segmentation_test_function((VP8_PTR) cpi);
-
-#ifdef ENTROPY_STATS
-    init_context_counters();
-#endif
-
-
     cpi->frames_since_key = 8;        // Give a sensible default for the first frame.
     cpi->key_frame_frequency = cpi->oxcf.key_freq;
 
@@ -2266,14 +2500,6 @@ VP8_PTR vp8_create_compressor(VP8_CONFIG *oxcf)
     cpi->key_frame_rate_correction_factor = 1.0;
     cpi->gf_rate_correction_factor  = 1.0;
     cpi->est_max_qcorrection_factor  = 1.0;
-
-    cpi->mb.mvcost[0] = &cpi->mb.mvcosts[0][mv_max+1];
-    cpi->mb.mvcost[1] = &cpi->mb.mvcosts[1][mv_max+1];
-    cpi->mb.mvsadcost[0] = &cpi->mb.mvsadcosts[0][mv_max+1];
-    cpi->mb.mvsadcost[1] = &cpi->mb.mvsadcosts[1][mv_max+1];
-
-    cal_mvsadcosts(cpi->mb.mvsadcost);
-
     for (i = 0; i < KEY_FRAME_CONTEXT; i++)
     {
         cpi->prior_key_frame_size[i]     = cpi->intra_frame_target;
@@ -2282,17 +2508,7 @@ VP8_PTR vp8_create_compressor(VP8_CONFIG *oxcf)
 
     cpi->check_freq[0] = 15;
     cpi->check_freq[1] = 15;
-
-#ifdef OUTPUT_YUV_SRC
-    yuv_file = fopen("bd.yuv", "ab");
-#endif
-
-#if 0
-    framepsnr = fopen("framepsnr.stt", "a");
-    kf_list = fopen("kf_list.stt", "w");
-#endif
-
-    cpi->output_pkt_list = oxcf->output_pkt_list;
+    cpi->output_pkt_list = cpi->oxcf.output_pkt_list;
 
 #if !(CONFIG_REALTIME_ONLY)
 
@@ -2303,9 +2519,9 @@ VP8_PTR vp8_create_compressor(VP8_CONFIG *oxcf)
     else if (cpi->pass == 2)
     {
         size_t packet_sz = vp8_firstpass_stats_sz(cpi->common.MBs);
-        int packets = oxcf->two_pass_stats_in.sz / packet_sz;
+        int packets = cpi->oxcf.two_pass_stats_in.sz / packet_sz;
 
-        cpi->stats_in = oxcf->two_pass_stats_in.buf;
+        cpi->stats_in = cpi->oxcf.two_pass_stats_in.buf;
         cpi->stats_in_end = (void*)((char *)cpi->stats_in
                             + (packets - 1) * packet_sz);
         vp8_init_second_pass(cpi);
@@ -2318,6 +2534,7 @@ VP8_PTR vp8_create_compressor(VP8_CONFIG *oxcf)
         cpi->cpu_freq            = 0; //vp8_get_processor_freq();
         cpi->avg_encode_time      = 0;
         cpi->avg_pick_mode_time    = 0;
+        cpi->avg_frame_overhead_time = 0;
     }
 
     vp8_set_speed_features(cpi);
@@ -2327,6 +2544,123 @@ VP8_PTR vp8_create_compressor(VP8_CONFIG *oxcf)
     {
         cpi->rd_thresh_mult[i] = 128;
     }
+    cpi->ready_for_new_frame = 1;
+
+    cpi->source_encode_index = 0;
+
+    // make sure frame 1 is okay
+    cpi->error_bins[0] = cpi->common.MBs;
+    vp8_init_loop_filter(cm);
+    cm->last_frame_type = KEY_FRAME;
+    cm->last_filter_type = cm->filter_type;
+    cm->last_sharpness_level = cm->sharpness_level;
+
+}
+
+VP8_PTR vp8_create_compressor(VP8_CONFIG *oxcf)
+{
+    int i;
+    volatile union
+    {
+        VP8_COMP *cpi;
+        VP8_PTR   ptr;
+    } ctx;
+
+    VP8_COMP *cpi;
+    VP8_COMMON *cm;
+
+    cpi = ctx.cpi = vpx_memalign(32, sizeof(VP8_COMP));
+    // Check that the CPI instance is valid
+    if (!cpi)
+        return 0;
+
+    cm = &cpi->common;
+
+    vpx_memset(cpi, 0, sizeof(VP8_COMP));
+
+    if (setjmp(cm->error.jmp))
+    {
+        VP8_PTR ptr = ctx.ptr;
+
+        ctx.cpi->common.error.setjmp = 0;
+        vp8_remove_compressor(&ptr);
+        return 0;
+    }
+
+    cpi->common.error.setjmp = 1;
+    vp8_initialize();
+
+    CHECK_MEM_ERROR(cpi->rdtok, vpx_calloc(256 * 3 / 2, sizeof(TOKENEXTRA)));
+    CHECK_MEM_ERROR(cpi->mb.ss, vpx_calloc(sizeof(search_site), (MAX_MVSEARCH_STEPS * 8) + 1));
+
+    vp8_create_common(&cpi->common);
+    vp8_cmachine_specific_config(cpi);
+
+    vp8_init_config((VP8_PTR)cpi, oxcf);
+
+    // Create the encoder segmentation map and set all entries to 0
+    CHECK_MEM_ERROR(cpi->segmentation_map, vpx_calloc(cpi->common.mb_rows * cpi->common.mb_cols, 1));
+    CHECK_MEM_ERROR(cpi->active_map, vpx_calloc(cpi->common.mb_rows * cpi->common.mb_cols, 1));
+
+    // Create the first pass motion map structure and set to 0
+    // Allocate space for maximum of 15 buffers
+    CHECK_MEM_ERROR(cpi->fp_motion_map, vpx_calloc(15*cpi->common.MBs, 1));
+
+#if 0
+    // Experimental code for lagged and one pass
+    // Initialise one_pass GF frames stats
+    // Update stats used for GF selection
+    if (cpi->pass == 0)
+    {
+        cpi->one_pass_frame_index = 0;
+
+        for (i = 0; i < MAX_LAG_BUFFERS; i++)
+        {
+            cpi->one_pass_frame_stats[i].frames_so_far = 0;
+            cpi->one_pass_frame_stats[i].frame_intra_error = 0.0;
+            cpi->one_pass_frame_stats[i].frame_coded_error = 0.0;
+            cpi->one_pass_frame_stats[i].frame_pcnt_inter = 0.0;
+            cpi->one_pass_frame_stats[i].frame_pcnt_motion = 0.0;
+            cpi->one_pass_frame_stats[i].frame_mvr = 0.0;
+            cpi->one_pass_frame_stats[i].frame_mvr_abs = 0.0;
+            cpi->one_pass_frame_stats[i].frame_mvc = 0.0;
+            cpi->one_pass_frame_stats[i].frame_mvc_abs = 0.0;
+        }
+    }
+#endif
+
+    // The cyclic refresh method is tied to error resilient mode
+    if (cpi->oxcf.error_resilient_mode)
+    {
+        CHECK_MEM_ERROR(cpi->cyclic_refresh_map, vpx_calloc((cpi->common.mb_rows * cpi->common.mb_cols), 1));
+    }
+    else
+        cpi->cyclic_refresh_map = (signed char *) NULL;
+
+    // Test function for segmentation
+    //segmentation_test_function((VP8_PTR) cpi);
+
+#ifdef ENTROPY_STATS
+    init_context_counters();
+#endif
+
+
+
+    cpi->mb.mvcost[0] = &cpi->mb.mvcosts[0][mv_max+1];
+    cpi->mb.mvcost[1] = &cpi->mb.mvcosts[1][mv_max+1];
+    cpi->mb.mvsadcost[0] = &mvsadcosts[0][mv_max+1];
+    cpi->mb.mvsadcost[1] = &mvsadcosts[1][mv_max+1];
+
+
+#ifdef OUTPUT_YUV_SRC
+    yuv_file = fopen("bd.yuv", "ab");
+#endif
+
+#if 0
+    framepsnr = fopen("framepsnr.stt", "a");
+    kf_list = fopen("kf_list.stt", "w");
+#endif
+
 
 #ifdef ENTROPY_STATS
     init_mv_ref_counts();
@@ -2384,28 +2718,66 @@ VP8_PTR vp8_create_compressor(VP8_CONFIG *oxcf)
 #endif
     cpi->diamond_search_sad = SEARCH_INVOKE(&cpi->rtcd.search, diamond_search);
 
-    cpi->ready_for_new_frame = 1;
-
-    cpi->source_encode_index = 0;
-
-    // make sure frame 1 is okay
-    cpi->error_bins[0] = cpi->common.MBs;
+    init_stream_state(cpi);
 
     //vp8cx_init_quantizer() is first called here. Add check in vp8cx_frame_init_quantizer() so that vp8cx_init_quantizer is only called later
     //when needed. This will avoid unnecessary calls of vp8cx_init_quantizer() for every frame.
     vp8cx_init_quantizer(cpi);
-    {
-        vp8_init_loop_filter(cm);
-        cm->last_frame_type = KEY_FRAME;
-        cm->last_filter_type = cm->filter_type;
-        cm->last_sharpness_level = cm->sharpness_level;
-    }
     cpi->common.error.setjmp = 0;
     return (VP8_PTR) cpi;
 
 }
 
 
+int vp8_reset_compressor(VP8_PTR ptr, VP8_CONFIG *oxcf)
+{
+    VP8_COMP *cpi = (VP8_COMP *)(ptr);
+    VP8_COMMON *cm;
+    int lag_in_frames;
+
+    if (!cpi || !oxcf)
+        return -1;
+
+    cm = &cpi->common;
+
+    // The segment and motion maps, lag buffers and encoding threads were
+    // sized for the stream this instance was created for. A stream that
+    // doesn't fit them needs a new instance.
+    lag_in_frames = oxcf->lag_in_frames;
+
+    if (lag_in_frames > MAX_LAG_BUFFERS)
+        lag_in_frames = MAX_LAG_BUFFERS;
+
+    if (oxcf->Width != cpi->oxcf.Width || oxcf->Height != cpi->oxcf.Height
+        || oxcf->multi_threaded != cpi->oxcf.multi_threaded
+        || lag_in_frames > cpi->oxcf.lag_in_frames)
+        return -1;
+
+    if (setjmp(cm->error.jmp))
+    {
+        cm->error.setjmp = 0;
+        return -1;
+    }
+
+    cm->error.setjmp = 1;
+
+    // Allocate before touching the configuration, so that a failure leaves
+    // the instance set up for the previous stream.
+    if (oxcf->error_resilient_mode && !cpi->cyclic_refresh_map)
+        CHECK_MEM_ERROR(cpi->cyclic_refresh_map, vpx_calloc((cm->mb_rows * cm->mb_cols), 1));
+
+    // Undo any vp8_set_internal_size() of the previous stream
+    cpi->horiz_scale = 0;
+    cpi->vert_scale = 0;
+
+    vp8_init_config(ptr, oxcf);
+    init_stream_state(cpi);
+
+    cm->error.setjmp = 0;
+    return 0;
+}
+
+
 void vp8_remove_compressor(VP8_PTR *ptr)
 {
     VP8_COMP *cpi = (VP8_COMP *)(*ptr);
@@ -3022,6 +3394,10 @@ static int pick_frame_size(VP8_COMP *cpi)
         }
     }
 
+    // A frame can not be planned larger than the size cap allows
+    if (cpi->oxcf.max_frame_size && cpi->this_frame_target > frame_size_cap_bits(cpi))
+        cpi->this_frame_target = frame_size_cap_bits(cpi);
+
     // Note target_size in bits * 256 per MB
     cpi->target_bits_per_mb = (cpi->this_frame_target * 256) / cpi->common.MBs;
 
@@ -3502,7 +3878,9 @@ static void encode_frame_to_data_rate
     // For two pass with auto key frame enabled cm->frame_type may already be set, but not for one pass.
     if ((cm->current_video_frame == 0) ||
         (cm->frame_flags & FRAMEFLAGS_KEY) ||
-        (cpi->oxcf.auto_key && (cpi->frames_since_key % cpi->key_frame_frequency == 0)))
+        (cpi->oxcf.auto_key && (cpi->frames_since_key % cpi->key_frame_frequency == 0)) ||
+        (cpi->oxcf.auto_key && ONE_PASS_LOOKAHEAD(cpi) && !cm->refresh_alt_ref_frame &&
+         cpi->one_pass_frame_stats[cpi->one_pass_frame_index].scene_cut))
     {
         // Key frame from VFW/auto-keyframe/first frame
         cm->frame_type = KEY_FRAME;
@@ -3765,10 +4143,6 @@ static void encode_frame_to_data_rate
     else
         zbin_oq_high = ZBIN_OQ_MAX;
 
-    // Setup background Q adjustment for error resilliant mode
-    if (cpi->cyclic_refresh_mode_enabled)
-        cyclic_background_refresh(cpi, Q, 0);
-
     vp8_compute_frame_size_bounds(cpi, &frame_under_shoot_limit, &frame_over_shoot_limit);
 
     // Limit Q range for the adaptive loop (Values not clipped to range 20-60 as in VP8).
@@ -3842,6 +4216,28 @@ static void encode_frame_to_data_rate
     vp8_write_yuv_frame(cpi->Source);
 #endif
 
+    // Gather the per MB source statistics used by the mode decision. Done
+    // after any denoising, so they describe the frame actually coded.
+    vp8_analyse_source_mbs(cpi);
+
+    // Hold the frame under the size cap by raising Q row by row instead of
+    // recoding. This needs the segmentation, so it gives way to an ROI map
+    // and replaces the background refresh.
+    cpi->row_rc_active = 0;
+
+    if (cpi->oxcf.max_frame_size &&
+        (cpi->row_rc_segmentation || !cpi->mb.e_mbd.segmentation_enabled))
+        Q = setup_row_rate_control(cpi, Q);
+    else if (cpi->row_rc_segmentation)
+    {
+        disable_segmentation((VP8_PTR)cpi);
+        cpi->row_rc_segmentation = 0;
+    }
+
+    // Setup background Q adjustment for error resilliant mode
+    if (cpi->cyclic_refresh_mode_enabled && !cpi->row_rc_active)
+        cyclic_background_refresh(cpi, Q, 0);
+
     do
     {
         vp8_clear_system_state();  //__asm emms;
@@ -3937,12 +4333,18 @@ static void encode_frame_to_data_rate
 
         // Test to see if the stats generated for this frame indicate that we should have coded a key frame
         // (assuming that we didn't)!
-        if (cpi->pass != 2 && cpi->oxcf.auto_key && cm->frame_type != KEY_FRAME)
+        // One pass lagged encodes have already placed key frames at the scene
+        // cuts found by the lookahead analysis.
+        if (cpi->pass != 2 && cpi->oxcf.auto_key && cm->frame_type != KEY_FRAME
+            && !ONE_PASS_LOOKAHEAD(cpi))
         {
             if (decide_key_frame(cpi))
             {
                 vp8_calc_auto_iframe_target_size(cpi);
 
+                if (cpi->oxcf.max_frame_size && cpi->this_frame_target > frame_size_cap_bits(cpi))
+                    cpi->this_frame_target = frame_size_cap_bits(cpi);
+
                 // Reset all our sizing numbers and recode
                 cm->frame_type = KEY_FRAME;
 
@@ -3961,8 +4363,15 @@ static void encode_frame_to_data_rate
 
                 vp8_restore_coding_context(cpi);
 
+                // The first pass modes were chosen for an inter frame
+                cpi->fixed_mode_recode = 0;
+
                 Q = vp8_regulate_q(cpi, cpi->this_frame_target);
 
+                // setup_features() cleared the segmentation
+                if (cpi->row_rc_active)
+                    Q = setup_row_rate_control(cpi, Q);
+
                 q_low  = cpi->best_quality;
                 q_high = cpi->worst_quality;
 
@@ -4011,12 +4420,13 @@ static void encode_frame_to_data_rate
 #if !(CONFIG_REALTIME_ONLY)
 
         // Is the projected frame size out of range and are we allowed to attempt to recode.
-        if (((cpi->sf.recode_loop == 1) ||
+        // Frames under the size cap are never recoded.
+        if (!cpi->row_rc_active &&
+            ((cpi->sf.recode_loop == 1) ||
              ((cpi->sf.recode_loop == 2) && (cm->refresh_golden_frame || (cm->frame_type == KEY_FRAME)))) &&
             (((cpi->projected_frame_size > frame_over_shoot_limit) && (Q < top_index)) ||
              //((cpi->projected_frame_size > frame_over_shoot_limit ) && (Q == top_index) && (cpi->zbin_over_quant < ZBIN_OQ_MAX)) ||
-             ((cpi->projected_frame_size < frame_under_shoot_limit) && (Q > bottom_index)))
-           )
+             ((cpi->projected_frame_size < frame_under_shoot_limit) && (Q > bottom_index))))
         {
             int last_q = Q;
             int Retries = 0;
@@ -4134,10 +4544,16 @@ static void encode_frame_to_data_rate
 #if CONFIG_PSNR
             cpi->tot_recode_hits++;
 #endif
+
+            // Only the quantizer changes, so optionally skip mode selection
+            // and motion search and re-encode with the existing MODE_INFO.
+            cpi->fixed_mode_recode = cpi->sf.recode_fixed_modes;
         }
     }
     while (Loop == TRUE);
 
+    cpi->fixed_mode_recode = 0;
+
 #if 0
     // Experimental code for lagged and one pass
     // Update stats used for one pass GF selection
@@ -4167,6 +4583,8 @@ static void encode_frame_to_data_rate
     if (cm->frame_type == KEY_FRAME)
         cm->refresh_last_frame = 1;
 
+    cpi->frame_stats.recodes = loop_count;
+
 #if 0
     {
         FILE *f = fopen("gfactive.stt", "a");
@@ -4210,6 +4628,7 @@ static void encode_frame_to_data_rate
             vpx_usec_timer_mark(&timer);
 
             cpi->time_pick_lpf +=  vpx_usec_timer_elapsed(&timer);
+            cpi->frame_stats.pick_lpf += vpx_usec_timer_elapsed64(&timer);
 
             if (cm->no_lpf)
                 cm->filter_level = 0;
@@ -4233,8 +4652,14 @@ static void encode_frame_to_data_rate
         }
 //#pragma omp section
         {
+            struct vpx_usec_timer timer;
+
             // build the bitstream
+            vpx_usec_timer_start(&timer);
             vp8_pack_bitstream(cpi, dest, size);
+            vpx_usec_timer_mark(&timer);
+
+            cpi->frame_stats.pack += vpx_usec_timer_elapsed64(&timer);
         }
     }
 
@@ -4287,7 +4712,36 @@ static void encode_frame_to_data_rate
     cpi->total_byte_count += (*size);
     cpi->projected_frame_size = (*size) << 3;
 
-    if (!active_worst_qchanged)
+    if (cpi->row_rc_active)
+    {
+        // Learn the cost per MB of everything but the coefficient tokens.
+        // Increases are taken at once and decreases slowly, as the estimate
+        // has to cover the costlier frames.
+        int *mode_rate = &cpi->row_rc_mode_rate[cm->frame_type];
+        int other_rate = (int)((cpi->projected_frame_size - cpi->row_rc_token_bits) * 256.0 / cm->MBs);
+
+        if (other_rate < 0)
+            other_rate = 0;
+
+        if (other_rate > *mode_rate)
+            *mode_rate = other_rate;
+        else
+            *mode_rate = (*mode_rate * 7 + other_rate + 4) >> 3;
+
+        // What the frame would have taken at its frame Q, for the Q of the
+        // next one. The estimate of the rows is corrected by the real size.
+        if (cpi->row_rc_spent > 0)
+        {
+            cpi->row_rc_frame_bits[cm->frame_type] =
+                cpi->row_rc_base_spent * cpi->projected_frame_size / cpi->row_rc_spent;
+            cpi->row_rc_frame_q[cm->frame_type] = cpi->row_rc_q[0];
+        }
+    }
+
+    // The frame size says little about the frame Q if rows were coded at a
+    // higher one
+    if (!active_worst_qchanged &&
+        !(cpi->row_rc_active && cpi->row_rc_base_spent > cpi->row_rc_spent))
         vp8_update_rate_correction_factors(cpi, 2);
 
     cpi->last_q[cm->frame_type] = cm->base_qindex;
@@ -4742,6 +5196,21 @@ int vp8_receive_raw_frame(VP8_PTR ptr, unsigned int frame_flags, YV12_BUFFER_CON
         s->source_frame_flags = frame_flags;
         vp8_yv12_copy_frame_ptr(sd, &s->source_buffer);
 
+        if (ONE_PASS_LOOKAHEAD(cpi))
+        {
+            // Compare against the previously buffered frame, if still held
+            int last_buffer = (which_buffer + cpi->oxcf.lag_in_frames - 1) % cpi->oxcf.lag_in_frames;
+
+            if (cpi->source_buffer_count)
+                vp8_lookahead_frame_stats(cpi, &s->source_buffer,
+                                          &cpi->src_buffer[last_buffer].source_buffer,
+                                          &cpi->one_pass_frame_stats[last_buffer],
+                                          &cpi->one_pass_frame_stats[which_buffer]);
+            else
+                vp8_lookahead_frame_stats(cpi, &s->source_buffer, NULL, NULL,
+                                          &cpi->one_pass_frame_stats[which_buffer]);
+        }
+
         cpi->source_buffer_count ++;
     }
     else
@@ -4808,6 +5277,7 @@ int vp8_get_compressed_data(VP8_PTR ptr, unsigned int *frame_flags, unsigned lon
 
     vpx_usec_timer_start(&cmptimer);
 
+    vpx_memset(&cpi->frame_stats, 0, sizeof(cpi->frame_stats));
 
     // flush variable tells us that even though we have less than 10 frames
     // in our buffer we need to start producing compressed frames.
@@ -4914,6 +5384,8 @@ int vp8_get_compressed_data(VP8_PTR ptr, unsigned int *frame_flags, unsigned lon
 
             if (cpi->oxcf.allow_lag)
             {
+                cpi->one_pass_frame_index = cpi->source_encode_index;
+
                 if (cpi->source_encode_index ==  cpi->last_alt_ref_sei)
                 {
                     cpi->is_src_frame_alt_ref = 1;
@@ -5069,10 +5541,21 @@ int vp8_get_compressed_data(VP8_PTR ptr, unsigned int *frame_flags, unsigned lon
 
         if (cm->frame_type != KEY_FRAME)
         {
+            // The part of the frame's time the MB row scheduler can not save
+            int overhead = (int)duration - cpi->last_mb_row_time;
+
+            if (overhead < 0)
+                overhead = 0;
+
             if (cpi->avg_encode_time == 0)
                 cpi->avg_encode_time = duration;
             else
                 cpi->avg_encode_time = (7 * cpi->avg_encode_time + duration) >> 3;
+
+            if (cpi->avg_frame_overhead_time == 0)
+                cpi->avg_frame_overhead_time = overhead;
+            else
+                cpi->avg_frame_overhead_time = (7 * cpi->avg_frame_overhead_time + overhead) >> 3;
         }
 
         if (duration2)
@@ -5111,6 +5594,8 @@ int vp8_get_compressed_data(VP8_PTR ptr, unsigned int *frame_flags, unsigned lon
 
     vpx_usec_timer_mark(&cmptimer);
     cpi->time_compress_data += vpx_usec_timer_elapsed(&cmptimer);
+    cpi->frame_stats.frames = 1;
+    cpi->frame_stats.total = vpx_usec_timer_elapsed64(&cmptimer);
 
     if (cpi->b_calculate_psnr && cpi->pass != 1 && cm->show_frame)
         generate_psnr_packet(cpi);
@@ -5259,6 +5744,7 @@ int vp8_set_roimap(VP8_PTR comp, unsigned char *map, unsigned int rows, unsigned
 
     // Activate segmentation.
     enable_segmentation((VP8_PTR)cpi);
+    cpi->row_rc_segmentation = 0;
 
     // Set up the quant segment data
     feature_data[MB_LVL_ALT_Q][0] = delta_q[0];
@@ -5324,6 +5810,54 @@ int vp8_set_internal_size(VP8_PTR comp, VPX_SCALING horiz_mode, VPX_SCALING vert
     return 0;
 }
 
+void vp8_set_simulcast_parent(VP8_PTR comp, VP8_PTR parent)
+{
+    VP8_COMP *cpi = (VP8_COMP *) comp;
+
+    cpi->simulcast_parent = parent;
+}
+
+// Looks up the macroblock of the parent (higher resolution) layer that
+// covers the centre of the current macroblock. If it was inter coded from
+// the same reference frame, returns 1 and its motion vector scaled to this
+// layer's resolution.
+int vp8_simulcast_mv_hint(VP8_COMP *cpi, MACROBLOCKD *xd, int ref_frame, MV *mv)
+{
+    VP8_COMP *parent = (VP8_COMP *) cpi->simulcast_parent;
+    VP8_COMMON *cm = &cpi->common;
+    VP8_COMMON *pcm;
+    MODE_INFO *pmi;
+    int mb_row, mb_col, prow, pcol;
+
+    if (!parent)
+        return 0;
+
+    pcm = &parent->common;
+
+    mb_row = -xd->mb_to_top_edge >> 7;
+    mb_col = -xd->mb_to_left_edge >> 7;
+
+    prow = ((mb_row * 16 + 8) * pcm->Height / cm->Height) >> 4;
+    pcol = ((mb_col * 16 + 8) * pcm->Width / cm->Width) >> 4;
+
+    if (prow >= pcm->mb_rows)
+        prow = pcm->mb_rows - 1;
+
+    if (pcol >= pcm->mb_cols)
+        pcol = pcm->mb_cols - 1;
+
+    pmi = pcm->mi + prow * pcm->mode_info_stride + pcol;
+
+    if (pmi->mbmi.ref_frame != ref_frame)
+        return 0;
+
+    mv->row = pmi->mbmi.mv.as_mv.row * cm->Height / pcm->Height;
+    mv->col = pmi->mbmi.mv.as_mv.col * cm->Width / pcm->Width;
+    vp8_clamp_mv(mv, xd);
+
+    return 1;
+}
+
 
 
 int vp8_calc_ss_err(YV12_BUFFER_CONFIG *source, YV12_BUFFER_CONFIG *dest, const vp8_variance_rtcd_vtable_t *rtcd)
@@ -5388,3 +5922,73 @@ int vp8_get_quantizer(VP8_PTR c)
     VP8_COMP   *cpi = (VP8_COMP *) c;
     return cpi->common.base_qindex;
 }
+
+void vp8_set_frame_stats(VP8_PTR comp, int enable)
+{
+    VP8_COMP *cpi = (VP8_COMP *) comp;
+
+    // Threads pick the flag up from cpi->mb with the rest of its setup
+    cpi->mb.collect_stats = enable;
+}
+
+void vp8_get_frame_stats(VP8_PTR comp, vp8e_frame_stats_t *stats)
+{
+    VP8_COMP *cpi = (VP8_COMP *) comp;
+
+    *stats = cpi->frame_stats;
+}
+
+void vp8_get_memory_usage(VP8_PTR comp, vp8_memory_usage_t *usage)
+{
+    VP8_COMP *cpi = (VP8_COMP *) comp;
+    VP8_COMMON *cm = &cpi->common;
+    size_t mbs = cm->mb_rows * cm->mb_cols;
+    int i;
+
+    vpx_memset(usage, 0, sizeof(*usage));
+    vp8_common_memory_usage(cm, usage);
+
+    usage->context = sizeof(VP8_COMP);
+
+    usage->frame_buffers += vp8_frame_buffer_bytes(&cpi->last_frame_uf);
+    usage->frame_buffers += vp8_frame_buffer_bytes(&cpi->scaled_source);
+
+    for (i = 0; i < MAX_LAG_BUFFERS; i++)
+        usage->lag_buffers += vp8_frame_buffer_bytes(&cpi->src_buffer[i].source_buffer);
+
+#if VP8_TEMPORAL_ALT_REF
+    usage->lag_buffers += vp8_frame_buffer_bytes(&cpi->alt_ref_buffer.source_buffer);
+#endif
+
+    if (cpi->mb.pip)
+        usage->mode_info += (cm->mb_cols + 1) * (cm->mb_rows + 1) * sizeof(PARTITION_INFO);
+
+    if (cpi->tok)
+        usage->tokens += mbs * 24 * 16 * sizeof(*cpi->tok);
+
+    usage->tokens += 256 * 3 / 2 * sizeof(*cpi->rdtok);
+    usage->tokens += cm->mb_rows * sizeof(*cpi->tplist);
+
+    // segmentation, active, gf active and motion maps
+    usage->analysis += mbs * 3 + 15 * cm->MBs;
+    usage->analysis += cm->mode_info_stride * cm->mb_rows;
+    usage->analysis += mbs * sizeof(*cpi->mb_analysis);
+    usage->analysis += 2 * vp8_firstpass_stats_sz(cm->MBs);
+    usage->analysis += ((MAX_MVSEARCH_STEPS * 8) + 1) * sizeof(search_site);
+
+    if (cpi->cyclic_refresh_map)
+        usage->analysis += mbs;
+
+#if CONFIG_MULTITHREAD
+
+    if (cpi->b_multi_threaded)
+        usage->threading = cpi->encoding_thread_count
+                           * (sizeof(pthread_t) + sizeof(sem_t)
+                              + sizeof(MB_ROW_COMP) + sizeof(ENCODETHREAD_DATA));
+
+#endif
+
+    usage->total = usage->context + usage->frame_buffers + usage->lag_buffers
+                   + usage->mode_info + usage->tokens + usage->analysis
+                   + usage->threading + usage->bitstream;
+}
@@ -37,6 +37,11 @@
 
 #define MAX_LAG_BUFFERS (CONFIG_REALTIME_ONLY? 1 : 25)
 
+// One pass encodes with a lookahead buffer analyse the buffered frames to
+// drive key frame, golden frame and per frame rate decisions
+#define ONE_PASS_LOOKAHEAD(cpi) (!CONFIG_REALTIME_ONLY && (cpi)->pass == 0 \
+                                 && (cpi)->oxcf.allow_lag && (cpi)->oxcf.lag_in_frames > 1)
+
 #define AF_THRESH   25
 #define AF_THRESH2  100
 #define ARF_DECAY_THRESH 12
@@ -61,6 +66,7 @@ typedef struct
 
     MV_CONTEXT mvc[2];
     int mvcosts[2][MVvals+1];
+    MV_CONTEXT mvcost_mvc[2];
 
 #ifdef MODE_STATS
     // Stats
@@ -117,6 +123,7 @@ typedef struct
     double frame_mvr_abs;
     double frame_mvc;
     double frame_mvc_abs;
+    int scene_cut;
 
 } ONEPASS_FRAMESTATS;
 
@@ -169,6 +176,7 @@ typedef struct
     int improved_dct;
     int auto_filter;
     int recode_loop;
+    int recode_fixed_modes;
     int iterative_sub_pixel;
     int half_pixel_search;
     int quarter_pixel_search;
@@ -179,6 +187,8 @@ typedef struct
     int max_step_search_steps;
     int first_step;
     int optimize_coefficients;
+    int bpred_prescreen_modes;        // B_PRED modes kept for full RD after the SATD pre-screen (0 = all)
+    int split_search_pruning;         // Seed SPLITMV searches from larger partitions and skip unpromising 4x4
 
 } SPEED_FEATURES;
 
@@ -448,6 +458,13 @@ typedef struct
     //save vp8_tree_probs_from_distribution result for each frame to avoid repeat calculation
     vp8_prob frame_coef_probs [BLOCK_TYPES] [COEF_BANDS] [PREV_COEF_CONTEXTS] [vp8_coef_tokens-1];
     unsigned int frame_branch_ct [BLOCK_TYPES] [COEF_BANDS] [PREV_COEF_CONTEXTS] [vp8_coef_tokens-1][2];
+    //probability update decisions made by vp8_estimate_entropy_savings, written out by the bitstream packer
+    unsigned char coef_prob_update [BLOCK_TYPES] [COEF_BANDS] [PREV_COEF_CONTEXTS] [vp8_coef_tokens-1];
+
+    // Probabilities that mb.token_costs and mb.mvcosts were last built from,
+    // so only contexts whose probabilities changed need to be re-costed.
+    vp8_prob token_cost_probs [BLOCK_TYPES] [COEF_BANDS] [PREV_COEF_CONTEXTS] [vp8_coef_tokens-1];
+    MV_CONTEXT mvcost_mvc[2];
 
     /* Second compressed data partition contains coefficient data. */
 
@@ -480,11 +497,10 @@ typedef struct
 
     unsigned char *fp_motion_map_stats, *fp_motion_map_stats_save;
 
-#if 0
-    // Experimental code for lagged and one pass
+    // One pass lagged mode: analysis of each buffered source frame, indexed
+    // as src_buffer, and the buffer index of the frame being coded
     ONEPASS_FRAMESTATS one_pass_frame_stats[MAX_LAG_BUFFERS];
     int one_pass_frame_index;
-#endif
 
     int decimation_factor;
     int decimation_count;
@@ -492,6 +508,9 @@ typedef struct
     // for real time encoding
     int avg_encode_time;              //microsecond
     int avg_pick_mode_time;            //microsecond
+    int avg_frame_overhead_time;       //microsecond, outside the MB row loop
+    int last_mb_row_time;              //microsecond, MB row loop of the last frame
+    int mb_row_deadline;               //microsecond, allowed for this frame's MB rows (0 = unscheduled)
     int Speed;
     unsigned int cpu_freq;           //Mhz
     int compressor_speed;
@@ -576,11 +595,28 @@ typedef struct
     int cyclic_refresh_q;
     signed char *cyclic_refresh_map;
 
+    // In frame rate control holding each frame under oxcf.max_frame_size.
+    // Segments step the quantizer up from the frame Q and each MB row is
+    // given the lowest one that keeps the frame within budget.
+    int row_rc_active;                  // Controlling this frame
+    int row_rc_segmentation;            // The segmentation set up is ours
+    int row_rc_q[MAX_MB_SEGMENTS];      // Q index of each segment
+    int row_rc_budget;                  // Bits available for the frame
+    int row_rc_rows_done;               // Rows accounted for so far
+    int row_rc_spent;                   // Estimated bits of those rows
+    double row_rc_base_spent;           // ..scaled to the frame Q
+    int row_rc_token_bits;              // Token bits of those rows
+    int row_rc_mode_rate[2];            // Non token cost per MB by frame type (1/256 bit units)
+    double row_rc_frame_bits[2];        // Bits of the last capped frame of each type at its frame Q
+    int row_rc_frame_q[2];              // ..and that Q
+    double row_rc_row_bits;             // Expected bits of a row at the frame Q before any are coded
+
     // multithread data
     int current_mb_col_main;
     int processor_core_count;
     int b_multi_threaded;
     int encoding_thread_count;
+    int batch_thread_count;             // Threads given a row in each batch of rows
 
 #if CONFIG_MULTITHREAD
     pthread_t *h_encoding_thread;
@@ -607,6 +643,8 @@ typedef struct
     unsigned int time_pick_lpf;
     unsigned int time_encode_mb_row;
 
+    vp8e_frame_stats_t frame_stats;   // Statistics of the frame being coded, while cpi->mb.collect_stats is set
+
     unsigned int tempdata1;
     unsigned int tempdata2;
 
@@ -625,7 +663,6 @@ typedef struct
 #if VP8_TEMPORAL_ALT_REF
     SOURCE_SAMPLE alt_ref_buffer;
     YV12_BUFFER_CONFIG *frames[MAX_LAG_BUFFERS];
-    int fixed_divide[512];
 #endif
     // Flag to indicate temporal filter method
     int use_weighted_temporal_filter;
@@ -661,6 +698,16 @@ typedef struct
     unsigned char *gf_active_flags;   // Record of which MBs still refer to last golden frame either directly or through 0,0
     int gf_active_count;
 
+    // Recode loop iterations that keep the mode decisions of the first pass
+    int fixed_mode_recode;            // Set while re-encoding with the MODE_INFO of the previous iteration
+    int fixed_mode_rate;              // Mode and MV signalling cost of the first pass (1/256 bit units)
+    unsigned char *fixed_mode_skip_map;   // Per MB encode breakout decisions of the first pass
+
+    MB_ANALYSIS *mb_analysis;         // Source statistics of each MB of the current frame
+
+    // Simulcast: encoder of the next higher resolution layer. When set, its
+    // mode decisions for the current frame seed our motion searches.
+    void *simulcast_parent;
 
 } VP8_COMP;
 
@@ -668,6 +715,9 @@ void control_data_rate(VP8_COMP *cpi);
 
 void vp8_encode_frame(VP8_COMP *cpi);
 
+// Charges the time since the MB's last mark to one of its stats counters
+void vp8_mb_stats_mark(MACROBLOCK *x, unsigned int *counter);
+
 void vp8_pack_bitstream(VP8_COMP *cpi, unsigned char *dest, unsigned long *size);
 
 int rd_cost_intra_mb(MACROBLOCKD *x);
@@ -676,6 +726,8 @@ void vp8_tokenize_mb(VP8_COMP *, MACROBLOCKD *, TOKENEXTRA **);
 
 void vp8_set_speed_features(VP8_COMP *cpi);
 
+int vp8_simulcast_mv_hint(VP8_COMP *cpi, MACROBLOCKD *xd, int ref_frame, MV *mv);
+
 #if CONFIG_DEBUG
 #define CHECK_MEM_ERROR(lval,expr) do {\
         lval = (expr); \
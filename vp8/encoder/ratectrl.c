@@ -235,6 +235,7 @@ void vp8_save_coding_context(VP8_COMP *cpi)
 
     vp8_copy(cc->mvc,      cpi->common.fc.mvc);
     vp8_copy(cc->mvcosts,  cpi->mb.mvcosts);
+    vp8_copy(cc->mvcost_mvc, cpi->mvcost_mvc);
 
     vp8_copy(cc->kf_ymode_prob,   cpi->common.kf_ymode_prob);
     vp8_copy(cc->ymode_prob,   cpi->common.fc.ymode_prob);
@@ -274,6 +275,7 @@ void vp8_restore_coding_context(VP8_COMP *cpi)
     vp8_copy(cpi->common.fc.mvc, cc->mvc);
 
     vp8_copy(cpi->mb.mvcosts, cc->mvcosts);
+    vp8_copy(cpi->mvcost_mvc, cc->mvcost_mvc);
 
     vp8_copy(cpi->common.kf_ymode_prob,   cc->kf_ymode_prob);
     vp8_copy(cpi->common.fc.ymode_prob,   cc->ymode_prob);
@@ -306,10 +308,7 @@ void vp8_setup_key_frame(VP8_COMP *cpi)
     vp8_kf_default_bmode_probs(cpi->common.kf_bmode_prob);
 
     vpx_memcpy(cpi->common.fc.mvc, vp8_default_mv_context, sizeof(vp8_default_mv_context));
-    {
-        int flag[2] = {1, 1};
-        vp8_build_component_cost_table(cpi->mb.mvcost, cpi->mb.mvsadcost, (const MV_CONTEXT *) cpi->common.fc.mvc, flag);
-    }
+    vp8_update_mv_cost_tables(cpi);
 
     vpx_memset(cpi->common.fc.pre_mvc, 0, sizeof(cpi->common.fc.pre_mvc));  //initialize pre_mvc to all zero.
 
@@ -396,6 +395,83 @@ void vp8_calc_auto_iframe_target_size(VP8_COMP *cpi)
     }
 }
 
+// One pass lagged mode: scans the lookahead analysis from the frame being
+// coded to estimate for how many frames a golden frame coded now will remain
+// a useful predictor. Returns the interval and the matching boost.
+static int lookahead_gf_interval(VP8_COMP *cpi, int *boost)
+{
+    int lag = cpi->oxcf.lag_in_frames;
+    int frames = cpi->source_buffer_count + 1;
+    double decay_val = 1.0;
+    double IIAccumulator = 0.0;
+    double last_iiaccumulator = 0.0;
+    int i;
+
+    vp8_clear_system_state();  //__asm emms;
+
+    if (frames > cpi->max_gf_interval)
+        frames = cpi->max_gf_interval;
+
+    for (i = 1; i < frames; i++)
+    {
+        ONEPASS_FRAMESTATS *stats = &cpi->one_pass_frame_stats[(cpi->one_pass_frame_index + i) % lag];
+        double IIRatio;
+
+        // The group ends at a scene cut, which will be coded as a key frame
+        if (stats->scene_cut)
+            break;
+
+        if (stats->frame_coded_error > 0.0)
+        {
+            IIRatio = stats->frame_intra_error / stats->frame_coded_error;
+
+            if (IIRatio > 30.0)
+                IIRatio = 30.0;
+        }
+        else
+            IIRatio = 30.0;
+
+        IIAccumulator += IIRatio * decay_val;
+
+        decay_val = decay_val * stats->frame_pcnt_inter;
+
+        if ((i > MIN_GF_INTERVAL) &&
+            ((IIAccumulator - last_iiaccumulator) < 2.0))
+            break;
+
+        last_iiaccumulator = IIAccumulator;
+    }
+
+    *boost = (int)(IIAccumulator * 100.0 / 16.0);
+
+    return i;
+}
+
+// One pass lagged mode: scales an inter frame target by the complexity of
+// the frame relative to the other frames held in the lookahead.
+static int lookahead_frame_target(VP8_COMP *cpi, int target)
+{
+    int lag = cpi->oxcf.lag_in_frames;
+    double this_err = cpi->one_pass_frame_stats[cpi->one_pass_frame_index].frame_coded_error;
+    double total_err = 0.0;
+    double ratio;
+    int i;
+
+    vp8_clear_system_state();  //__asm emms;
+
+    for (i = 0; i <= cpi->source_buffer_count; i++)
+        total_err += cpi->one_pass_frame_stats[(cpi->one_pass_frame_index + i) % lag].frame_coded_error;
+
+    ratio = sqrt(this_err * (cpi->source_buffer_count + 1) / (total_err + 1.0));
+
+    if (ratio < 0.75)
+        ratio = 0.75;
+    else if (ratio > 1.5)
+        ratio = 1.5;
+
+    return (int)(target * ratio);
+}
+
 //  Do the best we can to define the parameteres for the next GF based on what information we have available.
 static void calc_gf_params(VP8_COMP *cpi)
 {
@@ -409,6 +485,7 @@ static void calc_gf_params(VP8_COMP *cpi)
                   cpi->recent_ref_frame_usage[ALTREF_FRAME];
 
     int pct_gf_active = (100 * cpi->gf_active_count) / (cpi->common.mb_rows * cpi->common.mb_cols);
+    int lookahead_interval = 0;
 
     // Reset the last boost indicator
     //cpi->last_boost = 100;
@@ -422,9 +499,10 @@ static void calc_gf_params(VP8_COMP *cpi)
     // Not two pass
     if (cpi->pass != 2)
     {
-        // Single Pass lagged mode: TBD
-        if (FALSE)
+        // Single Pass lagged mode: use the analysis of the buffered frames
+        if (ONE_PASS_LOOKAHEAD(cpi))
         {
+            lookahead_interval = lookahead_gf_interval(cpi, &Boost);
         }
 
         // Single Pass compression: Has to use current and historical data
@@ -520,6 +598,10 @@ static void calc_gf_params(VP8_COMP *cpi)
         {
             cpi->frames_till_gf_update_due = cpi->baseline_gf_interval;
         }
+        else if (lookahead_interval)    // 1 Pass lagged
+        {
+            cpi->frames_till_gf_update_due = lookahead_interval;
+        }
         else                            // 1 Pass
         {
             cpi->frames_till_gf_update_due = cpi->baseline_gf_interval;
@@ -776,6 +858,10 @@ void vp8_calc_pframe_target_size(VP8_COMP *cpi)
             else
                 cpi->this_frame_target = cpi->per_frame_bandwidth;
 
+            // Favour the harder frames of the lookahead
+            if (ONE_PASS_LOOKAHEAD(cpi))
+                cpi->this_frame_target = lookahead_frame_target(cpi, cpi->this_frame_target);
+
             // If appropriate make an adjustment to recover bits spent on a recent GF
             if ((cpi->gf_overspend_bits > 0) && (cpi->this_frame_target > min_frame_target))
             {
@@ -12,6 +12,7 @@
 #include <stdio.h>
 #include <math.h>
 #include <limits.h>
+#include <string.h>
 #include <assert.h>
 #include "pragmas.h"
 
@@ -35,6 +36,7 @@
 #include "vpx_mem/vpx_mem.h"
 #include "dct.h"
 #include "systemdependent.h"
+#include "quant_common.h"
 
 #define DIAMONDSEARCH 1
 #if CONFIG_RUNTIME_CPU_DETECT
@@ -150,9 +152,13 @@ const MV_REFERENCE_FRAME vp8_ref_frame_order[MAX_MODES] =
     INTRA_FRAME,
 };
 
+// Only the contexts whose probabilities differ from those in "last" (the
+// probabilities the costs were previously built from) are re-costed. "last"
+// starts out zeroed, which no valid probability matches.
 static void fill_token_costs(
     unsigned int c      [BLOCK_TYPES] [COEF_BANDS] [PREV_COEF_CONTEXTS] [vp8_coef_tokens],
-    const vp8_prob p    [BLOCK_TYPES] [COEF_BANDS] [PREV_COEF_CONTEXTS] [vp8_coef_tokens-1]
+    const vp8_prob p    [BLOCK_TYPES] [COEF_BANDS] [PREV_COEF_CONTEXTS] [vp8_coef_tokens-1],
+    vp8_prob last       [BLOCK_TYPES] [COEF_BANDS] [PREV_COEF_CONTEXTS] [vp8_coef_tokens-1]
 )
 {
     int i, j, k;
@@ -161,8 +167,13 @@ static void fill_token_costs(
     for (i = 0; i < BLOCK_TYPES; i++)
         for (j = 0; j < COEF_BANDS; j++)
             for (k = 0; k < PREV_COEF_CONTEXTS; k++)
+            {
+                if (!memcmp(last [i][j][k], p [i][j][k], vp8_coef_tokens - 1))
+                    continue;
 
+                vpx_memcpy(last [i][j][k], p [i][j][k], vp8_coef_tokens - 1);
                 vp8_cost_tokens((int *)(c [i][j][k]), p [i][j][k], vp8_coef_tree);
+            }
 
 }
 
@@ -220,12 +231,38 @@ void vp8cx_initialize_me_consts(VP8_COMP *cpi, int QIndex)
     cpi->mb.sadperbit4  =  sad_per_bit4lut[QIndex];
 }
 
-void vp8_initialize_rd_consts(VP8_COMP *cpi, int Qvalue)
+// Scale the mode thresholds of the current speed features by the quantizer
+void vp8_set_rd_thresholds(VP8_COMP *cpi, int Qvalue)
 {
-    int q;
+    int q = (int)pow(Qvalue, 1.25);
     int i;
-    int *thresh;
-    int threshmult;
+
+    if (q < 8)
+        q = 8;
+
+    for (i = 0; i < MAX_MODES; i++)
+    {
+        if (cpi->RDDIV == 1)
+        {
+            if (cpi->sf.thresh_mult[i] < INT_MAX)
+                cpi->rd_threshes[i] = cpi->sf.thresh_mult[i] * q / 100;
+            else
+                cpi->rd_threshes[i] = INT_MAX;
+        }
+        else
+        {
+            if (cpi->sf.thresh_mult[i] < (INT_MAX / q))
+                cpi->rd_threshes[i] = cpi->sf.thresh_mult[i] * q;
+            else
+                cpi->rd_threshes[i] = INT_MAX;
+        }
+
+        cpi->rd_baseline_thresh[i] = cpi->rd_threshes[i];
+    }
+}
+
+void vp8_initialize_rd_consts(VP8_COMP *cpi, int Qvalue)
+{
     double capped_q = (Qvalue < 160) ? (double)Qvalue : 160.0;
     double rdconst = 3.00;
 
@@ -271,68 +308,20 @@ void vp8_initialize_rd_consts(VP8_COMP *cpi, int Qvalue)
     if (cpi->common.simpler_lpf)
         cpi->common.filter_type = SIMPLE_LOOPFILTER;
 
-    q = (int)pow(Qvalue, 1.25);
-
-    if (q < 8)
-        q = 8;
-
-    if (cpi->ref_frame_flags == VP8_ALT_FLAG)
-    {
-        thresh      = &cpi->rd_threshes[THR_NEWA];
-        threshmult  = cpi->sf.thresh_mult[THR_NEWA];
-    }
-    else if (cpi->ref_frame_flags == VP8_GOLD_FLAG)
-    {
-        thresh      = &cpi->rd_threshes[THR_NEWG];
-        threshmult  = cpi->sf.thresh_mult[THR_NEWG];
-    }
-    else
-    {
-        thresh      = &cpi->rd_threshes[THR_NEWMV];
-        threshmult  = cpi->sf.thresh_mult[THR_NEWMV];
-    }
-
     if (cpi->RDMULT > 1000)
     {
         cpi->RDDIV = 1;
         cpi->RDMULT /= 100;
-
-        for (i = 0; i < MAX_MODES; i++)
-        {
-            if (cpi->sf.thresh_mult[i] < INT_MAX)
-            {
-                cpi->rd_threshes[i] = cpi->sf.thresh_mult[i] * q / 100;
-            }
-            else
-            {
-                cpi->rd_threshes[i] = INT_MAX;
-            }
-
-            cpi->rd_baseline_thresh[i] = cpi->rd_threshes[i];
-        }
     }
     else
-    {
         cpi->RDDIV = 100;
 
-        for (i = 0; i < MAX_MODES; i++)
-        {
-            if (cpi->sf.thresh_mult[i] < (INT_MAX / q))
-            {
-                cpi->rd_threshes[i] = cpi->sf.thresh_mult[i] * q;
-            }
-            else
-            {
-                cpi->rd_threshes[i] = INT_MAX;
-            }
-
-            cpi->rd_baseline_thresh[i] = cpi->rd_threshes[i];
-        }
-    }
+    vp8_set_rd_thresholds(cpi, Qvalue);
 
     fill_token_costs(
         cpi->mb.token_costs,
-        (const vp8_prob( *)[8][3][11]) cpi->common.fc.coef_probs
+        (const vp8_prob( *)[8][3][11]) cpi->common.fc.coef_probs,
+        cpi->token_cost_probs
     );
 
     vp8_init_mode_costs(cpi);
@@ -414,6 +403,74 @@ void vp8_auto_select_speed(VP8_COMP *cpi)
         cpi->avg_pick_mode_time = 0;
         cpi->avg_encode_time = 0;
     }
+
+    // The MB rows get what is left of the frame's time once the rest of the
+    // encode is allowed for, so a frame that falls behind can be sped up
+    // part way through (see vp8_raise_speed_in_frame()).
+    cpi->mb_row_deadline = milliseconds_for_compress - cpi->avg_frame_overhead_time;
+
+    if (cpi->mb_row_deadline < milliseconds_for_compress / 2)
+        cpi->mb_row_deadline = milliseconds_for_compress / 2;
+}
+
+// Move the MB rows still to be coded in this frame to the features of a
+// faster speed setting. The motion search pattern and the loop filter type
+// are frame level choices and are kept, as are the statistics the next
+// frame's features are derived from and the mode thresholds adapted so far.
+// Called between rows, while no encoding thread is running.
+void vp8_raise_speed_in_frame(VP8_COMP *cpi, int speed)
+{
+    VP8_COMMON *cm = &cpi->common;
+    int search_method = cpi->sf.search_method;
+    LOOPFILTERTYPE filter_type = cm->filter_type;
+    int error_bins[1024];
+    int adapted[MAX_MODES];
+    int i;
+
+    for (i = 0; i < MAX_MODES; i++)
+        adapted[i] = cpi->rd_threshes[i] != cpi->rd_baseline_thresh[i];
+
+    vpx_memcpy(error_bins, cpi->error_bins, sizeof(error_bins));
+
+    cpi->Speed = speed;
+    vp8_set_speed_features(cpi);
+
+    vpx_memcpy(cpi->error_bins, error_bins, sizeof(error_bins));
+    cm->filter_type = filter_type;
+
+    if (cpi->sf.search_method != search_method)
+    {
+        cpi->sf.search_method = search_method;
+
+        if (search_method == NSTEP)
+            vp8_init3smotion_compensation(&cpi->mb, cm->yv12_fb[cm->lst_fb_idx].y_stride);
+        else if (search_method == DIAMOND)
+            vp8_init_dsmotion_compensation(&cpi->mb, cm->yv12_fb[cm->lst_fb_idx].y_stride);
+    }
+
+    vp8_set_rd_thresholds(cpi, vp8_dc_quant(cm->base_qindex, cm->y1dc_delta_q));
+
+    for (i = 0; i < MAX_MODES; i++)
+    {
+        if (adapted[i] && cpi->rd_baseline_thresh[i] < (INT_MAX >> 2))
+            cpi->rd_threshes[i] = (cpi->rd_baseline_thresh[i] >> 7) * cpi->rd_thresh_mult[i];
+    }
+
+    // The encoding threads took their copy of the speed features when the
+    // frame started
+    if (cpi->b_multi_threaded)
+    {
+        for (i = 0; i < cpi->encoding_thread_count; i++)
+        {
+            MACROBLOCK *z = &cpi->mb_row_ei[i].mb;
+
+            z->vp8_short_fdct4x4 = cpi->mb.vp8_short_fdct4x4;
+            z->vp8_short_fdct8x4 = cpi->mb.vp8_short_fdct8x4;
+            z->quantize_b        = cpi->mb.quantize_b;
+            z->optimize          = cpi->mb.optimize;
+            z->fast_optimize     = cpi->mb.fast_optimize;
+        }
+    }
 }
 
 int vp8_block_error_c(short *coeff, short *dqcoeff)
@@ -641,6 +698,45 @@ int vp8_rdcost_mby(MACROBLOCK *mb)
 }
 
 
+// Orders the 4x4 intra modes by prediction SATD plus mode cost, so the
+// first count entries of modes[] are the cheapest candidates.
+static void prescreen_intra4x4_modes(
+    VP8_COMP *cpi,
+    MACROBLOCK *x,
+    BLOCK *be,
+    BLOCKD *b,
+    const unsigned int *mode_costs,
+    B_PREDICTION_MODE *modes,
+    int count)
+{
+    unsigned int score[VP8_BINTRAMODES];
+    B_PREDICTION_MODE mode;
+    int i, j;
+
+    for (mode = B_DC_PRED; mode <= B_HU_PRED; mode++)
+    {
+        unsigned int satd;
+
+        vp8_predict_intra4x4(b, mode, b->predictor);
+        satd = VARIANCE_INVOKE(&cpi->rtcd.variance, satd4x4)(*(be->base_src) + be->src, be->src_stride, b->predictor, 16, 0x7fffffff);
+        score[mode] = (satd >> 1) + ((mode_costs[mode] * x->sadperbit4 + 128) >> 8);
+        modes[mode] = mode;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        int best = i;
+
+        for (j = i + 1; j < VP8_BINTRAMODES; j++)
+            if (score[modes[j]] < score[modes[best]])
+                best = j;
+
+        mode = modes[i];
+        modes[i] = modes[best];
+        modes[best] = mode;
+    }
+}
+
 static void rd_pick_intra4x4block(
     VP8_COMP *cpi,
     MACROBLOCK *x,
@@ -657,6 +753,9 @@ static void rd_pick_intra4x4block(
     int *bestdistortion)
 {
     B_PREDICTION_MODE mode;
+    B_PREDICTION_MODE modes[VP8_BINTRAMODES];
+    int num_modes = VP8_BINTRAMODES;
+    int i;
     int best_rd = INT_MAX;       // 1<<30
     int rate = 0;
     int distortion;
@@ -675,11 +774,24 @@ static void rd_pick_intra4x4block(
         mode_costs = x->inter_bmode_costs;
     }
 
-    for (mode = B_DC_PRED; mode <= B_HU_PRED; mode++)
+    if (cpi->sf.bpred_prescreen_modes > 0 && cpi->sf.bpred_prescreen_modes < VP8_BINTRAMODES)
+    {
+        num_modes = cpi->sf.bpred_prescreen_modes;
+        prescreen_intra4x4_modes(cpi, x, be, b, mode_costs, modes, num_modes);
+    }
+    else
+    {
+        for (mode = B_DC_PRED; mode <= B_HU_PRED; mode++)
+            modes[mode] = mode;
+    }
+
+    for (i = 0; i < num_modes; i++)
     {
         int this_rd;
         int ratey;
 
+        mode = modes[i];
+
         rate = mode_costs[mode];
         vp8_encode_intra4x4block_rd(IF_RTCD(&cpi->rtcd), x, be, b, mode);
 
@@ -1112,7 +1224,9 @@ static void macro_block_yrd(MACROBLOCK *mb, int *Rate, int *Distortion, const vp
     *Rate = vp8_rdcost_mby(mb);
 }
 
-static int vp8_rd_pick_best_mbsegmentation(VP8_COMP *cpi, MACROBLOCK *x, MV *best_ref_mv, int best_rd, int *mdcounts, int *returntotrate, int *returnyrate, int *returndistortion, int compressor_speed, int *mvcost[2], int mvthresh, int fullpixel)
+// seed_mv, when not NULL, is the 16x16 vector found for this reference
+// frame and is used as the search start for the larger partitions.
+static int vp8_rd_pick_best_mbsegmentation(VP8_COMP *cpi, MACROBLOCK *x, MV *best_ref_mv, MV *seed_mv, int best_rd, int *mdcounts, int *returntotrate, int *returnyrate, int *returndistortion, int compressor_speed, int *mvcost[2], int mvthresh, int fullpixel)
 {
     int i, segmentation;
     B_PREDICTION_MODE this_mode;
@@ -1142,6 +1256,10 @@ static int vp8_rd_pick_best_mbsegmentation(VP8_COMP *cpi, MACROBLOCK *x, MV *bes
     MV bmvs[16];
     int beobs[16];
 
+    // Block vectors and rd of the 8x8 partitioning, used to prune the 4x4 search
+    MV parent_mvs[16];
+    int split8x8_rd = INT_MAX;
+
     vpx_memset(beobs, 0, sizeof(beobs));
 
 
@@ -1176,6 +1294,13 @@ static int vp8_rd_pick_best_mbsegmentation(VP8_COMP *cpi, MACROBLOCK *x, MV *bes
         br = 0;
         bd = 0;
 
+        // 4x4 partitions rarely win when 8x8 was clearly worse (by more
+        // than a seventh) than 16x8, 8x16 or the best mode so far
+        if (cpi->sf.split_search_pruning && segmentation == 3 &&
+            (split8x8_rd - (split8x8_rd >> 3) > best_segment_rd ||
+             split8x8_rd - (split8x8_rd >> 3) > best_rd))
+            break;
+
         v_fn_ptr = &cpi->fn_ptr[segmentation];
         sseshift = segmentation_to_sseshift[segmentation];
         labels = vp8_mbsplits[segmentation];
@@ -1235,24 +1360,42 @@ static int vp8_rd_pick_best_mbsegmentation(VP8_COMP *cpi, MACROBLOCK *x, MV *bes
                 if (this_mode == NEW4X4)
                 {
                     int step_param = 0;
-                    int further_steps = (MAX_MVSEARCH_STEPS - 1) - step_param;
+                    int further_steps;
                     int n;
                     int thissme;
                     int bestsme = INT_MAX;
                     MV  temp_mv;
+                    MV *start_mv = best_ref_mv;
 
                     // Is the best so far sufficiently good that we cant justify doing and new motion search.
                     if (best_label_rd < label_mv_thresh)
                         break;
 
+                    // Start from the vector of the enclosing larger partition
+                    // and only refine around it.
+                    if (cpi->sf.split_search_pruning)
+                    {
+                        if (segmentation == 3)
+                            start_mv = &parent_mvs[j];
+                        else if (seed_mv)
+                            start_mv = seed_mv;
+
+                        if (start_mv != best_ref_mv)
+                            step_param = 2;
+                    }
+
+                    further_steps = (MAX_MVSEARCH_STEPS - 1) - step_param;
+
+                    vp8_mb_stats_mark(x, &x->time_mode_decision);
+
                     {
                         int sadpb = x->sadperbit4;
 
                         if (cpi->sf.search_method == HEX)
-                            bestsme = vp8_hex_search(x, c, e, best_ref_mv, &mode_mv[NEW4X4], step_param, sadpb/*x->errorperbit*/, &num00, v_fn_ptr, x->mvsadcost, mvcost);
+                            bestsme = vp8_hex_search(x, c, e, start_mv, &mode_mv[NEW4X4], step_param, sadpb/*x->errorperbit*/, &num00, v_fn_ptr, x->mvsadcost, mvcost, best_ref_mv);
                         else
                         {
-                            bestsme = cpi->diamond_search_sad(x, c, e, best_ref_mv, &mode_mv[NEW4X4], step_param, sadpb / 2/*x->errorperbit*/, &num00, v_fn_ptr, x->mvsadcost, mvcost);
+                            bestsme = cpi->diamond_search_sad(x, c, e, start_mv, &mode_mv[NEW4X4], step_param, sadpb / 2/*x->errorperbit*/, &num00, v_fn_ptr, x->mvsadcost, mvcost, best_ref_mv);
 
                             n = num00;
                             num00 = 0;
@@ -1265,7 +1408,7 @@ static int vp8_rd_pick_best_mbsegmentation(VP8_COMP *cpi, MACROBLOCK *x, MV *bes
                                     num00--;
                                 else
                                 {
-                                    thissme = cpi->diamond_search_sad(x, c, e, best_ref_mv, &temp_mv, step_param + n, sadpb / 2/*x->errorperbit*/, &num00, v_fn_ptr, x->mvsadcost, mvcost);
+                                    thissme = cpi->diamond_search_sad(x, c, e, start_mv, &temp_mv, step_param + n, sadpb / 2/*x->errorperbit*/, &num00, v_fn_ptr, x->mvsadcost, mvcost, best_ref_mv);
 
                                     if (thissme < bestsme)
                                     {
@@ -1302,6 +1445,8 @@ static int vp8_rd_pick_best_mbsegmentation(VP8_COMP *cpi, MACROBLOCK *x, MV *bes
                         else
                             vp8_skip_fractional_mv_step(x, c, e, &mode_mv[NEW4X4], best_ref_mv, x->errorperbit, v_fn_ptr, mvcost);
                     }
+
+                    vp8_mb_stats_mark(x, &x->time_motion_search);
                 }
 
                 rate = labels2mode(x, labels, i, this_mode, &mode_mv[this_mode], best_ref_mv, mvcost);
@@ -1348,6 +1493,14 @@ static int vp8_rd_pick_best_mbsegmentation(VP8_COMP *cpi, MACROBLOCK *x, MV *bes
                 break;
         }
 
+        if (segmentation == 2)
+        {
+            split8x8_rd = this_segment_rd;
+
+            for (i = 0; i < 16; i++)
+                parent_mvs[i] = x->e_mbd.block[i].bmi.mv.as_mv;
+        }
+
         if ((this_segment_rd <= best_rd) && (this_segment_rd < best_segment_rd))
         {
             bsr = br;
@@ -1437,6 +1590,8 @@ int vp8_rd_pick_inter_mode(VP8_COMP *cpi, MACROBLOCK *x, int recon_yoffset, int
     PARTITION_INFO best_partition;
     MV best_ref_mv;
     MV mode_mv[MB_MODE_COUNT];
+    MV frame_new_mv[MAX_REF_FRAMES];
+    int frame_new_mv_valid[MAX_REF_FRAMES] = {0, 0, 0, 0};
     MB_PREDICTION_MODE this_mode;
     int num00;
     int best_mode_index = 0;
@@ -1699,13 +1854,17 @@ int vp8_rd_pick_inter_mode(VP8_COMP *cpi, MACROBLOCK *x, int recon_yoffset, int
             // (best_rd - frame_cost_rd) is thus a conservative breakout number.
             int breakout_rd = best_rd - frame_cost_rd;
             int tmp_rd;
+            MV *seed_mv = NULL;
+
+            if (frame_new_mv_valid[x->e_mbd.mode_info_context->mbmi.ref_frame])
+                seed_mv = &frame_new_mv[x->e_mbd.mode_info_context->mbmi.ref_frame];
 
             if (x->e_mbd.mode_info_context->mbmi.ref_frame == LAST_FRAME)
-                tmp_rd = vp8_rd_pick_best_mbsegmentation(cpi, x, &best_ref_mv, breakout_rd, mdcounts, &rate, &rate_y, &distortion, cpi->compressor_speed, x->mvcost, cpi->rd_threshes[THR_NEWMV], cpi->common.full_pixel) ;
+                tmp_rd = vp8_rd_pick_best_mbsegmentation(cpi, x, &best_ref_mv, seed_mv, breakout_rd, mdcounts, &rate, &rate_y, &distortion, cpi->compressor_speed, x->mvcost, cpi->rd_threshes[THR_NEWMV], cpi->common.full_pixel) ;
             else if (x->e_mbd.mode_info_context->mbmi.ref_frame == GOLDEN_FRAME)
-                tmp_rd = vp8_rd_pick_best_mbsegmentation(cpi, x, &best_ref_mv, breakout_rd, mdcounts, &rate, &rate_y, &distortion, cpi->compressor_speed, x->mvcost, cpi->rd_threshes[THR_NEWG], cpi->common.full_pixel) ;
+                tmp_rd = vp8_rd_pick_best_mbsegmentation(cpi, x, &best_ref_mv, seed_mv, breakout_rd, mdcounts, &rate, &rate_y, &distortion, cpi->compressor_speed, x->mvcost, cpi->rd_threshes[THR_NEWG], cpi->common.full_pixel) ;
             else
-                tmp_rd = vp8_rd_pick_best_mbsegmentation(cpi, x, &best_ref_mv, breakout_rd, mdcounts, &rate, &rate_y, &distortion, cpi->compressor_speed, x->mvcost, cpi->rd_threshes[THR_NEWA], cpi->common.full_pixel) ;
+                tmp_rd = vp8_rd_pick_best_mbsegmentation(cpi, x, &best_ref_mv, seed_mv, breakout_rd, mdcounts, &rate, &rate_y, &distortion, cpi->compressor_speed, x->mvcost, cpi->rd_threshes[THR_NEWA], cpi->common.full_pixel) ;
 
             rate2 += rate;
             distortion2 += distortion;
@@ -1805,6 +1964,22 @@ int vp8_rd_pick_inter_mode(VP8_COMP *cpi, MACROBLOCK *x, int recon_yoffset, int
                 int search_range;
                 int further_steps;
                 int n;
+                MV *start_mv = &best_ref_mv;
+                MV hint_mv;
+
+                vp8_mb_stats_mark(x, &x->time_mode_decision);
+
+                // A simulcast layer starts from the scaled vector of the
+                // higher resolution layer and only needs to search a small
+                // window around it.
+                if (vp8_simulcast_mv_hint(cpi, &x->e_mbd, x->e_mbd.mode_info_context->mbmi.ref_frame, &hint_mv))
+                {
+                    start_mv = &hint_mv;
+                    step_param += 2;
+
+                    if (step_param > cpi->sf.max_step_search_steps - 1)
+                        step_param = cpi->sf.max_step_search_steps - 1;
+                }
 
                 // Work out how long a search we should do
                 search_range = MAXF(abs(best_ref_mv.col), abs(best_ref_mv.row)) >> 3;
@@ -1820,13 +1995,13 @@ int vp8_rd_pick_inter_mode(VP8_COMP *cpi, MACROBLOCK *x, int recon_yoffset, int
 
                     if (cpi->sf.search_method == HEX)
                     {
-                        bestsme = vp8_hex_search(x, b, d, &best_ref_mv, &d->bmi.mv.as_mv, step_param, sadpb/*x->errorperbit*/, &num00, &cpi->fn_ptr[BLOCK_16X16], x->mvsadcost, x->mvcost);
+                        bestsme = vp8_hex_search(x, b, d, start_mv, &d->bmi.mv.as_mv, step_param, sadpb/*x->errorperbit*/, &num00, &cpi->fn_ptr[BLOCK_16X16], x->mvsadcost, x->mvcost, &best_ref_mv);
                         mode_mv[NEWMV].row = d->bmi.mv.as_mv.row;
                         mode_mv[NEWMV].col = d->bmi.mv.as_mv.col;
                     }
                     else
                     {
-                        bestsme = cpi->diamond_search_sad(x, b, d, &best_ref_mv, &d->bmi.mv.as_mv, step_param, sadpb / 2/*x->errorperbit*/, &num00, &cpi->fn_ptr[BLOCK_16X16], x->mvsadcost, x->mvcost); //sadpb < 9
+                        bestsme = cpi->diamond_search_sad(x, b, d, start_mv, &d->bmi.mv.as_mv, step_param, sadpb / 2/*x->errorperbit*/, &num00, &cpi->fn_ptr[BLOCK_16X16], x->mvsadcost, x->mvcost, &best_ref_mv); //sadpb < 9
                         mode_mv[NEWMV].row = d->bmi.mv.as_mv.row;
                         mode_mv[NEWMV].col = d->bmi.mv.as_mv.col;
 
@@ -1845,7 +2020,7 @@ int vp8_rd_pick_inter_mode(VP8_COMP *cpi, MACROBLOCK *x, int recon_yoffset, int
                                 num00--;
                             else
                             {
-                                thissme = cpi->diamond_search_sad(x, b, d, &best_ref_mv, &d->bmi.mv.as_mv, step_param + n, sadpb / 4/*x->errorperbit*/, &num00, &cpi->fn_ptr[BLOCK_16X16], x->mvsadcost, x->mvcost); //sadpb = 9
+                                thissme = cpi->diamond_search_sad(x, b, d, start_mv, &d->bmi.mv.as_mv, step_param + n, sadpb / 4/*x->errorperbit*/, &num00, &cpi->fn_ptr[BLOCK_16X16], x->mvsadcost, x->mvcost, &best_ref_mv); //sadpb = 9
 
                                 if (thissme < bestsme)
                                 {
@@ -1909,9 +2084,14 @@ int vp8_rd_pick_inter_mode(VP8_COMP *cpi, MACROBLOCK *x, int recon_yoffset, int
                     // cpi->find_fractional_mv_step(x,b,d,&d->bmi.mv.as_mv,&best_ref_mv,x->errorperbit/2,cpi->fn_ptr.svf,cpi->fn_ptr.vf,x->mvcost);  // normal mvc=11
                     cpi->find_fractional_mv_step(x, b, d, &d->bmi.mv.as_mv, &best_ref_mv, x->errorperbit / 4, &cpi->fn_ptr[BLOCK_16X16], x->mvcost);
 
+                vp8_mb_stats_mark(x, &x->time_motion_search);
+
                 mode_mv[NEWMV].row = d->bmi.mv.as_mv.row;
                 mode_mv[NEWMV].col = d->bmi.mv.as_mv.col;
 
+                frame_new_mv[x->e_mbd.mode_info_context->mbmi.ref_frame] = mode_mv[NEWMV];
+                frame_new_mv_valid[x->e_mbd.mode_info_context->mbmi.ref_frame] = 1;
+
                 // Add the new motion vector cost to our rolling cost variable
                 rate2 += vp8_mv_bit_cost(&mode_mv[NEWMV], &best_ref_mv, x->mvcost, 96);
 
@@ -1949,7 +2129,12 @@ int vp8_rd_pick_inter_mode(VP8_COMP *cpi, MACROBLOCK *x, int recon_yoffset, int
 
             vp8_set_mbmode_and_mvs(x, this_mode, &mode_mv[this_mode]);
             vp8_build_inter_predictors_mby(&x->e_mbd);
-            VARIANCE_INVOKE(&cpi->rtcd.variance, get16x16var)(x->src.y_buffer, x->src.y_stride, x->e_mbd.predictor, 16, (unsigned int *)(&sse), &sum);
+
+            // The zero motion last frame error was measured by the source analysis
+            if (this_mode == ZEROMV && x->e_mbd.mode_info_context->mbmi.ref_frame == LAST_FRAME)
+                sse = x->mb_analysis->zero_mv_sse;
+            else
+                VARIANCE_INVOKE(&cpi->rtcd.variance, get16x16var)(x->src.y_buffer, x->src.y_stride, x->e_mbd.predictor, 16, (unsigned int *)(&sse), &sum);
 
             if (cpi->active_map_enabled && x->active_ptr[0] == 0)
             {
@@ -59,6 +59,20 @@ static int modifier_lut[7][19] =
     {16, 16, 16, 16, 15, 15, 14, 14, 13, 12, 11, 10, 9, 8, 7, 5, 4, 2, 1}
 };
 #endif
+
+// Reciprocals of the filter weight sums, shared by all instances
+static int fixed_divide[512];
+
+void vp8cx_init_temp_filter_tables(void)
+{
+    int i;
+
+    fixed_divide[0] = 0;
+
+    for (i = 1; i < 512; i++)
+        fixed_divide[i] = 0x80000 / i;
+}
+
 static void build_predictors_mb
 (
     MACROBLOCKD *x,
@@ -235,7 +249,7 @@ static int find_matching_mb
             step_param,
             sadpb/*x->errorperbit*/,
             &num00, &cpi->fn_ptr[BLOCK_16X16],
-            mvsadcost, mvcost);
+            mvsadcost, mvcost, &best_ref_mv1);
     }
     else
     {
@@ -246,7 +260,7 @@ static int find_matching_mb
             step_param,
             sadpb / 2/*x->errorperbit*/,
             &num00, &cpi->fn_ptr[BLOCK_16X16],
-            mvsadcost, mvcost); //sadpb < 9
+            mvsadcost, mvcost, &best_ref_mv1); //sadpb < 9
 
         // Further step/diamond searches as necessary
         n = 0;
@@ -268,7 +282,7 @@ static int find_matching_mb
                     step_param + n,
                     sadpb / 4/*x->errorperbit*/,
                     &num00, &cpi->fn_ptr[BLOCK_16X16],
-                    mvsadcost, mvcost); //sadpb = 9
+                    mvsadcost, mvcost, &best_ref_mv1); //sadpb = 9
 
                 if (thissme < bestsme)
                 {
@@ -478,7 +492,7 @@ static void vp8cx_temp_blur1_c
                 for (j = 0; j < 16; j++, k++)
                 {
                     unsigned int pval = accumulator[k] + (count[k] >> 1);
-                    pval *= cpi->fixed_divide[count[k]];
+                    pval *= fixed_divide[count[k]];
                     pval >>= 19;
 
                     dst1[byte] = (unsigned char)pval;
@@ -502,13 +516,13 @@ static void vp8cx_temp_blur1_c
 
                     // U
                     unsigned int pval = accumulator[k] + (count[k] >> 1);
-                    pval *= cpi->fixed_divide[count[k]];
+                    pval *= fixed_divide[count[k]];
                     pval >>= 19;
                     dst1[byte] = (unsigned char)pval;
 
                     // V
                     pval = accumulator[m] + (count[m] >> 1);
-                    pval *= cpi->fixed_divide[count[m]];
+                    pval *= fixed_divide[count[m]];
                     pval >>= 19;
                     dst2[byte] = (unsigned char)pval;
 
@@ -15,5 +15,6 @@
 #include "onyx_int.h"
 
 void vp8cx_temp_filter_c(VP8_COMP *cpi);
+void vp8cx_init_temp_filter_tables(void);
 
 #endif // __INC_VP8_TEMPORAL_FILTER_H
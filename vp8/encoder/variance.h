@@ -271,6 +271,11 @@ extern prototype_variance2(vp8_variance_get16x16var);
 #endif
 extern prototype_sad(vp8_variance_get4x4sse_cs);
 
+#ifndef vp8_variance_satd4x4
+#define vp8_variance_satd4x4 vp8_satd4x4_c
+#endif
+extern prototype_sad(vp8_variance_satd4x4);
+
 
 typedef prototype_sad(*vp8_sad_fn_t);
 typedef prototype_sad_multi_same_address(*vp8_sad_multi_fn_t);
@@ -310,6 +315,7 @@ typedef struct
     vp8_variance2_fn_t       get8x8var;
     vp8_variance2_fn_t       get16x16var;
     vp8_sad_fn_t             get4x4sse_cs;
+    vp8_sad_fn_t             satd4x4;
 
     vp8_sad_multi_fn_t       sad16x16x3;
     vp8_sad_multi_fn_t       sad16x8x3;
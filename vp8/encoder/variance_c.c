@@ -9,6 +9,7 @@
  */
 
 
+#include <stdlib.h>
 #include "variance.h"
 
 const int vp8_six_tap[8][6] =
@@ -561,3 +562,48 @@ unsigned int vp8_sub_pixel_variance8x16_c
 
     return vp8_variance8x16_c(temp2, 8, dst_ptr, dst_pixels_per_line, sse);
 }
+
+// Sum of absolute 4x4 Hadamard transformed differences, unnormalized.
+unsigned int vp8_satd4x4_c
+(
+    const unsigned char *src_ptr,
+    int  source_stride,
+    const unsigned char *ref_ptr,
+    int  recon_stride,
+    int max_sad
+)
+{
+    int d[16];
+    int i;
+    unsigned int satd = 0;
+
+    (void) max_sad;
+
+    for (i = 0; i < 4; i++)
+    {
+        int a0 = src_ptr[0] - ref_ptr[0];
+        int a1 = src_ptr[1] - ref_ptr[1];
+        int a2 = src_ptr[2] - ref_ptr[2];
+        int a3 = src_ptr[3] - ref_ptr[3];
+        int s01 = a0 + a1, d01 = a0 - a1;
+        int s23 = a2 + a3, d23 = a2 - a3;
+
+        d[i * 4 + 0] = s01 + s23;
+        d[i * 4 + 1] = s01 - s23;
+        d[i * 4 + 2] = d01 + d23;
+        d[i * 4 + 3] = d01 - d23;
+
+        src_ptr += source_stride;
+        ref_ptr += recon_stride;
+    }
+
+    for (i = 0; i < 4; i++)
+    {
+        int s01 = d[i] + d[4 + i], d01 = d[i] - d[4 + i];
+        int s23 = d[8 + i] + d[12 + i], d23 = d[8 + i] - d[12 + i];
+
+        satd += abs(s01 + s23) + abs(s01 - s23) + abs(d01 + d23) + abs(d01 - d23);
+    }
+
+    return satd;
+}
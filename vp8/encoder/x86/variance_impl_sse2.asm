@@ -969,6 +969,122 @@ vp8_half_horiz_variance16x16_1:
     ret
 
 
+;unsigned int vp8_satd4x4_sse2
+;(
+;    unsigned char *src_ptr,
+;    int  source_stride,
+;    unsigned char *ref_ptr,
+;    int  recon_stride,
+;    int  max_sad
+;)
+global sym(vp8_satd4x4_sse2)
+sym(vp8_satd4x4_sse2):
+    push        rbp
+    mov         rbp, rsp
+    SHADOW_ARGS_TO_STACK 5
+    push rsi
+    push rdi
+    ; end prolog
+
+        mov         rsi,            arg(0) ;[src_ptr]
+        mov         rdi,            arg(2) ;[ref_ptr]
+
+        movsxd      rax,            DWORD PTR arg(1) ;[source_stride]
+        movsxd      rdx,            DWORD PTR arg(3) ;[recon_stride]
+
+        pxor        xmm5,           xmm5                        ; clear xmm5 for unpack
+
+        ; differences of rows 0 and 1 in xmm0
+        movd        xmm0,           DWORD PTR [rsi]
+        movd        xmm1,           DWORD PTR [rdi]
+        movd        xmm3,           DWORD PTR [rsi+rax]
+        movd        xmm4,           DWORD PTR [rdi+rdx]
+
+        punpckldq   xmm0,           xmm3
+        punpckldq   xmm1,           xmm4
+        punpcklbw   xmm0,           xmm5
+        punpcklbw   xmm1,           xmm5
+        psubw       xmm0,           xmm1
+
+        lea         rsi,            [rsi+rax*2]
+        lea         rdi,            [rdi+rdx*2]
+
+        ; differences of rows 2 and 3 in xmm2
+        movd        xmm2,           DWORD PTR [rsi]
+        movd        xmm1,           DWORD PTR [rdi]
+        movd        xmm3,           DWORD PTR [rsi+rax]
+        movd        xmm4,           DWORD PTR [rdi+rdx]
+
+        punpckldq   xmm2,           xmm3
+        punpckldq   xmm1,           xmm4
+        punpcklbw   xmm2,           xmm5
+        punpcklbw   xmm1,           xmm5
+        psubw       xmm2,           xmm1
+
+        ; vertical transform, giving rows t0 t1 in xmm0 and t2 t3 in xmm1
+        movdqa      xmm1,           xmm0
+        paddw       xmm0,           xmm2                        ; r0+r2 r1+r3
+        psubw       xmm1,           xmm2                        ; r0-r2 r1-r3
+
+        movdqa      xmm2,           xmm0
+        punpcklqdq  xmm0,           xmm1                        ; r0+r2 r0-r2
+        punpckhqdq  xmm2,           xmm1                        ; r1+r3 r1-r3
+
+        movdqa      xmm1,           xmm0
+        paddw       xmm0,           xmm2
+        psubw       xmm1,           xmm2
+
+        ; transpose, giving columns c0 c1 in xmm0 and c2 c3 in xmm1
+        movdqa      xmm2,           xmm0
+        punpcklwd   xmm0,           xmm1
+        punpckhwd   xmm2,           xmm1
+
+        movdqa      xmm1,           xmm0
+        punpcklwd   xmm0,           xmm2
+        punpckhwd   xmm1,           xmm2
+
+        ; horizontal transform
+        movdqa      xmm2,           xmm0
+        paddw       xmm0,           xmm1                        ; c0+c2 c1+c3
+        psubw       xmm2,           xmm1                        ; c0-c2 c1-c3
+
+        movdqa      xmm1,           xmm0
+        punpcklqdq  xmm0,           xmm2                        ; c0+c2 c0-c2
+        punpckhqdq  xmm1,           xmm2                        ; c1+c3 c1-c3
+
+        movdqa      xmm2,           xmm0
+        paddw       xmm0,           xmm1
+        psubw       xmm2,           xmm1
+
+        ; sum of absolute values
+        movdqa      xmm3,           xmm5
+        movdqa      xmm4,           xmm5
+        psubw       xmm3,           xmm0
+        psubw       xmm4,           xmm2
+        pmaxsw      xmm0,           xmm3
+        pmaxsw      xmm2,           xmm4
+        paddw       xmm0,           xmm2
+
+        pcmpeqw     xmm1,           xmm1
+        psrlw       xmm1,           15                          ; words of 1
+        pmaddwd     xmm0,           xmm1
+
+        movdqa      xmm1,           xmm0
+        psrldq      xmm0,           8
+        paddd       xmm0,           xmm1
+        movdqa      xmm1,           xmm0
+        psrldq      xmm0,           4
+        paddd       xmm0,           xmm1
+        movd        eax,            xmm0
+
+    ; begin epilog
+    pop rdi
+    pop rsi
+    UNSHADOW_ARGS
+    pop         rbp
+    ret
+
+
 SECTION_RODATA
 ;    short xmm_bi_rd[8] = { 64, 64, 64, 64,64, 64, 64, 64};
 align 16
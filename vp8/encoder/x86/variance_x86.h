@@ -151,6 +151,7 @@ extern prototype_variance(vp8_mse16x16_wmt);
 extern prototype_sad(vp8_get16x16pred_error_sse2);
 extern prototype_variance2(vp8_get8x8var_sse2);
 extern prototype_variance2(vp8_get16x16var_sse2);
+extern prototype_sad(vp8_satd4x4_sse2);
 
 #if !CONFIG_RUNTIME_CPU_DETECT
 #undef  vp8_variance_sad4x4
@@ -225,6 +226,9 @@ extern prototype_variance2(vp8_get16x16var_sse2);
 #undef  vp8_variance_get16x16var
 #define vp8_variance_get16x16var vp8_get16x16var_sse2
 
+#undef  vp8_variance_satd4x4
+#define vp8_variance_satd4x4 vp8_satd4x4_sse2
+
 #endif
 #endif
 
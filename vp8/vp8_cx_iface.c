@@ -15,8 +15,12 @@
 #include "onyx_int.h"
 #include "vpx/vp8e.h"
 #include "vp8/encoder/firstpass.h"
+#include "vp8/common/alloccommon.h"
 #include "onyx.h"
+#include "vpx_scale/vpxscale.h"
+#include "vpx_scale/yv12config.h"
 #include <stdlib.h>
+#include <limits.h>
 #include <string.h>
 
 /* This value is a sentinel for determining whether the user has set a mode
@@ -37,6 +41,8 @@ struct vp8_extracfg
     unsigned int                arnr_max_frames;    /* alt_ref Noise Reduction Max Frame Count */
     unsigned int                arnr_strength;    /* alt_ref Noise Reduction Strength */
     unsigned int                arnr_type;        /* alt_ref filter type */
+    unsigned int                low_memory;
+    unsigned int                max_frame_size;   /* hard frame size cap in bytes */
 
 };
 
@@ -67,10 +73,24 @@ static const struct extraconfig_map extracfg_map[] =
             0,                          /* arnr_max_frames */
             3,                          /* arnr_strength */
             3,                          /* arnr_type*/
+            0,                          /* low_memory */
+            0,                          /* max_frame_size */
         }
     }
 };
 
+struct vp8_simulcast_layer
+{
+    VP8_CONFIG              oxcf;
+    VP8_PTR                 cpi;
+    unsigned int            w;
+    unsigned int            h;
+    YV12_BUFFER_CONFIG      src;        /* input downscaled from the layer above */
+    YV12_BUFFER_CONFIG      scale_tmp;  /* work area for vp8_scale_frame() */
+    unsigned char          *cx_data;
+    unsigned int            cx_data_sz;
+};
+
 struct vpx_codec_alg_priv
 {
     vpx_codec_priv_t        base;
@@ -86,6 +106,11 @@ struct vpx_codec_alg_priv
     vpx_codec_pkt_list_decl(64) pkt_list;              // changed to accomendate the maximum number of lagged frames allowed
     int                         deprecated_mode;
     unsigned int                fixed_kf_cntr;
+    vpx_simulcast_cfg_t         simulcast;
+    struct vp8_simulcast_layer  layer[VPX_SIMULCAST_MAX_LAYERS];
+    int                         frame_stats_enabled;
+    vp8e_frame_stats_t          frame_stats;  /* of the frames coded by the last encode call */
+    vp8e_frame_stats_t          frame_stats_total; /* since collection was started */
 };
 
 
@@ -187,6 +212,16 @@ static vpx_codec_err_t validate_config(vpx_codec_alg_priv_t      *ctx,
     RANGE_CHECK(vp8_cfg, arnr_max_frames, 0, 15);
     RANGE_CHECK_HI(vp8_cfg, arnr_strength,   6);
     RANGE_CHECK(vp8_cfg, arnr_type,       1, 3);
+    RANGE_CHECK_HI(vp8_cfg, low_memory,      1);
+    RANGE_CHECK_HI(vp8_cfg, max_frame_size,  INT_MAX / 8);
+
+    /* Lower resolution layers are seeded with the mode decisions made for
+     * the same frame by the layer above, so frames must leave every layer
+     * in input order.
+     */
+    if (ctx->simulcast.layers
+        && (cfg->g_pass != VPX_RC_ONE_PASS || cfg->g_lag_in_frames))
+        ERROR("Simulcast requires one pass encoding with g_lag_in_frames 0");
 
     if (cfg->g_pass == VPX_RC_LAST_PASS)
     {
@@ -335,6 +370,9 @@ static vpx_codec_err_t set_vp8e_config(VP8_CONFIG *oxcf,
     oxcf->arnr_strength =  vp8_cfg.arnr_strength;
     oxcf->arnr_type =      vp8_cfg.arnr_type;
 
+    oxcf->low_memory =     vp8_cfg.low_memory;
+    oxcf->max_frame_size = vp8_cfg.max_frame_size;
+
 
     /*
         printf("Current VP8 Settings: \n");
@@ -372,6 +410,28 @@ static vpx_codec_err_t set_vp8e_config(VP8_CONFIG *oxcf,
     return VPX_CODEC_OK;
 }
 
+/* Derives the configuration of each simulcast layer from the full
+ * resolution configuration and applies it.
+ */
+static void simulcast_change_config(vpx_codec_alg_priv_t *ctx)
+{
+    unsigned int i;
+
+    for (i = 0; i < ctx->simulcast.layers; i++)
+    {
+        struct vp8_simulcast_layer *layer = &ctx->layer[i];
+
+        layer->oxcf = ctx->oxcf;
+        layer->oxcf.Width = layer->w;
+        layer->oxcf.Height = layer->h;
+        layer->oxcf.target_bandwidth = ctx->simulcast.target_bitrate[i];
+
+        if (layer->cpi)
+            vp8_change_config(layer->cpi, &layer->oxcf);
+    }
+}
+
+
 static vpx_codec_err_t vp8e_set_config(vpx_codec_alg_priv_t       *ctx,
                                        const vpx_codec_enc_cfg_t  *cfg)
 {
@@ -395,6 +455,7 @@ static vpx_codec_err_t vp8e_set_config(vpx_codec_alg_priv_t       *ctx,
         ctx->cfg = *cfg;
         set_vp8e_config(&ctx->oxcf, ctx->cfg, ctx->vp8_cfg);
         vp8_change_config(ctx->cpi, &ctx->oxcf);
+        simulcast_change_config(ctx);
     }
 
     return res;
@@ -448,6 +509,8 @@ static vpx_codec_err_t set_param(vpx_codec_alg_priv_t *ctx,
         MAP(VP8E_SET_ARNR_MAXFRAMES,        xcfg.arnr_max_frames);
         MAP(VP8E_SET_ARNR_STRENGTH ,        xcfg.arnr_strength);
         MAP(VP8E_SET_ARNR_TYPE     ,        xcfg.arnr_type);
+        MAP(VP8E_SET_LOW_MEMORY,            xcfg.low_memory);
+        MAP(VP8E_SET_MAX_FRAME_SIZE,        xcfg.max_frame_size);
 
     }
 
@@ -458,6 +521,7 @@ static vpx_codec_err_t set_param(vpx_codec_alg_priv_t *ctx,
         ctx->vp8_cfg = xcfg;
         set_vp8e_config(&ctx->oxcf, ctx->cfg, ctx->vp8_cfg);
         vp8_change_config(ctx->cpi, &ctx->oxcf);
+        simulcast_change_config(ctx);
     }
 
     return res;
@@ -533,9 +597,28 @@ static vpx_codec_err_t vp8e_init(vpx_codec_ctx_t *ctx)
     return res;
 }
 
+static void simulcast_destroy_layers(vpx_codec_alg_priv_t *ctx)
+{
+    unsigned int i;
+
+    for (i = 0; i < ctx->simulcast.layers; i++)
+    {
+        struct vp8_simulcast_layer *layer = &ctx->layer[i];
+
+        vp8_remove_compressor(&layer->cpi);
+        vp8_yv12_de_alloc_frame_buffer(&layer->src);
+        vp8_yv12_de_alloc_frame_buffer(&layer->scale_tmp);
+        free(layer->cx_data);
+        memset(layer, 0, sizeof(*layer));
+    }
+
+    ctx->simulcast.layers = 0;
+}
+
 static vpx_codec_err_t vp8e_destroy(vpx_codec_alg_priv_t *ctx)
 {
 
+    simulcast_destroy_layers(ctx);
     free(ctx->cx_data);
     vp8_remove_compressor(&ctx->cpi);
     free(ctx);
@@ -616,33 +699,13 @@ static void pick_quickcompress_mode(vpx_codec_alg_priv_t  *ctx,
     {
         ctx->oxcf.Mode = new_qc;
         vp8_change_config(ctx->cpi, &ctx->oxcf);
+        simulcast_change_config(ctx);
     }
 }
 
 
-static vpx_codec_err_t vp8e_encode(vpx_codec_alg_priv_t  *ctx,
-                                   const vpx_image_t     *img,
-                                   vpx_codec_pts_t        pts,
-                                   unsigned long          duration,
-                                   vpx_enc_frame_flags_t  flags,
-                                   unsigned long          deadline)
+static void set_reference_flags(VP8_PTR cpi, vpx_enc_frame_flags_t flags)
 {
-    vpx_codec_err_t res = VPX_CODEC_OK;
-
-    if (img)
-        res = validate_img(ctx, img);
-
-    pick_quickcompress_mode(ctx, duration, deadline);
-    vpx_codec_pkt_list_init(&ctx->pkt_list);
-
-    /* Handle Flags */
-    if (((flags & VP8_EFLAG_NO_UPD_GF) && (flags & VP8_EFLAG_FORCE_GF))
-        || ((flags & VP8_EFLAG_NO_UPD_ARF) && (flags & VP8_EFLAG_FORCE_ARF)))
-    {
-        ctx->base.err_detail = "Conflicting flags.";
-        return VPX_CODEC_INVALID_PARAM;
-    }
-
     if (flags & (VP8_EFLAG_NO_REF_LAST | VP8_EFLAG_NO_REF_GF
                  | VP8_EFLAG_NO_REF_ARF))
     {
@@ -657,7 +720,7 @@ static vpx_codec_err_t vp8e_encode(vpx_codec_alg_priv_t  *ctx,
         if (flags & VP8_EFLAG_NO_REF_ARF)
             ref ^= VP8_ALT_FLAG;
 
-        vp8_use_as_reference(ctx->cpi, ref);
+        vp8_use_as_reference(cpi, ref);
     }
 
     if (flags & (VP8_EFLAG_NO_UPD_LAST | VP8_EFLAG_NO_UPD_GF
@@ -675,14 +738,146 @@ static vpx_codec_err_t vp8e_encode(vpx_codec_alg_priv_t  *ctx,
         if (flags & VP8_EFLAG_NO_UPD_ARF)
             upd ^= VP8_ALT_FLAG;
 
-        vp8_update_reference(ctx->cpi, upd);
+        vp8_update_reference(cpi, upd);
     }
 
     if (flags & VP8_EFLAG_NO_UPD_ENTROPY)
     {
-        vp8_update_entropy(ctx->cpi, 0);
+        vp8_update_entropy(cpi, 0);
+    }
+}
+
+
+static void add_frame_stats(vp8e_frame_stats_t *sum,
+                            const vp8e_frame_stats_t *stats)
+{
+    int i;
+
+    sum->frames += stats->frames;
+    sum->total += stats->total;
+    sum->motion_search += stats->motion_search;
+    sum->mode_decision += stats->mode_decision;
+    sum->transform += stats->transform;
+    sum->tokenize += stats->tokenize;
+    sum->pick_lpf += stats->pick_lpf;
+    sum->pack += stats->pack;
+    sum->recodes += stats->recodes;
+    sum->skips += stats->skips;
+
+    for (i = 0; i < VP8E_FRAME_STATS_MODES; i++)
+        sum->modes[i] += stats->modes[i];
+}
+
+
+/* Drains the compressed frames available from one encoder instance into the
+ * packet list. Returns the number of frames added.
+ */
+static int get_frame_pkts(vpx_codec_alg_priv_t  *ctx,
+                          VP8_PTR                optr,
+                          unsigned char         *cx_data,
+                          unsigned long          cx_data_sz,
+                          int                    flush,
+                          unsigned int           layer_id)
+{
+    VP8_COMP *cpi = (VP8_COMP *)optr;
+    unsigned int lib_flags = 0;
+    unsigned long size, cx_data_limit = cx_data_sz / 2;
+    INT64 dst_time_stamp, dst_end_time_stamp;
+    int frames = 0;
+
+    while (cx_data_sz >= cx_data_limit
+           && -1 != vp8_get_compressed_data(optr, &lib_flags, &size, cx_data, &dst_time_stamp, &dst_end_time_stamp, flush))
+    {
+        /* Only the full resolution stream is measured */
+        if (ctx->frame_stats_enabled && optr == ctx->cpi)
+        {
+            vp8e_frame_stats_t stats;
+
+            vp8_get_frame_stats(optr, &stats);
+            add_frame_stats(&ctx->frame_stats, &stats);
+            add_frame_stats(&ctx->frame_stats_total, &stats);
+        }
+
+        if (size)
+        {
+            vpx_codec_pts_t    round, delta;
+            vpx_codec_cx_pkt_t pkt;
+
+            /* Add the frame packet to the list of returned packets. */
+            round = 1000000 * ctx->cfg.g_timebase.num / 2 - 1;
+            delta = (dst_end_time_stamp - dst_time_stamp);
+            pkt.kind = VPX_CODEC_CX_FRAME_PKT;
+            pkt.data.frame.buf = cx_data;
+            pkt.data.frame.sz  = size;
+            pkt.data.frame.pts =
+                (dst_time_stamp * ctx->cfg.g_timebase.den + round)
+                / ctx->cfg.g_timebase.num / 10000000;
+            pkt.data.frame.duration =
+                (delta * ctx->cfg.g_timebase.den + round)
+                / ctx->cfg.g_timebase.num / 10000000;
+            pkt.data.frame.flags = lib_flags << 16;
+            pkt.data.frame.layer_id = layer_id;
+
+            if (lib_flags & FRAMEFLAGS_KEY)
+                pkt.data.frame.flags |= VPX_FRAME_IS_KEY;
+
+            if (!cpi->common.show_frame)
+            {
+                pkt.data.frame.flags |= VPX_FRAME_IS_INVISIBLE;
+
+                // This timestamp should be as close as possible to the
+                // prior PTS so that if a decoder uses pts to schedule when
+                // to do this, we start right after last frame was decoded.
+                // Invisible frames have no duration.
+                pkt.data.frame.pts = ((cpi->last_time_stamp_seen
+                    * ctx->cfg.g_timebase.den + round)
+                    / ctx->cfg.g_timebase.num / 10000000) + 1;
+                pkt.data.frame.duration = 0;
+            }
+
+            vpx_codec_pkt_list_add(&ctx->pkt_list.head, &pkt);
+
+            //printf("timestamp: %lld, duration: %d\n", pkt->data.frame.pts, pkt->data.frame.duration);
+            cx_data += size;
+            cx_data_sz -= size;
+            frames++;
+        }
     }
 
+    return frames;
+}
+
+
+static vpx_codec_err_t vp8e_encode(vpx_codec_alg_priv_t  *ctx,
+                                   const vpx_image_t     *img,
+                                   vpx_codec_pts_t        pts,
+                                   unsigned long          duration,
+                                   vpx_enc_frame_flags_t  flags,
+                                   unsigned long          deadline)
+{
+    vpx_codec_err_t res = VPX_CODEC_OK;
+    unsigned int i;
+
+    if (img)
+        res = validate_img(ctx, img);
+
+    pick_quickcompress_mode(ctx, duration, deadline);
+    vpx_codec_pkt_list_init(&ctx->pkt_list);
+    memset(&ctx->frame_stats, 0, sizeof(ctx->frame_stats));
+
+    /* Handle Flags */
+    if (((flags & VP8_EFLAG_NO_UPD_GF) && (flags & VP8_EFLAG_FORCE_GF))
+        || ((flags & VP8_EFLAG_NO_UPD_ARF) && (flags & VP8_EFLAG_FORCE_ARF)))
+    {
+        ctx->base.err_detail = "Conflicting flags.";
+        return VPX_CODEC_INVALID_PARAM;
+    }
+
+    set_reference_flags(ctx->cpi, flags);
+
+    for (i = 0; i < ctx->simulcast.layers; i++)
+        set_reference_flags(ctx->layer[i].cpi, flags);
+
     /* Handle fixed keyframe intervals */
     if (ctx->cfg.kf_mode == VPX_KF_AUTO
         && ctx->cfg.kf_min_dist == ctx->cfg.kf_max_dist)
@@ -700,15 +895,21 @@ static vpx_codec_err_t vp8e_encode(vpx_codec_alg_priv_t  *ctx,
         unsigned int lib_flags;
         YV12_BUFFER_CONFIG sd;
         INT64 dst_time_stamp, dst_end_time_stamp;
-        unsigned long size, cx_data_sz;
-        unsigned char *cx_data;
+        VP8_PTR parent;
+        int frames;
 
         /* Set up internal flags */
         if (ctx->base.init_flags & VPX_CODEC_USE_PSNR)
+        {
             ((VP8_COMP *)ctx->cpi)->b_calculate_psnr = 1;
 
+            for (i = 0; i < ctx->simulcast.layers; i++)
+                ((VP8_COMP *)ctx->layer[i].cpi)->b_calculate_psnr = 1;
+        }
+
         /* Convert API flags to internal codec lib flags */
         lib_flags = (flags & VPX_EFLAG_FORCE_KF) ? FRAMEFLAGS_KEY : 0;
+        lib_flags |= ctx->next_frame_flag;
 
         /* vp8 use 10,000,000 ticks/second as time stamp */
         dst_time_stamp    = pts * 10000000 * ctx->cfg.g_timebase.num / ctx->cfg.g_timebase.den;
@@ -718,7 +919,7 @@ static vpx_codec_err_t vp8e_encode(vpx_codec_alg_priv_t  *ctx,
         {
             res = image2yuvconfig(img, &sd);
 
-            if (vp8_receive_raw_frame(ctx->cpi, ctx->next_frame_flag | lib_flags,
+            if (vp8_receive_raw_frame(ctx->cpi, lib_flags,
                                       &sd, dst_time_stamp, dst_end_time_stamp))
             {
                 VP8_COMP *cpi = (VP8_COMP *)ctx->cpi;
@@ -729,56 +930,42 @@ static vpx_codec_err_t vp8e_encode(vpx_codec_alg_priv_t  *ctx,
             ctx->next_frame_flag = 0;
         }
 
-        cx_data = ctx->cx_data;
-        cx_data_sz = ctx->cx_data_sz;
-        lib_flags = 0;
+        frames = get_frame_pkts(ctx, ctx->cpi, ctx->cx_data, ctx->cx_data_sz,
+                                !img, 0);
+
+        /* Each simulcast layer encodes a downscaled copy of the layer above
+         * it, reusing that layer's analysis when it coded the same frame.
+         */
+        parent = ctx->cpi;
 
-        while (cx_data_sz >= ctx->cx_data_sz / 2
-               && -1 != vp8_get_compressed_data(ctx->cpi, &lib_flags, &size, cx_data, &dst_time_stamp, &dst_end_time_stamp, !img))
+        for (i = 0; i < ctx->simulcast.layers; i++)
         {
-            if (size)
-            {
-                vpx_codec_pts_t    round, delta;
-                vpx_codec_cx_pkt_t pkt;
-                VP8_COMP *cpi = (VP8_COMP *)ctx->cpi;
+            struct vp8_simulcast_layer *layer = &ctx->layer[i];
 
-                /* Add the frame packet to the list of returned packets. */
-                round = 1000000 * ctx->cfg.g_timebase.num / 2 - 1;
-                delta = (dst_end_time_stamp - dst_time_stamp);
-                pkt.kind = VPX_CODEC_CX_FRAME_PKT;
-                pkt.data.frame.buf = cx_data;
-                pkt.data.frame.sz  = size;
-                pkt.data.frame.pts =
-                    (dst_time_stamp * ctx->cfg.g_timebase.den + round)
-                    / ctx->cfg.g_timebase.num / 10000000;
-                pkt.data.frame.duration =
-                    (delta * ctx->cfg.g_timebase.den + round)
-                    / ctx->cfg.g_timebase.num / 10000000;
-                pkt.data.frame.flags = lib_flags << 16;
-
-                if (lib_flags & FRAMEFLAGS_KEY)
-                    pkt.data.frame.flags |= VPX_FRAME_IS_KEY;
-
-                if (!cpi->common.show_frame)
+            if (img != NULL)
+            {
+                YV12_BUFFER_CONFIG *src = i ? &ctx->layer[i - 1].src : &sd;
+                int hr, hs, vr, vs;
+
+                Scale2Ratio(ctx->simulcast.scaling_mode[i].h_scaling_mode, &hr, &hs);
+                Scale2Ratio(ctx->simulcast.scaling_mode[i].v_scaling_mode, &vr, &vs);
+                vp8_scale_frame(src, &layer->src, layer->scale_tmp.y_buffer,
+                                ctx->simulcast.scaling_mode[i].v_scaling_mode == VP8E_ONETWO ? 9 : 11,
+                                hs, hr, vs, vr, 0);
+                layer->src.clrtype = sd.clrtype;
+
+                if (vp8_receive_raw_frame(layer->cpi, lib_flags, &layer->src,
+                                          dst_time_stamp, dst_end_time_stamp))
                 {
-                    pkt.data.frame.flags |= VPX_FRAME_IS_INVISIBLE;
-
-                    // This timestamp should be as close as possible to the
-                    // prior PTS so that if a decoder uses pts to schedule when
-                    // to do this, we start right after last frame was decoded.
-                    // Invisible frames have no duration.
-                    pkt.data.frame.pts = ((cpi->last_time_stamp_seen
-                        * ctx->cfg.g_timebase.den + round)
-                        / ctx->cfg.g_timebase.num / 10000000) + 1;
-                    pkt.data.frame.duration = 0;
+                    VP8_COMP *cpi = (VP8_COMP *)layer->cpi;
+                    res = update_error_state(ctx, &cpi->common.error);
                 }
-
-                vpx_codec_pkt_list_add(&ctx->pkt_list.head, &pkt);
-
-                //printf("timestamp: %lld, duration: %d\n", pkt->data.frame.pts, pkt->data.frame.duration);
-                cx_data += size;
-                cx_data_sz -= size;
             }
+
+            vp8_set_simulcast_parent(layer->cpi, frames ? parent : NULL);
+            frames = get_frame_pkts(ctx, layer->cpi, layer->cx_data,
+                                    layer->cx_data_sz, !img, i + 1);
+            parent = layer->cpi;
         }
     }
 
@@ -997,6 +1184,261 @@ static vpx_codec_err_t vp8e_set_scalemode(vpx_codec_alg_priv_t *ctx,
 }
 
 
+static vpx_codec_err_t vp8e_set_simulcast(vpx_codec_alg_priv_t *ctx,
+        int ctr_id,
+        va_list args)
+{
+#if CONFIG_SPATIAL_RESAMPLING
+    vpx_simulcast_cfg_t *data = va_arg(args, vpx_simulcast_cfg_t *);
+    unsigned int w = ctx->cfg.g_w;
+    unsigned int h = ctx->cfg.g_h;
+    unsigned int i;
+
+    if (!data)
+        return VPX_CODEC_INVALID_PARAM;
+
+    RANGE_CHECK_HI(data, layers, VPX_SIMULCAST_MAX_LAYERS);
+
+    if (data->layers
+        && (ctx->cfg.g_pass != VPX_RC_ONE_PASS || ctx->cfg.g_lag_in_frames))
+        ERROR("Simulcast requires one pass encoding with g_lag_in_frames 0");
+
+    simulcast_destroy_layers(ctx);
+
+    for (i = 0; i < data->layers; i++)
+    {
+        struct vp8_simulcast_layer *layer = &ctx->layer[i];
+        int hr, hs, vr, vs;
+
+        if (data->scaling_mode[i].h_scaling_mode > VP8E_ONETWO
+            || data->scaling_mode[i].v_scaling_mode > VP8E_ONETWO)
+            ERROR("Invalid simulcast scaling mode");
+
+        Scale2Ratio(data->scaling_mode[i].h_scaling_mode, &hr, &hs);
+        Scale2Ratio(data->scaling_mode[i].v_scaling_mode, &vr, &vs);
+        w = (hs - 1 + w * hr) / hs;
+        h = (vs - 1 + h * vr) / vs;
+
+        if (w < 16 || h < 16)
+            ERROR("Simulcast layer smaller than one macroblock");
+
+        layer->w = w;
+        layer->h = h;
+    }
+
+    ctx->simulcast = *data;
+    simulcast_change_config(ctx);
+
+    for (i = 0; i < ctx->simulcast.layers; i++)
+    {
+        struct vp8_simulcast_layer *layer = &ctx->layer[i];
+        int aligned_w = (layer->w + 15) & ~15;
+        int aligned_h = (layer->h + 15) & ~15;
+
+        layer->cx_data_sz = layer->w * layer->h * 3 / 2 * 2;
+
+        if (layer->cx_data_sz < 4096) layer->cx_data_sz = 4096;
+
+        layer->cx_data = malloc(layer->cx_data_sz);
+        layer->cpi = vp8_create_compressor(&layer->oxcf);
+
+        if (!layer->cx_data || !layer->cpi
+            || vp8_yv12_alloc_frame_buffer(&layer->src, aligned_w, aligned_h,
+                                           VP8BORDERINPIXELS)
+            || vp8_yv12_alloc_frame_buffer(&layer->scale_tmp, aligned_w, 16,
+                                           VP8BORDERINPIXELS))
+        {
+            simulcast_destroy_layers(ctx);
+            return VPX_CODEC_MEM_ERROR;
+        }
+    }
+
+    return VPX_CODEC_OK;
+#else
+    (void)ctx;
+    (void)ctr_id;
+    (void)args;
+    return VPX_CODEC_INCAPABLE;
+#endif
+}
+
+
+/* Resets an encoder instance for a new stream, reusing its compressor when
+ * the new stream fits the buffers and threads it already has. Otherwise the
+ * old compressor is only released once its replacement exists, so a failure
+ * leaves the instance with a usable compressor for the previous stream.
+ */
+static vpx_codec_err_t reset_compressor(VP8_PTR *cpi, VP8_CONFIG *oxcf)
+{
+    VP8_PTR new_cpi;
+
+    if (*cpi && !vp8_reset_compressor(*cpi, oxcf))
+        return VPX_CODEC_OK;
+
+    new_cpi = vp8_create_compressor(oxcf);
+
+    if (!new_cpi)
+        return VPX_CODEC_MEM_ERROR;
+
+    vp8_remove_compressor(cpi);
+    *cpi = new_cpi;
+
+    return VPX_CODEC_OK;
+}
+
+
+static vpx_codec_err_t vp8e_reset_stream(vpx_codec_alg_priv_t *ctx,
+        int ctr_id,
+        va_list args)
+{
+    vpx_codec_enc_cfg_t *data = va_arg(args, vpx_codec_enc_cfg_t *);
+    vpx_codec_enc_cfg_t  cfg = ctx->cfg;
+    VP8_CONFIG           oxcf;
+    vpx_codec_err_t      res;
+    unsigned int         i;
+
+    if (data)
+    {
+        if (ctx->simulcast.layers
+            && (data->g_w != ctx->cfg.g_w || data->g_h != ctx->cfg.g_h))
+            ERROR("Cannot change the size of a simulcast stream");
+
+        res = validate_config(ctx, data, &ctx->vp8_cfg);
+
+        if (res)
+            return res;
+
+        if (data->g_w * data->g_h * 3 / 2 * 2 > ctx->cx_data_sz)
+        {
+            unsigned char *cx_data = realloc(ctx->cx_data,
+                                             data->g_w * data->g_h * 3 / 2 * 2);
+
+            if (!cx_data)
+                return VPX_CODEC_MEM_ERROR;
+
+            ctx->cx_data = cx_data;
+            ctx->cx_data_sz = data->g_w * data->g_h * 3 / 2 * 2;
+        }
+
+        cfg = *data;
+    }
+
+    /* The context keeps describing the previous stream until its
+     * compressor has been reset for the new one.
+     */
+    set_vp8e_config(&oxcf, cfg, ctx->vp8_cfg);
+    res = reset_compressor(&ctx->cpi, &oxcf);
+
+    if (res)
+        return res;
+
+    ctx->cfg = cfg;
+    ctx->oxcf = oxcf;
+    ctx->next_frame_flag = 0;
+    ctx->fixed_kf_cntr = 0;
+    vpx_codec_pkt_list_init(&ctx->pkt_list);
+
+    vp8_set_frame_stats(ctx->cpi, ctx->frame_stats_enabled);
+
+    for (i = 0; i < ctx->simulcast.layers; i++)
+    {
+        struct vp8_simulcast_layer *layer = &ctx->layer[i];
+
+        layer->oxcf = ctx->oxcf;
+        layer->oxcf.Width = layer->w;
+        layer->oxcf.Height = layer->h;
+        layer->oxcf.target_bandwidth = ctx->simulcast.target_bitrate[i];
+
+        res = reset_compressor(&layer->cpi, &layer->oxcf);
+
+        if (res)
+        {
+            simulcast_destroy_layers(ctx);
+            return res;
+        }
+    }
+
+    return VPX_CODEC_OK;
+}
+
+static void add_memory_usage(vp8_memory_usage_t *sum,
+                             const vp8_memory_usage_t *usage)
+{
+    sum->context += usage->context;
+    sum->frame_buffers += usage->frame_buffers;
+    sum->lag_buffers += usage->lag_buffers;
+    sum->mode_info += usage->mode_info;
+    sum->tokens += usage->tokens;
+    sum->analysis += usage->analysis;
+    sum->threading += usage->threading;
+    sum->bitstream += usage->bitstream;
+    sum->total += usage->total;
+}
+
+
+static vpx_codec_err_t vp8e_get_memory_usage(vpx_codec_alg_priv_t *ctx,
+        int ctr_id,
+        va_list args)
+{
+    vp8_memory_usage_t *data = va_arg(args, vp8_memory_usage_t *);
+    vp8_memory_usage_t  usage;
+    unsigned int        i;
+
+    if (!data)
+        return VPX_CODEC_INVALID_PARAM;
+
+    vp8_get_memory_usage(ctx->cpi, data);
+    data->context += sizeof(*ctx);
+    data->bitstream += ctx->cx_data_sz;
+    data->total += sizeof(*ctx) + ctx->cx_data_sz;
+
+    for (i = 0; i < ctx->simulcast.layers; i++)
+    {
+        struct vp8_simulcast_layer *layer = &ctx->layer[i];
+        size_t frames = vp8_frame_buffer_bytes(&layer->src)
+                        + vp8_frame_buffer_bytes(&layer->scale_tmp);
+
+        vp8_get_memory_usage(layer->cpi, &usage);
+        usage.frame_buffers += frames;
+        usage.bitstream += layer->cx_data_sz;
+        usage.total += frames + layer->cx_data_sz;
+        add_memory_usage(data, &usage);
+    }
+
+    return VPX_CODEC_OK;
+}
+
+
+static vpx_codec_err_t vp8e_set_frame_stats(vpx_codec_alg_priv_t *ctx,
+        int ctr_id,
+        va_list args)
+{
+    ctx->frame_stats_enabled = va_arg(args, int) != 0;
+    memset(&ctx->frame_stats, 0, sizeof(ctx->frame_stats));
+    memset(&ctx->frame_stats_total, 0, sizeof(ctx->frame_stats_total));
+
+    if (ctx->cpi)
+        vp8_set_frame_stats(ctx->cpi, ctx->frame_stats_enabled);
+
+    return VPX_CODEC_OK;
+}
+
+
+static vpx_codec_err_t vp8e_get_frame_stats(vpx_codec_alg_priv_t *ctx,
+        int ctr_id,
+        va_list args)
+{
+    vp8e_frame_stats_t *data = va_arg(args, vp8e_frame_stats_t *);
+
+    if (!data)
+        return VPX_CODEC_INVALID_PARAM;
+
+    *data = ctr_id == VP8E_GET_FRAME_STATS_TOTAL ? ctx->frame_stats_total
+                                                  : ctx->frame_stats;
+    return VPX_CODEC_OK;
+}
+
+
 static vpx_codec_ctrl_fn_map_t vp8e_ctf_maps[] =
 {
     {VP8_SET_REFERENCE,                 vp8e_set_reference},
@@ -1020,6 +1462,14 @@ static vpx_codec_ctrl_fn_map_t vp8e_ctf_maps[] =
     {VP8E_SET_ARNR_MAXFRAMES,           set_param},
     {VP8E_SET_ARNR_STRENGTH ,           set_param},
     {VP8E_SET_ARNR_TYPE     ,           set_param},
+    {VP8E_SET_SIMULCAST,                vp8e_set_simulcast},
+    {VP8E_RESET_STREAM,                 vp8e_reset_stream},
+    {VP8E_SET_LOW_MEMORY,               set_param},
+    {VP8E_SET_MAX_FRAME_SIZE,           set_param},
+    {VP8_GET_MEMORY_USAGE,              vp8e_get_memory_usage},
+    {VP8E_SET_FRAME_STATS,              vp8e_set_frame_stats},
+    {VP8E_GET_FRAME_STATS,              vp8e_get_frame_stats},
+    {VP8E_GET_FRAME_STATS_TOTAL,        vp8e_get_frame_stats},
     { -1, NULL},
 };
 
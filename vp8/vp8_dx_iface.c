@@ -71,6 +71,7 @@ struct vpx_codec_alg_priv
     VP8D_PTR                pbi;
     int                     postproc_cfg_set;
     vp8_postproc_cfg_t      postproc_cfg;
+    int                     timing_enabled;
     vpx_image_t             img;
     int                     img_setup;
     int                     img_avail;
@@ -406,7 +407,10 @@ static vpx_codec_err_t vp8_decode(vpx_codec_alg_priv_t  *ctx,
             if (!optr)
                 res = VPX_CODEC_ERROR;
             else
+            {
                 ctx->pbi = optr;
+                vp8dx_set_timing(optr, ctx->timing_enabled);
+            }
         }
 
         ctx->decoder_init = 1;
@@ -646,12 +650,63 @@ static vpx_codec_err_t vp8_set_postproc(vpx_codec_alg_priv_t *ctx,
 #endif
 }
 
+static vpx_codec_err_t vp8_get_memory_usage(vpx_codec_alg_priv_t *ctx,
+        int ctr_id,
+        va_list args)
+{
+    vp8_memory_usage_t *data = va_arg(args, vp8_memory_usage_t *);
+
+    if (!data)
+        return VPX_CODEC_INVALID_PARAM;
+
+    /* Nothing is allocated until the first frame is decoded */
+    if (ctx->pbi)
+        vp8dx_get_memory_usage(ctx->pbi, data);
+    else
+        memset(data, 0, sizeof(*data));
+
+    return VPX_CODEC_OK;
+}
+
+static vpx_codec_err_t vp8_set_timing(vpx_codec_alg_priv_t *ctx,
+                                      int ctr_id,
+                                      va_list args)
+{
+    ctx->timing_enabled = va_arg(args, int);
+
+    /* Applied when the decoder is created, if it hasn't been yet */
+    if (ctx->pbi)
+        vp8dx_set_timing(ctx->pbi, ctx->timing_enabled);
+
+    return VPX_CODEC_OK;
+}
+
+static vpx_codec_err_t vp8_get_timing(vpx_codec_alg_priv_t *ctx,
+                                      int ctr_id,
+                                      va_list args)
+{
+    vp8d_timing_t *data = va_arg(args, vp8d_timing_t *);
+
+    if (!data)
+        return VPX_CODEC_INVALID_PARAM;
+
+    if (ctx->pbi)
+        vp8dx_get_timing(ctx->pbi, data);
+    else
+        memset(data, 0, sizeof(*data));
+
+    return VPX_CODEC_OK;
+}
+
 
 vpx_codec_ctrl_fn_map_t vp8_ctf_maps[] =
 {
     {VP8_SET_REFERENCE,  vp8_set_reference},
     {VP8_COPY_REFERENCE, vp8_get_reference},
     {VP8_SET_POSTPROC,   vp8_set_postproc},
+    {VP8_GET_MEMORY_USAGE, vp8_get_memory_usage},
+    {VP8D_SET_TIMING,    vp8_set_timing},
+    {VP8D_GET_TIMING,    vp8_get_timing},
     { -1, NULL},
 };
 
@@ -53,6 +53,7 @@ VP8_CX_SRCS-yes += encoder/encodeintra.h
 VP8_CX_SRCS-yes += encoder/encodemb.h
 VP8_CX_SRCS-yes += encoder/encodemv.h
 VP8_CX_SRCS-yes += encoder/firstpass.h
+VP8_CX_SRCS-yes += encoder/mbanalysis.h
 VP8_CX_SRCS-yes += encoder/mcomp.h
 VP8_CX_SRCS-yes += encoder/modecosts.h
 VP8_CX_SRCS-yes += encoder/onyx_int.h
@@ -64,6 +65,7 @@ VP8_CX_SRCS-yes += encoder/rdopt.h
 VP8_CX_SRCS-yes += encoder/tokenize.h
 VP8_CX_SRCS-yes += encoder/treewriter.h
 VP8_CX_SRCS-yes += encoder/variance.h
+VP8_CX_SRCS-yes += encoder/mbanalysis.c
 VP8_CX_SRCS-yes += encoder/mcomp.c
 VP8_CX_SRCS-yes += encoder/modecosts.c
 VP8_CX_SRCS-yes += encoder/onyx_if.c
@@ -0,0 +1,1147 @@
+/*
+ *  Copyright (c) 2010 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+/* Micro-benchmark for the VP8 run time CPU detected (RTCD) kernels.
+ *
+ * Each kernel is called directly through the same function tables the
+ * codec uses, once for the C reference and once for every other
+ * implementation available on the host, over a fixed set of randomized
+ * blocks and, with --input, blocks of real content. Every implementation
+ * is checked for bit-exactness against the C reference on both sets, and
+ * its best time over several repetitions is reported per call.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <limits.h>
+#include "vpx_ports/config.h"
+#include "vpx_ports/mem.h"
+#include "vpx_ports/vpx_timer.h"
+#include "vpx_mem/vpx_mem.h"
+#include "vpx/vpx_image.h"
+#if ARCH_X86 || ARCH_X86_64
+#include "vpx_ports/x86.h"
+#endif
+#include "vp8/encoder/onyx_int.h"
+#include "systemdependent.h"
+#include "loopfilter.h"
+#include "postproc.h"
+#include "y4minput.h"
+#include "args.h"
+
+extern void vp8_cmachine_specific_config(VP8_COMP *cpi);
+extern void vp8cx_init_quantizer(VP8_COMP *cpi);
+extern int vp8_q2mbl(int x);
+
+static const char *exec_name;
+
+static const arg_def_t input_arg = ARG_DEF("i", "input", 1,
+                                   "Y4M file to take real content from");
+static const arg_def_t seed_arg = ARG_DEF(NULL, "seed", 1,
+                                  "Seed for the randomized inputs (default 1)");
+static const arg_def_t calls_arg = ARG_DEF("n", "calls", 1,
+                                   "Calls per timed repetition (default 4096)");
+static const arg_def_t reps_arg = ARG_DEF("r", "reps", 1,
+                                  "Timed repetitions, the best is kept (default 5)");
+static const arg_def_t kernel_arg = ARG_DEF("k", "kernel", 1,
+                                    "Only run kernels whose name contains this");
+static const arg_def_t help_arg = ARG_DEF("h", "help", 0,
+                                  "Show usage options and exit");
+static const arg_def_t *main_args[] =
+{
+    &input_arg, &seed_arg, &calls_arg, &reps_arg, &kernel_arg, &help_arg,
+    NULL
+};
+
+static void usage_exit()
+{
+    fprintf(stderr, "Usage: %s <options>\n\nOptions:\n", exec_name);
+    arg_show_usage(stderr, main_args);
+    exit(EXIT_FAILURE);
+}
+
+void die(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    fprintf(stderr, "\n");
+    usage_exit();
+}
+
+
+/* Inputs cycled through by every kernel. A power of two. */
+#define INPUTS      64
+
+/* The area blocks are taken from, and the border around it that motion
+ * vectors and filter taps may reach into.
+ */
+#define AREA_W      320
+#define AREA_H      192
+#define BORDER      32
+#define STRIDE      (AREA_W + 2 * BORDER)
+#define PLANE_SIZE  (STRIDE * (AREA_H + 2 * BORDER))
+
+/* Kernels that filter in place run on a fresh copy of their input each
+ * call: a 16x16 luma block with 16 pixels of context on each side, then
+ * two chroma blocks with 8 rows and 16 columns of context.
+ */
+#define WORK_STRIDE 48
+#define WORK_Y      (16 * WORK_STRIDE + 16)
+#define WORK_U      (56 * WORK_STRIDE + 16)
+#define WORK_V      (88 * WORK_STRIDE + 16)
+#define WORK_SIZE   (112 * WORK_STRIDE)
+
+#define OUT_SIZE    (INPUTS * WORK_SIZE)
+
+typedef void (*bench_fn_t)(void);
+typedef prototype_berr((*bench_berr_fn_t));
+typedef prototype_quantize_block((*bench_quant_fn_t));
+
+enum bench_kind
+{
+    BK_SAD,
+    BK_SAD3,
+    BK_SAD4D,
+    BK_VAR,
+    BK_VAR2,
+    BK_SUBPIXVAR,
+    BK_GETMBSS,
+    BK_PREDICT,
+    BK_FDCT,
+    BK_WALSH,
+    BK_BERR,
+    BK_QUANT,
+    BK_IDCT,
+    BK_IDCT1_ADD,
+    BK_IWALSH,
+    BK_LF,
+    BK_PP_DOWN,
+    BK_PP_ACROSS,
+    BK_PP_DOWNACROSS,
+    BK_PP_ADDNOISE,
+    BK_PP_BLEND
+};
+
+/* The prototype of each kind, for declaring the C references. */
+#define proto_SAD           prototype_sad
+#define proto_SAD3          prototype_sad_multi_same_address
+#define proto_SAD4D         prototype_sad_multi_dif_address
+#define proto_VAR           prototype_variance
+#define proto_VAR2          prototype_variance2
+#define proto_SUBPIXVAR     prototype_subpixvariance
+#define proto_GETMBSS       prototype_getmbss
+#define proto_PREDICT       prototype_subpixel_predict
+#define proto_FDCT          prototype_fdct
+#define proto_WALSH         prototype_fdct
+#define proto_BERR          prototype_berr
+#define proto_QUANT         prototype_quantize_block
+#define proto_IDCT          prototype_idct
+#define proto_IDCT1_ADD     prototype_idct_scalar_add
+#define proto_IWALSH        prototype_second_order
+#define proto_LF            prototype_loopfilter_block
+#define proto_PP_DOWN       prototype_postproc_inplace
+#define proto_PP_ACROSS     prototype_postproc_inplace
+#define proto_PP_DOWNACROSS prototype_postproc
+#define proto_PP_ADDNOISE   prototype_postproc_addnoise
+#define proto_PP_BLEND      prototype_postproc_blend_mb
+
+/* K(group, table, member, C reference, kind, width, height)
+ *
+ * The group selects the <group>_INVOKE macro and the table is the RTCD
+ * vtable in VP8_COMP it is read from, so without runtime CPU detection the
+ * statically selected implementation is picked up instead.
+ */
+#define BENCH_KERNELS \
+    K(VARIANCE, rtcd.variance, sad16x16, vp8_sad16x16_c, SAD, 16, 16) \
+    K(VARIANCE, rtcd.variance, sad16x8, vp8_sad16x8_c, SAD, 16, 8) \
+    K(VARIANCE, rtcd.variance, sad8x16, vp8_sad8x16_c, SAD, 8, 16) \
+    K(VARIANCE, rtcd.variance, sad8x8, vp8_sad8x8_c, SAD, 8, 8) \
+    K(VARIANCE, rtcd.variance, sad4x4, vp8_sad4x4_c, SAD, 4, 4) \
+    K(VARIANCE, rtcd.variance, sad16x16x3, vp8_sad16x16x3_c, SAD3, 16, 16) \
+    K(VARIANCE, rtcd.variance, sad16x8x3, vp8_sad16x8x3_c, SAD3, 16, 8) \
+    K(VARIANCE, rtcd.variance, sad8x16x3, vp8_sad8x16x3_c, SAD3, 8, 16) \
+    K(VARIANCE, rtcd.variance, sad8x8x3, vp8_sad8x8x3_c, SAD3, 8, 8) \
+    K(VARIANCE, rtcd.variance, sad4x4x3, vp8_sad4x4x3_c, SAD3, 4, 4) \
+    K(VARIANCE, rtcd.variance, sad16x16x4d, vp8_sad16x16x4d_c, SAD4D, 16, 16) \
+    K(VARIANCE, rtcd.variance, sad16x8x4d, vp8_sad16x8x4d_c, SAD4D, 16, 8) \
+    K(VARIANCE, rtcd.variance, sad8x16x4d, vp8_sad8x16x4d_c, SAD4D, 8, 16) \
+    K(VARIANCE, rtcd.variance, sad8x8x4d, vp8_sad8x8x4d_c, SAD4D, 8, 8) \
+    K(VARIANCE, rtcd.variance, sad4x4x4d, vp8_sad4x4x4d_c, SAD4D, 4, 4) \
+    K(VARIANCE, rtcd.variance, var16x16, vp8_variance16x16_c, VAR, 16, 16) \
+    K(VARIANCE, rtcd.variance, var16x8, vp8_variance16x8_c, VAR, 16, 8) \
+    K(VARIANCE, rtcd.variance, var8x16, vp8_variance8x16_c, VAR, 8, 16) \
+    K(VARIANCE, rtcd.variance, var8x8, vp8_variance8x8_c, VAR, 8, 8) \
+    K(VARIANCE, rtcd.variance, var4x4, vp8_variance4x4_c, VAR, 4, 4) \
+    K(VARIANCE, rtcd.variance, subpixvar16x16, vp8_sub_pixel_variance16x16_c, SUBPIXVAR, 16, 16) \
+    K(VARIANCE, rtcd.variance, subpixvar16x8, vp8_sub_pixel_variance16x8_c, SUBPIXVAR, 16, 8) \
+    K(VARIANCE, rtcd.variance, subpixvar8x16, vp8_sub_pixel_variance8x16_c, SUBPIXVAR, 8, 16) \
+    K(VARIANCE, rtcd.variance, subpixvar8x8, vp8_sub_pixel_variance8x8_c, SUBPIXVAR, 8, 8) \
+    K(VARIANCE, rtcd.variance, subpixvar4x4, vp8_sub_pixel_variance4x4_c, SUBPIXVAR, 4, 4) \
+    K(VARIANCE, rtcd.variance, subpixmse16x16, vp8_sub_pixel_mse16x16_c, SUBPIXVAR, 16, 16) \
+    K(VARIANCE, rtcd.variance, halfpixvar16x16_h, vp8_variance_halfpixvar16x16_h_c, VAR, 16, 16) \
+    K(VARIANCE, rtcd.variance, halfpixvar16x16_v, vp8_variance_halfpixvar16x16_v_c, VAR, 16, 16) \
+    K(VARIANCE, rtcd.variance, halfpixvar16x16_hv, vp8_variance_halfpixvar16x16_hv_c, VAR, 16, 16) \
+    K(VARIANCE, rtcd.variance, mse16x16, vp8_mse16x16_c, VAR, 16, 16) \
+    K(VARIANCE, rtcd.variance, getmbss, vp8_get_mb_ss_c, GETMBSS, 16, 16) \
+    K(VARIANCE, rtcd.variance, get16x16prederror, vp8_get16x16pred_error_c, SAD, 16, 16) \
+    K(VARIANCE, rtcd.variance, get16x16var, vp8_get16x16var_c, VAR2, 16, 16) \
+    K(VARIANCE, rtcd.variance, get8x8var, vp8_get8x8var_c, VAR2, 8, 8) \
+    K(VARIANCE, rtcd.variance, get4x4sse_cs, vp8_get4x4sse_cs_c, SAD, 4, 4) \
+    K(VARIANCE, rtcd.variance, satd4x4, vp8_satd4x4_c, SAD, 4, 4) \
+    K(SUBPIX, common.rtcd.subpix, sixtap16x16, vp8_sixtap_predict16x16_c, PREDICT, 16, 16) \
+    K(SUBPIX, common.rtcd.subpix, sixtap8x8, vp8_sixtap_predict8x8_c, PREDICT, 8, 8) \
+    K(SUBPIX, common.rtcd.subpix, sixtap8x4, vp8_sixtap_predict8x4_c, PREDICT, 8, 4) \
+    K(SUBPIX, common.rtcd.subpix, sixtap4x4, vp8_sixtap_predict_c, PREDICT, 4, 4) \
+    K(SUBPIX, common.rtcd.subpix, bilinear16x16, vp8_bilinear_predict16x16_c, PREDICT, 16, 16) \
+    K(SUBPIX, common.rtcd.subpix, bilinear8x8, vp8_bilinear_predict8x8_c, PREDICT, 8, 8) \
+    K(SUBPIX, common.rtcd.subpix, bilinear8x4, vp8_bilinear_predict8x4_c, PREDICT, 8, 4) \
+    K(SUBPIX, common.rtcd.subpix, bilinear4x4, vp8_bilinear_predict4x4_c, PREDICT, 4, 4) \
+    K(FDCT, rtcd.fdct, short4x4, vp8_short_fdct4x4_c, FDCT, 4, 4) \
+    K(FDCT, rtcd.fdct, short8x4, vp8_short_fdct8x4_c, FDCT, 8, 4) \
+    K(FDCT, rtcd.fdct, fast4x4, vp8_short_fdct4x4_c, FDCT, 4, 4) \
+    K(FDCT, rtcd.fdct, fast8x4, vp8_short_fdct8x4_c, FDCT, 8, 4) \
+    K(FDCT, rtcd.fdct, walsh_short4x4, vp8_short_walsh4x4_c, WALSH, 4, 4) \
+    K(ENCODEMB, rtcd.encodemb, berr, vp8_block_error_c, BERR, 4, 4) \
+    K(QUANTIZE, rtcd.quantize, quantb, vp8_regular_quantize_b, QUANT, 4, 4) \
+    K(QUANTIZE, rtcd.quantize, fastquantb, vp8_fast_quantize_b_c, QUANT, 4, 4) \
+    K(IDCT, common.rtcd.idct, idct16, vp8_short_idct4x4llm_c, IDCT, 4, 4) \
+    K(IDCT, common.rtcd.idct, idct1, vp8_short_idct4x4llm_1_c, IDCT, 4, 4) \
+    K(IDCT, common.rtcd.idct, idct1_scalar_add, vp8_dc_only_idct_add_c, IDCT1_ADD, 4, 4) \
+    K(IDCT, common.rtcd.idct, iwalsh16, vp8_short_inv_walsh4x4_c, IWALSH, 4, 4) \
+    K(IDCT, common.rtcd.idct, iwalsh1, vp8_short_inv_walsh4x4_1_c, IWALSH, 4, 4) \
+    K(LF, common.rtcd.loopfilter, normal_mb_v, vp8_loop_filter_mbv_c, LF, 16, 16) \
+    K(LF, common.rtcd.loopfilter, normal_b_v, vp8_loop_filter_bv_c, LF, 16, 16) \
+    K(LF, common.rtcd.loopfilter, normal_mb_h, vp8_loop_filter_mbh_c, LF, 16, 16) \
+    K(LF, common.rtcd.loopfilter, normal_b_h, vp8_loop_filter_bh_c, LF, 16, 16) \
+    K(LF, common.rtcd.loopfilter, simple_mb_v, vp8_loop_filter_mbvs_c, LF, 16, 16) \
+    K(LF, common.rtcd.loopfilter, simple_b_v, vp8_loop_filter_bvs_c, LF, 16, 16) \
+    K(LF, common.rtcd.loopfilter, simple_mb_h, vp8_loop_filter_mbhs_c, LF, 16, 16) \
+    K(LF, common.rtcd.loopfilter, simple_b_h, vp8_loop_filter_bhs_c, LF, 16, 16) \
+    BENCH_POSTPROC_KERNELS
+
+#if CONFIG_POSTPROC
+#define BENCH_POSTPROC_KERNELS \
+    K(POSTPROC, common.rtcd.postproc, down, vp8_mbpost_proc_down_c, PP_DOWN, 16, 16) \
+    K(POSTPROC, common.rtcd.postproc, across, vp8_mbpost_proc_across_ip_c, PP_ACROSS, 16, 16) \
+    K(POSTPROC, common.rtcd.postproc, downacross, vp8_post_proc_down_and_across_c, PP_DOWNACROSS, 16, 16) \
+    K(POSTPROC, common.rtcd.postproc, addnoise, vp8_plane_add_noise_c, PP_ADDNOISE, 16, 16) \
+    K(POSTPROC, common.rtcd.postproc, blend_mb, vp8_blend_mb_c, PP_BLEND, 16, 16)
+#else
+#define BENCH_POSTPROC_KERNELS
+#endif
+
+/* Declare the C references, which the arch headers may have replaced. */
+#define K(grp, tbl, fn, c_fn, kind, w, h) extern proto_##kind(c_fn);
+BENCH_KERNELS
+#undef K
+
+#define K(grp, tbl, fn, c_fn, kind, w, h) \
+    static bench_fn_t get_##grp##_##fn(VP8_COMP *cpi) \
+    { \
+        return (bench_fn_t)grp##_INVOKE(&cpi->tbl, fn); \
+    }
+BENCH_KERNELS
+#undef K
+
+struct bench_kernel
+{
+    const char       *name;
+    enum bench_kind   kind;
+    int               w, h;
+    bench_fn_t        c_fn;
+    bench_fn_t      (*get)(VP8_COMP *cpi);
+};
+
+static const struct bench_kernel kernels[] =
+{
+#define K(grp, tbl, fn, c_fn, kind, w, h) \
+    {#fn, BK_##kind, w, h, (bench_fn_t)c_fn, get_##grp##_##fn},
+    BENCH_KERNELS
+#undef K
+};
+
+#define KERNELS (sizeof(kernels) / sizeof(kernels[0]))
+
+struct bench_impl
+{
+    const char *name;
+    bench_fn_t  fn[KERNELS];
+};
+
+/* The C reference, then one set per instruction set level on x86, or the
+ * implementations the build selected otherwise.
+ */
+#define MAX_IMPLS   6
+
+struct bench_data
+{
+    const char *name;
+    VP8_COMP   *cpi;
+    DECLARE_ALIGNED(16, unsigned char, src[PLANE_SIZE]);
+    DECLARE_ALIGNED(16, unsigned char, ref[PLANE_SIZE]);
+    DECLARE_ALIGNED(16, short, diff[INPUTS][256]);
+    DECLARE_ALIGNED(16, short, coeff[INPUTS][16]);
+    DECLARE_ALIGNED(16, short, dqcoeff[INPUTS][16]);
+    DECLARE_ALIGNED(16, short, y2[INPUTS][16]);
+    DECLARE_ALIGNED(16, short, y2coeff[INPUTS][16]);
+    int src_off[INPUTS];
+    int ref_off[INPUTS];
+    int pel_x[INPUTS], pel_y[INPUTS];   /* eighth pel, for the predictors */
+    int sub_x[INPUTS], sub_y[INPUTS];   /* quarter pel, for the variances */
+    int q[INPUTS];
+    int level[INPUTS];
+    int ppl[INPUTS];
+    int mbl[INPUTS];
+};
+
+static struct bench_data data_sets[2];
+
+DECLARE_ALIGNED(16, static unsigned char, out_ref[OUT_SIZE]);
+DECLARE_ALIGNED(16, static unsigned char, out_test[OUT_SIZE]);
+DECLARE_ALIGNED(16, static char, noise[512]);
+DECLARE_ALIGNED(16, static char, blackclamp[16]);
+DECLARE_ALIGNED(16, static char, whiteclamp[16]);
+DECLARE_ALIGNED(16, static char, bothclamp[16]);
+
+/* A small generator of our own, so the inputs don't depend on the C
+ * library.
+ */
+static unsigned int rand_state;
+
+static unsigned int bench_rand(void)
+{
+    rand_state = rand_state * 1103515245 + 12345;
+    return (rand_state >> 16) & 0x7fff;
+}
+
+
+static int slot_size(enum bench_kind kind)
+{
+    switch (kind)
+    {
+    case BK_PREDICT:
+        return 256;
+    case BK_FDCT:
+    case BK_IDCT1_ADD:
+        return 64;
+    case BK_WALSH:
+    case BK_IWALSH:
+        return 32;
+    case BK_QUANT:
+        return 80;
+    case BK_IDCT:
+        return 128;
+    case BK_LF:
+    case BK_PP_DOWN:
+    case BK_PP_ACROSS:
+    case BK_PP_DOWNACROSS:
+    case BK_PP_ADDNOISE:
+    case BK_PP_BLEND:
+        return WORK_SIZE;
+    default:
+        return 16;
+    }
+}
+
+static int is_inplace(enum bench_kind kind)
+{
+    return slot_size(kind) == WORK_SIZE;
+}
+
+
+static void copy_rect(unsigned char *dst, const unsigned char *src,
+                      int w, int h)
+{
+    int r;
+
+    for (r = 0; r < h; r++)
+        memcpy(dst + r * WORK_STRIDE, src + r * STRIDE, w);
+}
+
+static void fill_work(struct bench_data *d, int i, unsigned char *work)
+{
+    const unsigned char *y = d->src + d->src_off[i];
+    const unsigned char *u = d->src + d->src_off[(i + 1) & (INPUTS - 1)];
+    const unsigned char *v = d->src + d->src_off[(i + 2) & (INPUTS - 1)];
+
+    copy_rect(work, y - 16 * STRIDE - 16, WORK_STRIDE, 48);
+    copy_rect(work + WORK_U - 8 * WORK_STRIDE - 16,
+              u - 8 * STRIDE - 16, WORK_STRIDE, 32);
+    copy_rect(work + WORK_V - 8 * WORK_STRIDE - 16,
+              v - 8 * STRIDE - 16, WORK_STRIDE, 32);
+}
+
+static void setup_block(VP8_COMP *cpi, int q, short *coeff,
+                        BLOCK *b, BLOCKD *bd)
+{
+    b->coeff = coeff;
+    b->quant = cpi->Y1quant[q];
+    b->quant_shift = cpi->Y1quant_shift[q];
+    b->zbin = cpi->Y1zbin[q];
+    b->round = cpi->Y1round[q];
+    b->zrun_zbin_boost = cpi->zrun_zbin_boost_y1[q];
+    b->zbin_extra = 0;
+    bd->dequant = cpi->common.Y1dequant[q];
+}
+
+
+/* Runs a kernel over `calls` inputs, writing the result for each input to
+ * its slot in out. Kernels that work in place are handed a fresh copy of
+ * their input each call; with a NULL fn only the copy is made, so its cost
+ * can be taken out of the timing.
+ */
+static void run_kernel(const struct bench_kernel *k, bench_fn_t fn,
+                       struct bench_data *d, unsigned char *out, int calls)
+{
+    const int size = slot_size(k->kind);
+    int n, i;
+
+#define FOR_EACH_CALL \
+    for (n = 0, i = 0; n < calls; n++, i = n & (INPUTS - 1))
+#define SLOT (out + i * size)
+#define SRC (d->src + d->src_off[i])
+#define REF (d->ref + d->ref_off[i])
+
+    switch (k->kind)
+    {
+    case BK_SAD:
+    {
+        vp8_sad_fn_t f = (vp8_sad_fn_t)fn;
+
+        FOR_EACH_CALL
+        *(unsigned int *)SLOT = f(SRC, STRIDE, REF, STRIDE, INT_MAX);
+        break;
+    }
+    case BK_SAD3:
+    {
+        vp8_sad_multi_fn_t f = (vp8_sad_multi_fn_t)fn;
+
+        FOR_EACH_CALL
+        f(SRC, STRIDE, REF, STRIDE, (unsigned int *)SLOT);
+        break;
+    }
+    case BK_SAD4D:
+    {
+        vp8_sad_multi_d_fn_t f = (vp8_sad_multi_d_fn_t)fn;
+        unsigned char *refs[4];
+
+        FOR_EACH_CALL
+        {
+            refs[0] = REF - STRIDE;
+            refs[1] = REF - 1;
+            refs[2] = REF + 1;
+            refs[3] = REF + STRIDE;
+            f(SRC, STRIDE, refs, STRIDE, (unsigned int *)SLOT);
+        }
+        break;
+    }
+    case BK_VAR:
+    {
+        vp8_variance_fn_t f = (vp8_variance_fn_t)fn;
+        unsigned int *res;
+
+        FOR_EACH_CALL
+        {
+            res = (unsigned int *)SLOT;
+            res[0] = f(REF, STRIDE, SRC, STRIDE, res + 1);
+        }
+        break;
+    }
+    case BK_VAR2:
+    {
+        vp8_variance2_fn_t f = (vp8_variance2_fn_t)fn;
+        unsigned int *res;
+
+        FOR_EACH_CALL
+        {
+            res = (unsigned int *)SLOT;
+            res[0] = f(SRC, STRIDE, REF, STRIDE, res + 1, (int *)res + 2);
+        }
+        break;
+    }
+    case BK_SUBPIXVAR:
+    {
+        vp8_subpixvariance_fn_t f = (vp8_subpixvariance_fn_t)fn;
+        unsigned int *res;
+
+        FOR_EACH_CALL
+        {
+            res = (unsigned int *)SLOT;
+            res[0] = f(REF, STRIDE, d->sub_x[i], d->sub_y[i],
+                       SRC, STRIDE, res + 1);
+        }
+        break;
+    }
+    case BK_GETMBSS:
+    {
+        vp8_getmbss_fn_t f = (vp8_getmbss_fn_t)fn;
+
+        FOR_EACH_CALL
+        *(unsigned int *)SLOT = f(d->diff[i]);
+        break;
+    }
+    case BK_PREDICT:
+    {
+        vp8_subpix_fn_t f = (vp8_subpix_fn_t)fn;
+
+        FOR_EACH_CALL
+        f(REF, STRIDE, d->pel_x[i], d->pel_y[i], SLOT, 16);
+        break;
+    }
+    case BK_FDCT:
+    {
+        vp8_fdct_fn_t f = (vp8_fdct_fn_t)fn;
+
+        FOR_EACH_CALL
+        f(d->diff[i] + (i >> 2 & 3) * 64 + (i & 2) * 4, (short *)SLOT, 32);
+        break;
+    }
+    case BK_WALSH:
+    {
+        vp8_fdct_fn_t f = (vp8_fdct_fn_t)fn;
+
+        FOR_EACH_CALL
+        f(d->y2[i], (short *)SLOT, 8);
+        break;
+    }
+    case BK_BERR:
+    {
+        bench_berr_fn_t f = (bench_berr_fn_t)fn;
+
+        FOR_EACH_CALL
+        *(int *)SLOT = f(d->coeff[i], d->dqcoeff[i]);
+        break;
+    }
+    case BK_QUANT:
+    {
+        bench_quant_fn_t f = (bench_quant_fn_t)fn;
+        BLOCK b;
+        BLOCKD bd;
+
+        FOR_EACH_CALL
+        {
+            setup_block(d->cpi, d->q[i], d->coeff[i], &b, &bd);
+            bd.qcoeff = (short *)SLOT;
+            bd.dqcoeff = (short *)SLOT + 16;
+            f(&b, &bd);
+            *(int *)(SLOT + 64) = bd.eob;
+        }
+        break;
+    }
+    case BK_IDCT:
+    {
+        vp8_idct_fn_t f = (vp8_idct_fn_t)fn;
+
+        FOR_EACH_CALL
+        f(d->dqcoeff[i], (short *)SLOT, 32);
+        break;
+    }
+    case BK_IDCT1_ADD:
+    {
+        vp8_idct_scalar_add_fn_t f = (vp8_idct_scalar_add_fn_t)fn;
+
+        FOR_EACH_CALL
+        f(d->dqcoeff[i][0], REF, SLOT, STRIDE, 16);
+        break;
+    }
+    case BK_IWALSH:
+    {
+        vp8_second_order_fn_t f = (vp8_second_order_fn_t)fn;
+
+        FOR_EACH_CALL
+        f(d->y2coeff[i], (short *)SLOT);
+        break;
+    }
+    case BK_LF:
+    {
+        vp8_lf_block_fn_t f = (vp8_lf_block_fn_t)fn;
+        loop_filter_info *lfi = d->cpi->common.lf_info;
+
+        FOR_EACH_CALL
+        {
+            fill_work(d, i, SLOT);
+
+            if (f)
+                f(SLOT + WORK_Y, SLOT + WORK_U, SLOT + WORK_V,
+                  WORK_STRIDE, WORK_STRIDE, lfi + d->level[i], 0);
+        }
+        break;
+    }
+#if CONFIG_POSTPROC
+    case BK_PP_DOWN:
+    case BK_PP_ACROSS:
+    {
+        vp8_postproc_inplace_fn_t f = (vp8_postproc_inplace_fn_t)fn;
+
+        FOR_EACH_CALL
+        {
+            fill_work(d, i, SLOT);
+
+            if (f)
+                f(SLOT + WORK_Y, WORK_STRIDE, 16, 16, d->mbl[i]);
+        }
+        break;
+    }
+    case BK_PP_DOWNACROSS:
+    {
+        vp8_postproc_fn_t f = (vp8_postproc_fn_t)fn;
+
+        FOR_EACH_CALL
+        {
+            fill_work(d, i, SLOT);
+
+            if (f)
+                f(SLOT + WORK_Y, SLOT + WORK_U, WORK_STRIDE, WORK_STRIDE,
+                  16, 16, d->ppl[i]);
+        }
+        break;
+    }
+    case BK_PP_ADDNOISE:
+    {
+        vp8_postproc_addnoise_fn_t f = (vp8_postproc_addnoise_fn_t)fn;
+
+        FOR_EACH_CALL
+        {
+            fill_work(d, i, SLOT);
+
+            if (f)
+                f(SLOT + WORK_Y, noise, blackclamp, whiteclamp, bothclamp,
+                  16, 16, WORK_STRIDE);
+        }
+        break;
+    }
+    case BK_PP_BLEND:
+    {
+        vp8_postproc_blend_mb_fn_t f = (vp8_postproc_blend_mb_fn_t)fn;
+
+        FOR_EACH_CALL
+        {
+            fill_work(d, i, SLOT);
+
+            if (f)
+                f(SLOT + WORK_Y, SLOT + WORK_U, SLOT + WORK_V,
+                  d->q[i], 128 - d->q[i], 64 + d->q[i],
+                  0x8000 + d->level[i] * 256, WORK_STRIDE);
+        }
+        break;
+    }
+#endif
+    default:
+        break;
+    }
+
+#undef FOR_EACH_CALL
+#undef SLOT
+#undef SRC
+#undef REF
+    vp8_clear_system_state();
+}
+
+
+/* Cycles on x86, nanoseconds elsewhere. */
+#if ARCH_X86 || ARCH_X86_64
+#define BENCH_UNIT "cycles"
+
+struct bench_clock
+{
+    unsigned int start;
+};
+
+static void clock_start(struct bench_clock *c)
+{
+    c->start = x86_readtsc();
+}
+
+static double clock_elapsed(struct bench_clock *c)
+{
+    return (unsigned int)(x86_readtsc() - c->start);
+}
+#else
+#define BENCH_UNIT "ns"
+
+struct bench_clock
+{
+    struct vpx_usec_timer timer;
+};
+
+static void clock_start(struct bench_clock *c)
+{
+    vpx_usec_timer_start(&c->timer);
+}
+
+static double clock_elapsed(struct bench_clock *c)
+{
+    vpx_usec_timer_mark(&c->timer);
+    return vpx_usec_timer_elapsed(&c->timer) * 1000.0;
+}
+#endif
+
+static double best_time(const struct bench_kernel *k, bench_fn_t fn,
+                        struct bench_data *d, int calls, int reps)
+{
+    struct bench_clock clock;
+    double best = 0, t;
+    int r;
+
+    /* One untimed pass to warm the caches */
+    run_kernel(k, fn, d, out_test, INPUTS);
+
+    for (r = 0; r < reps; r++)
+    {
+        clock_start(&clock);
+        run_kernel(k, fn, d, out_test, calls);
+        t = clock_elapsed(&clock);
+
+        if (!r || t < best)
+            best = t;
+    }
+
+    return best;
+}
+
+static double time_kernel(const struct bench_kernel *k, bench_fn_t fn,
+                          struct bench_data *d, int calls, int reps)
+{
+    double t = best_time(k, fn, d, calls, reps);
+
+    if (is_inplace(k->kind))
+    {
+        t -= best_time(k, NULL, d, calls, reps);
+
+        if (t < 0)
+            t = 0;
+    }
+
+    return t / calls;
+}
+
+/* The C postproc filters also write the 8 lines before the block, from
+ * partly uninitialized state, so only the block itself is compared.
+ */
+static int slot_differs(enum bench_kind kind, const unsigned char *a,
+                        const unsigned char *b, int size)
+{
+    int r;
+
+    if (kind != BK_PP_DOWN && kind != BK_PP_ACROSS)
+        return memcmp(a, b, size) != 0;
+
+    for (r = 0; r < 16; r++)
+        if (memcmp(a + WORK_Y + r * WORK_STRIDE,
+                   b + WORK_Y + r * WORK_STRIDE, 16))
+            return 1;
+
+    return 0;
+}
+
+/* Returns the number of inputs whose output differs from the reference.
+ * Both runs start from the same buffer contents and random seed, since a
+ * few postproc kernels draw from rand() themselves.
+ */
+static int check_kernel(const struct bench_kernel *k, bench_fn_t fn,
+                        struct bench_data *d, unsigned int seed)
+{
+    const int size = slot_size(k->kind);
+    int i, bad = 0;
+
+    memset(out_ref, 0xa5, INPUTS * size);
+    srand(seed);
+    run_kernel(k, k->c_fn, d, out_ref, INPUTS);
+
+    memset(out_test, 0xa5, INPUTS * size);
+    srand(seed);
+    run_kernel(k, fn, d, out_test, INPUTS);
+
+    for (i = 0; i < INPUTS; i++)
+        if (slot_differs(k->kind, out_ref + i * size, out_test + i * size,
+                         size))
+            bad++;
+
+    return bad;
+}
+
+
+/* Fills the plane, border included, from the centre of the image, with
+ * the edge pixels extended as the codec does.
+ */
+static void load_plane(unsigned char *plane, const vpx_image_t *img)
+{
+    const int x0 = img->d_w > AREA_W ? (img->d_w - AREA_W) / 2 : 0;
+    const int y0 = img->d_h > AREA_H ? (img->d_h - AREA_H) / 2 : 0;
+    int r, c;
+
+    for (r = 0; r < AREA_H + 2 * BORDER; r++)
+    {
+        int y = y0 + r - BORDER;
+
+        y = y < 0 ? 0 : y >= (int)img->d_h ? img->d_h - 1 : y;
+
+        for (c = 0; c < STRIDE; c++)
+        {
+            int x = x0 + c - BORDER;
+
+            x = x < 0 ? 0 : x >= (int)img->d_w ? img->d_w - 1 : x;
+            plane[r * STRIDE + c] =
+                img->planes[VPX_PLANE_Y][y * img->stride[VPX_PLANE_Y] + x];
+        }
+    }
+}
+
+static int load_y4m(struct bench_data *d, const char *fn)
+{
+    FILE *f = fopen(fn, "rb");
+    y4m_input y4m;
+    vpx_image_t img;
+    int ok = 0;
+
+    if (!f)
+        return 0;
+
+    if (y4m_input_open(&y4m, f, NULL, 0) >= 0)
+    {
+        if (y4m_input_fetch_frame(&y4m, f, &img) > 0)
+        {
+            load_plane(d->src, &img);
+
+            /* A still image is its own reference */
+            if (y4m_input_fetch_frame(&y4m, f, &img) > 0)
+                load_plane(d->ref, &img);
+            else
+                memcpy(d->ref, d->src, PLANE_SIZE);
+
+            ok = 1;
+        }
+
+        y4m_input_close(&y4m);
+    }
+
+    fclose(f);
+    return ok;
+}
+
+static void fill_random(struct bench_data *d)
+{
+    int i;
+
+    for (i = 0; i < PLANE_SIZE; i++)
+    {
+        d->src[i] = bench_rand() & 0xff;
+        d->ref[i] = bench_rand() & 0xff;
+    }
+}
+
+/* Picks the blocks and parameters for each input, and derives the
+ * coefficients from them with the C reference.
+ */
+static void setup_inputs(struct bench_data *d, VP8_COMP *cpi)
+{
+    short qcoeff[16], dct[16];
+    BLOCK b;
+    BLOCKD bd;
+    int i, r, c, blk;
+
+    d->cpi = cpi;
+
+    for (i = 0; i < INPUTS; i++)
+    {
+        int x = bench_rand() % (AREA_W / 16) * 16;
+        int y = bench_rand() % (AREA_H / 16) * 16;
+        int mx = bench_rand() % 33 - 16;
+        int my = bench_rand() % 33 - 16;
+        double level;
+
+        d->src_off[i] = (BORDER + y) * STRIDE + BORDER + x;
+        d->ref_off[i] = d->src_off[i] + my * STRIDE + mx;
+
+        do
+        {
+            d->pel_x[i] = bench_rand() & 7;
+            d->pel_y[i] = bench_rand() & 7;
+        }
+        while (!d->pel_x[i] && !d->pel_y[i]);
+
+        do
+        {
+            d->sub_x[i] = bench_rand() & 6;
+            d->sub_y[i] = bench_rand() & 6;
+        }
+        while (!d->sub_x[i] && !d->sub_y[i]);
+
+        d->q[i] = bench_rand() % QINDEX_RANGE;
+        d->level[i] = 1 + bench_rand() % MAX_LOOP_FILTER;
+
+        level = 6.0e-05 * (d->q[i] & 63) * (d->q[i] & 63) * (d->q[i] & 63)
+                - .0067 * (d->q[i] & 63) * (d->q[i] & 63)
+                + .306 * (d->q[i] & 63) + .0065;
+        d->ppl[i] = (int)(level + .5);
+#if CONFIG_POSTPROC
+        d->mbl[i] = vp8_q2mbl(d->q[i] & 63);
+#endif
+
+        for (r = 0; r < 16; r++)
+            for (c = 0; c < 16; c++)
+                d->diff[i][r * 16 + c] = d->src[d->src_off[i] + r * STRIDE + c]
+                                         - d->ref[d->ref_off[i] + r * STRIDE + c];
+
+        for (blk = 0; blk < 16; blk++)
+        {
+            vp8_short_fdct4x4_c(d->diff[i] + (blk >> 2) * 64 + (blk & 3) * 4,
+                                dct, 32);
+            d->y2[i][blk] = dct[0];
+
+            if (blk == (i & 15))
+                memcpy(d->coeff[i], dct, sizeof(dct));
+        }
+
+        vp8_short_walsh4x4_c(d->y2[i], d->y2coeff[i], 8);
+
+        setup_block(cpi, d->q[i], d->coeff[i], &b, &bd);
+        bd.qcoeff = qcoeff;
+        bd.dqcoeff = d->dqcoeff[i];
+        vp8_regular_quantize_b(&b, &bd);
+    }
+}
+
+
+/* Reads every kernel out of freshly initialized function tables. */
+static void load_impl(struct bench_impl *impl, const char *name,
+                      VP8_COMP *cpi)
+{
+    unsigned int k;
+
+    vp8_machine_specific_config(&cpi->common);
+    vp8_cmachine_specific_config(cpi);
+
+    impl->name = name;
+
+    for (k = 0; k < KERNELS; k++)
+        impl->fn[k] = kernels[k].get(cpi);
+}
+
+#if CONFIG_RUNTIME_CPU_DETECT && (ARCH_X86 || ARCH_X86_64)
+static const struct
+{
+    const char *name;
+    int         caps;
+} isa_levels[] =
+{
+    {"mmx",   HAS_MMX},
+    {"sse2",  HAS_MMX | HAS_SSE | HAS_SSE2},
+    {"sse3",  HAS_MMX | HAS_SSE | HAS_SSE2 | HAS_SSE3},
+    {"ssse3", HAS_MMX | HAS_SSE | HAS_SSE2 | HAS_SSE3 | HAS_SSSE3}
+};
+
+/* The tables are filled from x86_simd_caps(), which honors this. */
+static void set_simd_caps(int caps)
+{
+    static char env[32];
+
+    sprintf(env, "VPX_SIMD_CAPS=0x%x", caps);
+    putenv(env);
+}
+#endif
+
+static int load_impls(struct bench_impl *impls, VP8_COMP *cpi)
+{
+    int n = 0;
+    unsigned int k;
+
+    impls[n].name = "c";
+
+    for (k = 0; k < KERNELS; k++)
+        impls[n].fn[k] = kernels[k].c_fn;
+
+    n++;
+
+#if CONFIG_RUNTIME_CPU_DETECT && (ARCH_X86 || ARCH_X86_64)
+    {
+        int host = x86_simd_caps();
+        unsigned int l;
+
+        for (l = 0; l < sizeof(isa_levels) / sizeof(isa_levels[0]); l++)
+        {
+            if ((isa_levels[l].caps & host) != isa_levels[l].caps)
+                continue;
+
+            set_simd_caps(isa_levels[l].caps);
+            load_impl(&impls[n++], isa_levels[l].name, cpi);
+        }
+
+        set_simd_caps(host);
+    }
+#else
+    load_impl(&impls[n++], "native", cpi);
+#endif
+
+    return n;
+}
+
+
+int main(int argc, const char **argv_)
+{
+    struct bench_impl        impls[MAX_IMPLS];
+    double                   times[MAX_IMPLS][2];
+    const char              *input_fn = NULL;
+    const char              *only = NULL;
+    unsigned int             seed = 1;
+    int                      calls = 4096, reps = 5;
+    int                      impl_count, set_count, mismatches = 0;
+    unsigned int             k;
+    int                      i, s, j;
+    VP8_COMP                *cpi;
+    char                   **argv, **argi, **argj;
+    struct arg               arg;
+
+    exec_name = argv_[0];
+    argv = argv_dup(argc - 1, argv_ + 1);
+
+    for (argi = argj = argv; (*argj = *argi); argi += arg.argv_step)
+    {
+        arg.argv_step = 1;
+
+        if (arg_match(&arg, &input_arg, argi))
+            input_fn = arg.val;
+        else if (arg_match(&arg, &seed_arg, argi))
+            seed = arg_parse_uint(&arg);
+        else if (arg_match(&arg, &calls_arg, argi))
+            calls = arg_parse_uint(&arg);
+        else if (arg_match(&arg, &reps_arg, argi))
+            reps = arg_parse_uint(&arg);
+        else if (arg_match(&arg, &kernel_arg, argi))
+            only = arg.val;
+        else if (arg_match(&arg, &help_arg, argi))
+            usage_exit();
+        else
+            argj++;
+    }
+
+    if (argv[0])
+        die("Error: Unrecognized option %s\n", argv[0]);
+
+    free(argv);
+
+    /* Whole passes over the inputs, so every input weighs the same */
+    calls = (calls + INPUTS - 1) & ~(INPUTS - 1);
+
+    if (calls < INPUTS)
+        calls = INPUTS;
+
+    if (reps < 1)
+        reps = 1;
+
+    cpi = vpx_memalign(32, sizeof(*cpi));
+
+    if (!cpi)
+        die("Failed to allocate the encoder tables");
+
+    vpx_memset(cpi, 0, sizeof(*cpi));
+    vp8cx_init_quantizer(cpi);
+    vp8_init_loop_filter(&cpi->common);
+
+    rand_state = seed;
+
+    for (i = 0; i < (int)sizeof(noise); i++)
+        noise[i] = (char)(bench_rand() % 17) - 8;
+
+    for (i = 0; i < 16; i++)
+    {
+        blackclamp[i] = 8;
+        whiteclamp[i] = 8;
+        bothclamp[i] = 16;
+    }
+
+    data_sets[0].name = "random";
+    fill_random(&data_sets[0]);
+    setup_inputs(&data_sets[0], cpi);
+    set_count = 1;
+
+    if (input_fn)
+    {
+        if (!load_y4m(&data_sets[1], input_fn))
+            die("Failed to read a frame from %s", input_fn);
+
+        data_sets[1].name = "real";
+        setup_inputs(&data_sets[1], cpi);
+        set_count = 2;
+    }
+
+    impl_count = load_impls(impls, cpi);
+
+    printf("%d inputs, %d calls, best of %d, %s per call\n\n",
+           INPUTS, calls, reps, BENCH_UNIT);
+    printf("%-20s %-8s", "kernel", "impl");
+
+    for (s = 0; s < set_count; s++)
+        printf(" %10s", data_sets[s].name);
+
+    printf(" %8s  %s\n", "speedup", "exact");
+
+    for (k = 0; k < KERNELS; k++)
+    {
+        const struct bench_kernel *kern = &kernels[k];
+
+        if (only && !strstr(kern->name, only))
+            continue;
+
+        for (i = 0; i < impl_count; i++)
+        {
+            int bad = 0;
+
+            /* Each implementation is shown under the first level that
+             * selects it.
+             */
+            for (j = 0; j < i; j++)
+                if (impls[j].fn[k] == impls[i].fn[k])
+                    break;
+
+            if (j < i)
+                continue;
+
+            for (s = 0; s < set_count; s++)
+            {
+                if (i)
+                    bad += check_kernel(kern, impls[i].fn[k], &data_sets[s],
+                                        seed);
+
+                times[i][s] = time_kernel(kern, impls[i].fn[k], &data_sets[s],
+                                          calls, reps);
+            }
+
+            printf("%-20s %-8s", i ? "" : kern->name, impls[i].name);
+
+            for (s = 0; s < set_count; s++)
+                printf(" %10.1f", times[i][s]);
+
+            if (i)
+            {
+                double c = times[0][set_count - 1];
+                double t = times[i][set_count - 1];
+
+                printf(" %7.2fx  %s", t > 0 ? c / t : 0.0,
+                       bad ? "MISMATCH" : "ok");
+            }
+
+            printf("\n");
+
+            if (bad)
+            {
+                fprintf(stderr, "%s (%s): %d of %d inputs differ from C\n",
+                        kern->name, impls[i].name, bad, INPUTS * set_count);
+                mismatches++;
+            }
+        }
+    }
+
+    vpx_free(cpi);
+    return mismatches ? EXIT_FAILURE : EXIT_SUCCESS;
+}
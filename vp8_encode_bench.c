@@ -0,0 +1,677 @@
+/*
+ *  Copyright (c) 2010 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+/* End to end speed/quality benchmark for the VP8 encoder.
+ *
+ * Every clip is encoded once for each combination of the deadline,
+ * --cpu-used, --threads and --token-parts values given, and the speed,
+ * bitrate, PSNR and SSIM of each encode are written out as JSON, so the
+ * effect of a change to the speed features can be read off as a curve.
+ *
+ * The clips are Y4M files, read into memory up front so that only the
+ * encoder is timed. Without any, a synthetic panning clip is generated.
+ * PSNR comes from the encoder's own PSNR packets; SSIM is measured here
+ * on the reconstructed frames, outside of the timed section.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <math.h>
+#include "vpx/vpx_encoder.h"
+#include "vpx/vp8cx.h"
+#include "vpx_ports/vpx_timer.h"
+#include "y4minput.h"
+#include "args.h"
+
+static const char *exec_name;
+
+static const arg_def_t deadline_arg = ARG_DEF("d", "deadline", 1,
+                                      "Deadlines to encode at: best, good, rt (default good,rt)");
+static const arg_def_t cpu_used_arg = ARG_DEF(NULL, "cpu-used", 1,
+                                      "CPU used values (default 0,2,4)");
+static const arg_def_t threads_arg = ARG_DEF("t", "threads", 1,
+                                     "Thread counts (default 1)");
+static const arg_def_t token_parts_arg = ARG_DEF(NULL, "token-parts", 1,
+                                         "Token partition settings, 0-3 (default 0)");
+static const arg_def_t bitrate_arg = ARG_DEF(NULL, "target-bitrate", 1,
+                                     "Bitrate in kbps (default 600)");
+static const arg_def_t limit_arg = ARG_DEF(NULL, "limit", 1,
+                                   "Encode at most this many frames of each clip (default 60)");
+static const arg_def_t synthetic_arg = ARG_DEF(NULL, "synthetic", 1,
+                                       "Size of the synthetic clip used without inputs (default 352x288)");
+static const arg_def_t output_arg = ARG_DEF("o", "output", 1,
+                                    "Write the JSON report here instead of stdout");
+static const arg_def_t help_arg = ARG_DEF("h", "help", 0,
+                                  "Show usage options and exit");
+static const arg_def_t *main_args[] =
+{
+    &deadline_arg, &cpu_used_arg, &threads_arg, &token_parts_arg,
+    &bitrate_arg, &limit_arg, &synthetic_arg, &output_arg, &help_arg,
+    NULL
+};
+
+static void usage_exit()
+{
+    fprintf(stderr, "Usage: %s <options> [clip.y4m ...]\n\nOptions:\n",
+            exec_name);
+    arg_show_usage(stderr, main_args);
+    fprintf(stderr, "\nLists are comma separated, e.g. --cpu-used=0,2,4.\n");
+    exit(EXIT_FAILURE);
+}
+
+void die(const char *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    vfprintf(stderr, fmt, ap);
+    fprintf(stderr, "\n");
+    usage_exit();
+}
+
+
+#define MAX_VALUES 16
+
+struct value_list
+{
+    int values[MAX_VALUES];
+    int count;
+};
+
+static void parse_list(struct value_list *list, const struct arg *arg)
+{
+    const char *s = arg->val;
+    char *end;
+
+    list->count = 0;
+
+    while (*s)
+    {
+        if (list->count == MAX_VALUES)
+            die("Option %s: at most %d values", arg->name, MAX_VALUES);
+
+        list->values[list->count++] = strtol(s, &end, 10);
+
+        if (end == s || (*end && *end != ','))
+            die("Option %s: bad list %s", arg->name, arg->val);
+
+        s = *end ? end + 1 : end;
+    }
+
+    if (!list->count)
+        die("Option %s: empty list", arg->name);
+}
+
+static const struct
+{
+    const char    *name;
+    unsigned long  deadline;
+} deadlines[] =
+{
+    {"best", VPX_DL_BEST_QUALITY},
+    {"good", VPX_DL_GOOD_QUALITY},
+    {"rt",   VPX_DL_REALTIME}
+};
+
+#define DEADLINES (sizeof(deadlines) / sizeof(deadlines[0]))
+
+static void parse_deadlines(struct value_list *list, const struct arg *arg)
+{
+    const char *s = arg->val;
+    unsigned int i;
+    size_t len;
+
+    list->count = 0;
+
+    while (*s)
+    {
+        len = strcspn(s, ",");
+
+        for (i = 0; i < DEADLINES; i++)
+            if (strlen(deadlines[i].name) == len
+                && !strncmp(s, deadlines[i].name, len))
+                break;
+
+        if (i == DEADLINES || list->count == MAX_VALUES)
+            die("Option %s: bad list %s", arg->name, arg->val);
+
+        list->values[list->count++] = i;
+        s += len;
+
+        if (*s)
+            s++;
+    }
+
+    if (!list->count)
+        die("Option %s: empty list", arg->name);
+}
+
+
+struct clip
+{
+    const char   *name;
+    unsigned int  w, h;
+    int           fps_n, fps_d;
+    int           frames;
+    vpx_image_t  *img;
+};
+
+static int read_clip(struct clip *clip, const char *fn, int limit)
+{
+    FILE *f = fopen(fn, "rb");
+    y4m_input y4m;
+
+    if (!f)
+        return 0;
+
+    if (y4m_input_open(&y4m, f, NULL, 0) < 0)
+    {
+        fclose(f);
+        return 0;
+    }
+
+    clip->name = fn;
+    clip->w = y4m.pic_w;
+    clip->h = y4m.pic_h;
+    clip->fps_n = y4m.fps_n;
+    clip->fps_d = y4m.fps_d;
+    clip->frames = 0;
+    clip->img = calloc(limit, sizeof(*clip->img));
+
+    while (clip->img && clip->frames < limit)
+    {
+        vpx_image_t *img = &clip->img[clip->frames];
+
+        /* No stride alignment, as vpx_img_alloc sizes planar buffers from
+         * the width rather than the padded stride.
+         */
+        if (!vpx_img_alloc(img, VPX_IMG_FMT_I420, clip->w, clip->h, 1))
+            break;
+
+        if (y4m_input_fetch_frame_into(&y4m, f, img) < 1)
+        {
+            vpx_img_free(img);
+            break;
+        }
+
+        clip->frames++;
+    }
+
+    y4m_input_close(&y4m);
+    fclose(f);
+    return clip->frames > 0;
+}
+
+/* A smooth random texture panning down and to the right, with a block
+ * moving the other way across it. The same every run.
+ */
+static int make_synthetic(struct clip *clip, unsigned int w, unsigned int h,
+                          int frames)
+{
+    const unsigned int tw = w + 2 * frames + 2, th = h + frames + 3;
+    unsigned char *tex = malloc(tw * th);
+    unsigned int seed = 1;
+    unsigned int x, y, pass;
+    int plane, t;
+
+    if (!tex)
+        return 0;
+
+    for (y = 0; y < tw * th; y++)
+    {
+        seed = seed * 1103515245 + 12345;
+        tex[y] = (seed >> 16) & 0xff;
+    }
+
+    /* Blurring the noise a few times gives it some spatial correlation */
+    for (pass = 0; pass < 4; pass++)
+        for (y = 1; y < th - 1; y++)
+            for (x = 1; x < tw - 1; x++)
+                tex[y * tw + x] = (tex[(y - 1) * tw + x] + tex[y * tw + x - 1]
+                                   + 4 * tex[y * tw + x] + tex[y * tw + x + 1]
+                                   + tex[(y + 1) * tw + x] + 4) >> 3;
+
+    clip->name = "synthetic";
+    clip->w = w;
+    clip->h = h;
+    clip->fps_n = 30;
+    clip->fps_d = 1;
+    clip->frames = 0;
+    clip->img = calloc(frames, sizeof(*clip->img));
+
+    for (t = 0; clip->img && t < frames; t++)
+    {
+        vpx_image_t *img = &clip->img[t];
+
+        if (!vpx_img_alloc(img, VPX_IMG_FMT_I420, w, h, 1))
+            break;
+
+        for (plane = 0; plane < 3; plane++)
+        {
+            unsigned int pw = plane ? (w + 1) >> 1 : w;
+            unsigned int ph = plane ? (h + 1) >> 1 : h;
+            unsigned int bx = (w - w / 4 * t / frames - w / 4) >> !!plane;
+            unsigned int by = (h / 3) >> !!plane;
+            unsigned int bs = (w / 5) >> !!plane;
+
+            for (y = 0; y < ph; y++)
+                for (x = 0; x < pw; x++)
+                {
+                    unsigned char *p = img->planes[plane]
+                                       + y * img->stride[plane] + x;
+
+                    if (x >= bx && x < bx + bs && y >= by && y < by + bs)
+                        *p = plane ? 96 + 32 * plane : 220;
+                    else if (plane)
+                        *p = 128 + ((tex[(2 * y + t + plane) * tw + 2 * x + 2 * t]
+                                     - 128) >> 2);
+                    else
+                        *p = tex[(y + t) * tw + x + 2 * t];
+                }
+        }
+
+        clip->frames++;
+    }
+
+    free(tex);
+    return clip->frames == frames;
+}
+
+static void free_clip(struct clip *clip)
+{
+    int i;
+
+    for (i = 0; i < clip->frames; i++)
+        vpx_img_free(&clip->img[i]);
+
+    free(clip->img);
+}
+
+
+/* SSIM over 8x8 windows on a 4 pixel grid, with the usual constants for
+ * 8 bit samples.
+ */
+static double ssim_plane(const unsigned char *a, int a_stride,
+                         const unsigned char *b, int b_stride,
+                         unsigned int w, unsigned int h)
+{
+    const double c1 = 0.01 * 255 * 0.01 * 255 * 64 * 64;
+    const double c2 = 0.03 * 255 * 0.03 * 255 * 64 * 64;
+    double total = 0;
+    unsigned int x, y, i, j;
+    int windows = 0;
+
+    for (y = 0; y + 8 <= h; y += 4)
+        for (x = 0; x + 8 <= w; x += 4)
+        {
+            unsigned int sa = 0, sb = 0, saa = 0, sbb = 0, sab = 0;
+            double ma, mb, va, vb, cov;
+
+            for (i = 0; i < 8; i++)
+                for (j = 0; j < 8; j++)
+                {
+                    int pa = a[(y + i) * a_stride + x + j];
+                    int pb = b[(y + i) * b_stride + x + j];
+
+                    sa += pa;
+                    sb += pb;
+                    saa += pa * pa;
+                    sbb += pb * pb;
+                    sab += pa * pb;
+                }
+
+            ma = sa;
+            mb = sb;
+            va = 64.0 * saa - ma * ma;
+            vb = 64.0 * sbb - mb * mb;
+            cov = 64.0 * sab - ma * mb;
+            total += (2 * ma * mb + c1) * (2 * cov + c2)
+                     / ((ma * ma + mb * mb + c1) * (va + vb + c2));
+            windows++;
+        }
+
+    return windows ? total / windows : 1.0;
+}
+
+static void ssim_frame(const vpx_image_t *a, const vpx_image_t *b,
+                       double ssim[4])
+{
+    int plane;
+
+    for (plane = 0; plane < 3; plane++)
+    {
+        unsigned int w = plane ? (a->d_w + 1) >> 1 : a->d_w;
+        unsigned int h = plane ? (a->d_h + 1) >> 1 : a->d_h;
+
+        ssim[plane + 1] = ssim_plane(a->planes[plane], a->stride[plane],
+                                     b->planes[plane], b->stride[plane],
+                                     w, h);
+    }
+
+    ssim[0] = ssim[1] * .8 + .1 * (ssim[2] + ssim[3]);
+}
+
+
+struct result
+{
+    int      frames;
+    uint64_t bytes;
+    double   encode_seconds;
+    int      psnr_count;
+    double   psnr_sum[4];
+    uint64_t sse;
+    uint64_t samples;
+    int      ssim_count;
+    double   ssim_sum[4];
+};
+
+/* Collects the packets of one encode call. A shown frame is compared
+ * against its source right away, while it is the encoder's preview.
+ */
+static void get_packets(vpx_codec_ctx_t *codec, const struct clip *clip,
+                        struct result *res, int *got_data)
+{
+    vpx_codec_iter_t iter = NULL;
+    const vpx_codec_cx_pkt_t *pkt;
+    int shown = -1, i;
+
+    *got_data = 0;
+
+    while ((pkt = vpx_codec_get_cx_data(codec, &iter)))
+    {
+        *got_data = 1;
+
+        switch (pkt->kind)
+        {
+        case VPX_CODEC_CX_FRAME_PKT:
+            res->bytes += pkt->data.frame.sz;
+
+            if (!(pkt->data.frame.flags & VPX_FRAME_IS_INVISIBLE))
+            {
+                res->frames++;
+                shown = (int)pkt->data.frame.pts;
+            }
+
+            break;
+        case VPX_CODEC_PSNR_PKT:
+            for (i = 0; i < 4; i++)
+                res->psnr_sum[i] += pkt->data.psnr.psnr[i];
+
+            res->sse += pkt->data.psnr.sse[0];
+            res->samples += pkt->data.psnr.samples[0];
+            res->psnr_count++;
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (shown >= 0 && shown < clip->frames)
+    {
+        const vpx_image_t *recon = vpx_codec_get_preview_frame(codec);
+        double ssim[4];
+
+        if (recon)
+        {
+            ssim_frame(&clip->img[shown], recon, ssim);
+
+            for (i = 0; i < 4; i++)
+                res->ssim_sum[i] += ssim[i];
+
+            res->ssim_count++;
+        }
+    }
+}
+
+static void encode_clip(const struct clip *clip, vpx_codec_enc_cfg_t *cfg,
+                        unsigned long deadline, int cpu_used,
+                        int token_parts, struct result *res)
+{
+    vpx_codec_ctx_t codec;
+    struct vpx_usec_timer timer;
+    int64_t usec = 0;
+    int t, got_data;
+
+    memset(res, 0, sizeof(*res));
+
+    cfg->g_w = clip->w;
+    cfg->g_h = clip->h;
+    cfg->g_timebase.num = clip->fps_d;
+    cfg->g_timebase.den = clip->fps_n;
+
+    if (vpx_codec_enc_init(&codec, vpx_codec_vp8_cx(), cfg, VPX_CODEC_USE_PSNR)
+        || vpx_codec_control(&codec, VP8E_SET_CPUUSED, cpu_used)
+        || vpx_codec_control(&codec, VP8E_SET_TOKEN_PARTITIONS, token_parts))
+    {
+        fprintf(stderr, "Failed to initialize encoder: %s\n",
+                vpx_codec_error(&codec));
+        exit(EXIT_FAILURE);
+    }
+
+    for (t = 0; ; t++)
+    {
+        const vpx_image_t *img = t < clip->frames ? &clip->img[t] : NULL;
+
+        vpx_usec_timer_start(&timer);
+
+        if (vpx_codec_encode(&codec, img, t, 1, 0, deadline))
+        {
+            fprintf(stderr, "Failed to encode frame: %s\n",
+                    vpx_codec_error(&codec));
+            exit(EXIT_FAILURE);
+        }
+
+        vpx_usec_timer_mark(&timer);
+        usec += vpx_usec_timer_elapsed64(&timer);
+
+        get_packets(&codec, clip, res, &got_data);
+
+        if (!img && !got_data)
+            break;
+    }
+
+    res->encode_seconds = usec / 1000000.0;
+    vpx_codec_destroy(&codec);
+}
+
+
+static void write_string(FILE *f, const char *s)
+{
+    fputc('"', f);
+
+    for (; *s; s++)
+    {
+        if (*s == '"' || *s == '\\')
+            fprintf(f, "\\%c", *s);
+        else if ((unsigned char)*s < 0x20)
+            fprintf(f, "\\u%04x", *s);
+        else
+            fputc(*s, f);
+    }
+
+    fputc('"', f);
+}
+
+static void write_result(FILE *f, const struct clip *clip,
+                         const vpx_codec_enc_cfg_t *cfg, const char *deadline,
+                         int cpu_used, int token_parts,
+                         const struct result *res, int first)
+{
+    const double duration = (double)clip->frames * clip->fps_d / clip->fps_n;
+    double psnr_overall = 100.0;
+    int n;
+
+    if (res->sse)
+        psnr_overall = 10.0 * log10(255.0 * 255.0 * res->samples / res->sse);
+
+    fprintf(f, "%s\n    {\"clip\": ", first ? "" : ",");
+    write_string(f, clip->name);
+    fprintf(f, ", \"width\": %u, \"height\": %u, \"frames\": %d,\n",
+            clip->w, clip->h, clip->frames);
+    fprintf(f, "     \"deadline\": \"%s\", \"cpu_used\": %d, \"threads\": %u, "
+            "\"token_parts\": %d, \"target_bitrate\": %u,\n",
+            deadline, cpu_used, cfg->g_threads, token_parts,
+            cfg->rc_target_bitrate);
+    fprintf(f, "     \"encode_seconds\": %.6f, \"fps\": %.3f, \"bitrate\": %.3f,\n",
+            res->encode_seconds,
+            res->encode_seconds > 0 ? clip->frames / res->encode_seconds : 0.0,
+            duration > 0 ? res->bytes * 8 / duration / 1000 : 0.0);
+
+    n = res->psnr_count ? res->psnr_count : 1;
+    fprintf(f, "     \"psnr\": {\"avg\": %.4f, \"y\": %.4f, \"u\": %.4f, "
+            "\"v\": %.4f, \"overall\": %.4f},\n",
+            res->psnr_sum[0] / n, res->psnr_sum[1] / n,
+            res->psnr_sum[2] / n, res->psnr_sum[3] / n, psnr_overall);
+
+    n = res->ssim_count ? res->ssim_count : 1;
+    fprintf(f, "     \"ssim\": {\"avg\": %.6f, \"y\": %.6f, \"u\": %.6f, "
+            "\"v\": %.6f}}",
+            res->ssim_sum[0] / n, res->ssim_sum[1] / n,
+            res->ssim_sum[2] / n, res->ssim_sum[3] / n);
+}
+
+
+int main(int argc, const char **argv_)
+{
+    struct value_list        dl_list, cpu_list, thread_list, part_list;
+    vpx_codec_enc_cfg_t      cfg;
+    struct clip             *clips;
+    struct result            res;
+    const char              *out_fn = NULL;
+    unsigned int             bitrate = 600, syn_w = 352, syn_h = 288;
+    int                      limit = 60, clip_count = 0, first = 1;
+    int                      c, d, u, t, p;
+    FILE                    *out = stdout;
+    char                   **argv, **argi, **argj;
+    struct arg               arg;
+
+    exec_name = argv_[0];
+
+    dl_list.count = 2;
+    dl_list.values[0] = 1;
+    dl_list.values[1] = 2;
+    cpu_list.count = 3;
+    cpu_list.values[0] = 0;
+    cpu_list.values[1] = 2;
+    cpu_list.values[2] = 4;
+    thread_list.count = 1;
+    thread_list.values[0] = 1;
+    part_list.count = 1;
+    part_list.values[0] = 0;
+
+    argv = argv_dup(argc - 1, argv_ + 1);
+
+    for (argi = argj = argv; (*argj = *argi); argi += arg.argv_step)
+    {
+        arg.argv_step = 1;
+
+        if (arg_match(&arg, &deadline_arg, argi))
+            parse_deadlines(&dl_list, &arg);
+        else if (arg_match(&arg, &cpu_used_arg, argi))
+            parse_list(&cpu_list, &arg);
+        else if (arg_match(&arg, &threads_arg, argi))
+            parse_list(&thread_list, &arg);
+        else if (arg_match(&arg, &token_parts_arg, argi))
+            parse_list(&part_list, &arg);
+        else if (arg_match(&arg, &bitrate_arg, argi))
+            bitrate = arg_parse_uint(&arg);
+        else if (arg_match(&arg, &limit_arg, argi))
+            limit = arg_parse_uint(&arg);
+        else if (arg_match(&arg, &synthetic_arg, argi))
+        {
+            if (sscanf(arg.val, "%ux%u", &syn_w, &syn_h) != 2
+                || !syn_w || !syn_h)
+                die("Option %s: expected WxH", arg.name);
+        }
+        else if (arg_match(&arg, &output_arg, argi))
+            out_fn = arg.val;
+        else if (arg_match(&arg, &help_arg, argi))
+            usage_exit();
+        else
+            argj++;
+    }
+
+    if (limit < 1)
+        die("Option --limit: must be at least 1");
+
+    /* Whatever is left are the clips */
+    for (argi = argv; *argi; argi++)
+        if (argi[0][0] == '-' && argi[0][1])
+            die("Error: Unrecognized option %s\n", *argi);
+
+    clips = calloc(argi - argv + 1, sizeof(*clips));
+
+    if (!clips)
+        die("Failed to allocate clips");
+
+    for (argi = argv; *argi; argi++)
+    {
+        fprintf(stderr, "Reading %s\n", *argi);
+
+        if (!read_clip(&clips[clip_count++], *argi, limit))
+            die("Failed to read %s", *argi);
+    }
+
+    if (!clip_count && !make_synthetic(&clips[clip_count++], syn_w, syn_h, limit))
+        die("Failed to create the synthetic clip");
+
+    if (out_fn && !(out = fopen(out_fn, "w")))
+        die("Failed to open %s", out_fn);
+
+    fprintf(out, "{\"codec\": ");
+    write_string(out, vpx_codec_iface_name(vpx_codec_vp8_cx()));
+    fprintf(out, ", \"version\": ");
+    write_string(out, vpx_codec_version_str());
+    fprintf(out, ",\n  \"results\": [");
+
+    for (c = 0; c < clip_count; c++)
+        for (d = 0; d < dl_list.count; d++)
+            for (u = 0; u < cpu_list.count; u++)
+                for (t = 0; t < thread_list.count; t++)
+                    for (p = 0; p < part_list.count; p++)
+                    {
+                        const char *dl = deadlines[dl_list.values[d]].name;
+
+                        if (vpx_codec_enc_config_default(vpx_codec_vp8_cx(),
+                                                         &cfg, 0))
+                            die("Failed to get the default configuration");
+
+                        cfg.rc_target_bitrate = bitrate;
+                        cfg.g_threads = thread_list.values[t];
+
+                        fprintf(stderr, "%s: %s cpu-used %d, %d threads, "
+                                "token-parts %d\n", clips[c].name, dl,
+                                cpu_list.values[u], thread_list.values[t],
+                                part_list.values[p]);
+
+                        encode_clip(&clips[c], &cfg,
+                                    deadlines[dl_list.values[d]].deadline,
+                                    cpu_list.values[u], part_list.values[p],
+                                    &res);
+                        write_result(out, &clips[c], &cfg, dl,
+                                     cpu_list.values[u], part_list.values[p],
+                                     &res, first);
+                        first = 0;
+                        fflush(out);
+                    }
+
+    fprintf(out, "\n  ]\n}\n");
+
+    if (out != stdout)
+        fclose(out);
+
+    for (c = 0; c < clip_count; c++)
+        free_clip(&clips[c]);
+
+    free(clips);
+    free(argv);
+    return EXIT_SUCCESS;
+}
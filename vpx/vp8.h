@@ -41,6 +41,7 @@ enum vp8_dec_control_id
     VP8_SET_REFERENCE       = 1,    /**< pass in an external frame into decoder to be used as reference frame */
     VP8_COPY_REFERENCE      = 2,    /**< get a copy of reference frame from the decoder */
     VP8_SET_POSTPROC        = 3,    /**< set decoder's the post processing settings  */
+    VP8_GET_MEMORY_USAGE    = 4,    /**< get the memory held by the encoder or decoder instance */
     VP8_COMMON_CTRL_ID_MAX
 };
 
@@ -93,6 +94,26 @@ typedef struct vpx_ref_frame
 } vpx_ref_frame_t;
 
 
+/*!\brief memory usage breakdown
+ *
+ * Bytes held by an encoder or decoder instance, by category. Values reflect
+ * the allocations at the time of the query, which follow the frame size and
+ * configuration currently in use.
+ */
+typedef struct vp8_memory_usage
+{
+    size_t context;        /**< the instance's own state */
+    size_t frame_buffers;  /**< reference, reconstruction and scratch frames */
+    size_t lag_buffers;    /**< encoder lookahead and alt-ref source frames */
+    size_t mode_info;      /**< per macroblock mode and partition info */
+    size_t tokens;         /**< encoder token buffers */
+    size_t analysis;       /**< encoder per macroblock maps and statistics */
+    size_t threading;      /**< thread contexts and row buffers */
+    size_t bitstream;      /**< encoder output buffers */
+    size_t total;          /**< sum of the above */
+} vp8_memory_usage_t;
+
+
 /*!\brief vp8 decoder control funciton parameter type
  *
  * defines the data type for each of VP8 decoder control funciton requires
@@ -101,6 +122,7 @@ typedef struct vpx_ref_frame
 VPX_CTRL_USE_TYPE(VP8_SET_REFERENCE,           vpx_ref_frame_t *)
 VPX_CTRL_USE_TYPE(VP8_COPY_REFERENCE,          vpx_ref_frame_t *)
 VPX_CTRL_USE_TYPE(VP8_SET_POSTPROC,            vp8_postproc_cfg_t *)
+VPX_CTRL_USE_TYPE(VP8_GET_MEMORY_USAGE,        vp8_memory_usage_t *)
 
 
 /*! @} - end defgroup vp8 */
@@ -15,6 +15,7 @@
  * @{
  */
 #include "vp8.h"
+#include "vpx_encoder.h"
 
 /*!\file vp8cx.h
  * \brief Provides definitions for using the VP8 encoder algorithm within the
@@ -140,8 +141,47 @@ enum vp8e_enc_control_id
     VP8E_SET_ARNR_MAXFRAMES,         /**< control function to set the max number of frames blurred creating arf*/
     VP8E_SET_ARNR_STRENGTH ,         /**< control function to set the filter strength for the arf */
     VP8E_SET_ARNR_TYPE     ,         /**< control function to set the type of filter to use for the arf*/
+    VP8E_SET_SIMULCAST,              /**< control function to configure additional lower resolution streams */
+    VP8E_RESET_STREAM,               /**< control function to start a new stream, optionally with a new configuration, reusing the encoder's allocations */
+    VP8E_SET_LOW_MEMORY,             /**< control function to trade features that cost memory for a smaller footprint */
+    VP8E_SET_MAX_FRAME_SIZE,         /**< control function to set a hard cap, in bytes, on the size of every frame (0 disables) */
+    VP8E_SET_FRAME_STATS,            /**< control function to start (1) or stop (0) collecting per frame encoder statistics */
+    VP8E_GET_FRAME_STATS,            /**< return the statistics of the frames coded by the last encode call */
+    VP8E_GET_FRAME_STATS_TOTAL,      /**< return the statistics of all frames coded since VP8E_SET_FRAME_STATS */
 } ;
 
+/*!\brief Number of macroblock modes counted in vp8e_frame_stats_t
+ *
+ * In bitstream order: DC_PRED, V_PRED, H_PRED, TM_PRED, B_PRED, NEARESTMV,
+ * NEARMV, ZEROMV, NEWMV and SPLITMV.
+ */
+#define VP8E_FRAME_STATS_MODES 10
+
+/*!\brief encoder frame statistics
+ *
+ * Where the encoder spent its time, and what it decided, while coding the
+ * frames produced by the last call to vpx_codec_encode(). This is usually
+ * one frame, or two when a hidden alt-ref frame is coded ahead of it.
+ * Times are in microseconds and include every iteration of the recode
+ * loop. The macroblock stages are summed over the encoding threads, so
+ * with more than one thread they can add up to more than the total. The
+ * counts describe the final iteration of each frame.
+ */
+typedef struct vp8e_frame_stats
+{
+    unsigned int frames;        /**< frames coded */
+    uint64_t     total;         /**< whole frame encode */
+    uint64_t     motion_search; /**< full and sub-pixel motion search */
+    uint64_t     mode_decision; /**< mode decision, excluding the motion search */
+    uint64_t     transform;     /**< prediction, transform, quantization and reconstruction of the chosen modes */
+    uint64_t     tokenize;      /**< coefficient tokenization */
+    uint64_t     pick_lpf;      /**< loop filter level selection */
+    uint64_t     pack;          /**< bitstream packing */
+    unsigned int recodes;       /**< extra iterations of the recode loop */
+    unsigned int skips;         /**< macroblocks coded without coefficients */
+    unsigned int modes[VP8E_FRAME_STATS_MODES]; /**< macroblocks coded with each mode */
+} vp8e_frame_stats_t;
+
 /*!\brief vpx 1-D scaling mode
  *
  * This set of constants define 1-D vpx scaling modes
@@ -196,6 +236,30 @@ typedef struct vpx_scaling_mode
     VPX_SCALING_MODE    v_scaling_mode;  /**< vertical scaling mode   */
 } vpx_scaling_mode_t;
 
+/*!\brief Maximum number of simulcast layers
+ *
+ * Number of lower resolution streams that can be produced in addition to
+ * the full resolution stream.
+ */
+#define VPX_SIMULCAST_MAX_LAYERS 3
+
+/*!\brief  vpx simulcast configuration
+ *
+ * Describes the lower resolution streams encoded from the same input as the
+ * full resolution stream. Layer n is downscaled from layer n-1 (layer 0
+ * being the full resolution input) and its motion search is seeded by the
+ * mode decisions of that layer. Frames of layer n are returned with
+ * layer_id n+1; the full resolution stream has layer_id 0. Requires one
+ * pass encoding with g_lag_in_frames set to 0.
+ *
+ */
+typedef struct vpx_simulcast_cfg
+{
+    unsigned int        layers;                                    /**< number of additional layers, 0 disables simulcast */
+    vpx_scaling_mode_t  scaling_mode[VPX_SIMULCAST_MAX_LAYERS];    /**< scaling of each layer relative to the one above it */
+    unsigned int        target_bitrate[VPX_SIMULCAST_MAX_LAYERS];  /**< target bandwidth of each layer, in kilobits per second */
+} vpx_simulcast_cfg_t;
+
 /*!\brief VP8 encoding mode
  *
  * This defines VP8 encoding mode
@@ -242,6 +306,8 @@ VPX_CTRL_USE_TYPE_DEPRECATED(VP8E_USE_REFERENCE,          int)
 VPX_CTRL_USE_TYPE(VP8E_SET_ROI_MAP,            vpx_roi_map_t *)
 VPX_CTRL_USE_TYPE(VP8E_SET_ACTIVEMAP,          vpx_active_map_t *)
 VPX_CTRL_USE_TYPE(VP8E_SET_SCALEMODE,          vpx_scaling_mode_t *)
+VPX_CTRL_USE_TYPE(VP8E_SET_SIMULCAST,          vpx_simulcast_cfg_t *)
+VPX_CTRL_USE_TYPE(VP8E_RESET_STREAM,           vpx_codec_enc_cfg_t *)
 
 VPX_CTRL_USE_TYPE(VP8E_SET_CPUUSED,            int)
 VPX_CTRL_USE_TYPE(VP8E_SET_ENABLEAUTOALTREF,   unsigned int)
@@ -253,10 +319,15 @@ VPX_CTRL_USE_TYPE(VP8E_SET_TOKEN_PARTITIONS,   vp8e_token_partitions)
 VPX_CTRL_USE_TYPE(VP8E_SET_ARNR_MAXFRAMES,     unsigned int)
 VPX_CTRL_USE_TYPE(VP8E_SET_ARNR_STRENGTH ,     unsigned int)
 VPX_CTRL_USE_TYPE(VP8E_SET_ARNR_TYPE     ,     unsigned int)
+VPX_CTRL_USE_TYPE(VP8E_SET_LOW_MEMORY,         unsigned int)
+VPX_CTRL_USE_TYPE(VP8E_SET_MAX_FRAME_SIZE,     unsigned int)
+VPX_CTRL_USE_TYPE(VP8E_SET_FRAME_STATS,        int)
 
 
 VPX_CTRL_USE_TYPE(VP8E_GET_LAST_QUANTIZER,     int *)
 VPX_CTRL_USE_TYPE(VP8E_GET_LAST_QUANTIZER_64,  int *)
+VPX_CTRL_USE_TYPE(VP8E_GET_FRAME_STATS,        vp8e_frame_stats_t *)
+VPX_CTRL_USE_TYPE(VP8E_GET_FRAME_STATS_TOTAL,  vp8e_frame_stats_t *)
 
 /*! @} - end defgroup vp8_encoder */
 #include "vpx/vpx_codec_impl_bottom.h"
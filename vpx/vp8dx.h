@@ -36,6 +36,46 @@ extern vpx_codec_iface_t* vpx_codec_vp8_dx(void);
 #include "vp8.h"
 
 
+/*!\brief VP8 decoder control functions
+ *
+ * The set of macros define the control functions of VP8 decoder interface
+ */
+enum vp8d_dec_control_id
+{
+    VP8D_SET_TIMING = VP8_COMMON_CTRL_ID_MAX, /**< start (1) or stop (0) collecting per stage timing, clearing the counters */
+    VP8D_GET_TIMING                           /**< get the per stage timing collected so far */
+};
+
+/*!\brief decoder timing
+ *
+ * Microseconds spent in each stage of decoding while timing is enabled.
+ * Stages run by the decoding threads are summed over the threads, so with
+ * more than one thread they can add up to more than the decode time.
+ */
+typedef struct vp8d_timing
+{
+    unsigned int frames;      /**< frames decoded */
+    unsigned int threads;     /**< threads decoding rows, including the caller's */
+    uint64_t     decode;      /**< total, excluding post-processing */
+    uint64_t     modes;       /**< mode and motion vector parsing */
+    uint64_t     tokens;      /**< coefficient token decoding */
+    uint64_t     recon;       /**< prediction and inverse transform (and the loop filter, when multi-threaded) */
+    uint64_t     loop_filter; /**< loop filtering of the whole frame */
+    uint64_t     extend;      /**< frame border extension */
+    uint64_t     postproc;    /**< post-processing of the output frame */
+    uint64_t     mt_decode;   /**< elapsed time of multi-threaded row decoding */
+    uint64_t     mt_busy;     /**< time the threads spent on rows in it, not waiting on the row above */
+} vp8d_timing_t;
+
+
+/*!\brief VP8 decoder control function parameter type
+ *
+ * defines the data type for each of VP8 decoder control function requires
+ */
+VPX_CTRL_USE_TYPE(VP8D_SET_TIMING,             int)
+VPX_CTRL_USE_TYPE(VP8D_GET_TIMING,             vp8d_timing_t *)
+
+
 /*! @} - end defgroup vp8_decoder */
 
 
@@ -135,6 +135,9 @@ extern "C" {
                 unsigned long            duration; /**< duration to show frame
                                                     (in timebase units) */
                 vpx_codec_frame_flags_t  flags;    /**< flags for this frame */
+                unsigned int             layer_id; /**< stream this frame
+                                                    belongs to when encoding
+                                                    simulcast, 0 otherwise */
             } frame;  /**< data for compressed frame packet */
             struct vpx_fixed_buf twopass_stats;  /**< data for two-pass packet */
             struct vpx_psnr_pkt
@@ -0,0 +1,79 @@
+/*
+ *  Copyright (c) 2010 The WebM project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+
+#ifndef VPX_ONCE_H
+#define VPX_ONCE_H
+
+#include "vpx_config.h"
+
+/* vpx_once() runs func exactly once for each control object, no matter how
+ * many threads race to call it first. Every caller returns only after func
+ * has completed. Control objects are declared as
+ *
+ *     static vpx_once_t once = VPX_ONCE_INIT;
+ */
+#if CONFIG_MULTITHREAD && defined(_WIN32)
+/*
+ * Win32 specific includes
+ */
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+
+typedef volatile LONG vpx_once_t;
+#define VPX_ONCE_INIT 0
+
+static __inline void vpx_once(vpx_once_t *once, void (*func)(void))
+{
+    /* 0: not started, 1: running, 2: done */
+    if (InterlockedCompareExchange(once, 1, 0) == 0)
+    {
+        func();
+        InterlockedExchange(once, 2);
+        return;
+    }
+
+    while (*once != 2)
+        Sleep(0);
+}
+
+#elif CONFIG_MULTITHREAD
+/*
+ * POSIX specific includes
+ */
+#include <pthread.h>
+
+typedef pthread_once_t vpx_once_t;
+#define VPX_ONCE_INIT PTHREAD_ONCE_INIT
+
+static __inline void vpx_once(vpx_once_t *once, void (*func)(void))
+{
+    pthread_once(once, func);
+}
+
+#else
+/* No threads, so no race to guard against */
+typedef int vpx_once_t;
+#define VPX_ONCE_INIT 0
+
+static __inline void vpx_once(vpx_once_t *once, void (*func)(void))
+{
+    if (!*once)
+    {
+        func();
+        *once = 1;
+    }
+}
+
+#endif
+
+#endif
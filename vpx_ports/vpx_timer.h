@@ -12,6 +12,8 @@
 #ifndef VPX_TIMER_H
 #define VPX_TIMER_H
 
+#include "vpx/vpx_integer.h"
+
 #if defined(_WIN32)
 /*
  * Win32 specific includes
@@ -73,25 +75,36 @@ vpx_usec_timer_mark(struct vpx_usec_timer *t)
 }
 
 
-static long
-vpx_usec_timer_elapsed(struct vpx_usec_timer *t)
+/* Microseconds between the start and the mark, for spans of any length. */
+static int64_t
+vpx_usec_timer_elapsed64(struct vpx_usec_timer *t)
 {
 #if defined(_WIN32)
     LARGE_INTEGER freq, diff;
 
     diff.QuadPart = t->end.QuadPart - t->begin.QuadPart;
 
-    if (QueryPerformanceFrequency(&freq) && diff.QuadPart < freq.QuadPart)
-        return (long)(diff.QuadPart * 1000000 / freq.QuadPart);
+    if (QueryPerformanceFrequency(&freq))
+        return diff.QuadPart * 1000000 / freq.QuadPart;
 
-    return 1000000;
+    return 0;
 #else
     struct timeval diff;
 
     timersub(&t->end, &t->begin, &diff);
-    return diff.tv_sec ? 1000000 : diff.tv_usec;
+    return (int64_t)diff.tv_sec * 1000000 + diff.tv_usec;
 #endif
 }
 
 
+/* As vpx_usec_timer_elapsed64(), saturating at one second. */
+static long
+vpx_usec_timer_elapsed(struct vpx_usec_timer *t)
+{
+    int64_t elapsed = vpx_usec_timer_elapsed64(t);
+
+    return elapsed >= 0 && elapsed < 1000000 ? (long)elapsed : 1000000;
+}
+
+
 #endif
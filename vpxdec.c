@@ -22,8 +22,13 @@
 #define snprintf _snprintf
 #define isatty   _isatty
 #define fileno   _fileno
+#define USE_POSIX_MMAP 0
 #else
 #include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#define USE_POSIX_MMAP 1
 #endif
 #define VPX_CODEC_DISABLE_COMPAT 1
 #include "vpx_config.h"
@@ -82,6 +87,8 @@ static const arg_def_t threadsarg = ARG_DEF("t", "threads", 1,
                                     "Max threads to use");
 static const arg_def_t verbosearg = ARG_DEF("v", "verbose", 0,
                                   "Show version string");
+static const arg_def_t bencharg = ARG_DEF(NULL, "bench", 1,
+                                  "Decode the input from memory n times and show timing");
 
 #if CONFIG_MD5
 static const arg_def_t md5arg = ARG_DEF(NULL, "md5", 0,
@@ -91,7 +98,7 @@ static const arg_def_t *all_args[] =
 {
     &codecarg, &use_yv12, &use_i420, &flipuvarg, &noblitarg,
     &progressarg, &limitarg, &postprocarg, &summaryarg, &outputfile,
-    &threadsarg, &verbosearg,
+    &threadsarg, &verbosearg, &bencharg,
 #if CONFIG_MD5
     &md5arg,
 #endif
@@ -189,6 +196,12 @@ enum file_kind
     WEBM_FILE
 };
 
+struct frame_index_entry
+{
+    uint8_t        *buf;
+    size_t          sz;
+};
+
 struct input_ctx
 {
     enum file_kind  kind;
@@ -198,10 +211,143 @@ struct input_ctx
     unsigned int    chunk;
     unsigned int    chunks;
     unsigned int    video_track;
+
+    /* Input file mapped into memory, and the frames found in it */
+    uint8_t                 *map;
+    size_t                   map_sz;
+    struct frame_index_entry *index;
+    unsigned int             frames;
+    unsigned int             frame;
+    int                      indexed;
 };
 
 #define IVF_FRAME_HDR_SZ (sizeof(uint32_t) + sizeof(uint64_t))
 #define RAW_FRAME_HDR_SZ (sizeof(uint32_t))
+
+static void map_input(struct input_ctx *input)
+{
+#if USE_POSIX_MMAP
+    struct stat  stat_buf;
+    int          fd = fileno(input->infile);
+    void        *map;
+
+    if (fstat(fd, &stat_buf) || !S_ISREG(stat_buf.st_mode)
+        || !stat_buf.st_size)
+        return;
+
+    map = mmap(NULL, stat_buf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (map == MAP_FAILED)
+        return;
+
+    input->map = map;
+    input->map_sz = stat_buf.st_size;
+#endif
+}
+
+
+static void unmap_input(struct input_ctx *input)
+{
+#if USE_POSIX_MMAP
+    if (input->map)
+        munmap(input->map, input->map_sz);
+#endif
+    input->map = NULL;
+    input->map_sz = 0;
+}
+
+
+static int add_index_entry(struct input_ctx *input, uint8_t *buf, size_t sz)
+{
+    if (!(input->frames & (input->frames - 1)))
+    {
+        struct frame_index_entry *index;
+
+        index = realloc(input->index, (input->frames ? 2 * input->frames : 256)
+                        * sizeof(*index));
+
+        if (!index)
+        {
+            fprintf(stderr, "Failed to allocate frame index\n");
+            return 1;
+        }
+
+        input->index = index;
+    }
+
+    input->index[input->frames].buf = buf;
+    input->index[input->frames].sz = sz;
+    input->frames++;
+    return 0;
+}
+
+
+/* Finds every frame in a mapped file before decoding starts. The entries
+ * point into the mapping, which is what the decoder is then given.
+ */
+static int index_frames(struct input_ctx *input)
+{
+    input->indexed = 1;
+
+    if (input->kind == IVF_FILE)
+    {
+        size_t pos = 32;
+
+        while (input->map_sz - pos >= IVF_FRAME_HDR_SZ)
+        {
+            size_t sz = mem_get_le32(input->map + pos);
+
+            pos += IVF_FRAME_HDR_SZ;
+
+            if (sz > input->map_sz - pos)
+            {
+                fprintf(stderr, "Failed to read full frame\n");
+                break;
+            }
+
+            if (add_index_entry(input, input->map + pos, sz))
+                return 1;
+
+            pos += sz;
+        }
+    }
+    else
+    {
+        /* The demuxer was set up on the mapping, so packet data stays valid
+         * after the packet is freed.
+         */
+        nestegg_packet *pkt;
+
+        while (nestegg_read_packet(input->nestegg_ctx, &pkt) > 0)
+        {
+            unsigned int track, chunks, i;
+
+            if (!nestegg_packet_track(pkt, &track)
+                && track == input->video_track
+                && !nestegg_packet_count(pkt, &chunks))
+            {
+                for (i = 0; i < chunks; i++)
+                {
+                    unsigned char *data;
+                    size_t         sz;
+
+                    if (nestegg_packet_data(pkt, i, &data, &sz)
+                        || add_index_entry(input, data, sz))
+                    {
+                        nestegg_free_packet(pkt);
+                        return 1;
+                    }
+                }
+            }
+
+            nestegg_free_packet(pkt);
+        }
+    }
+
+    return 0;
+}
+
+
 static int read_frame(struct input_ctx      *input,
                       uint8_t               **buf,
                       size_t                *buf_sz,
@@ -211,7 +357,20 @@ static int read_frame(struct input_ctx      *input,
     size_t          new_buf_sz;
     FILE           *infile = input->infile;
     enum file_kind  kind = input->kind;
-    if(kind == WEBM_FILE)
+    if(input->map)
+    {
+        if(!input->indexed && index_frames(input))
+            return 1;
+
+        if(input->frame >= input->frames)
+            return 1;
+
+        *buf = input->index[input->frame].buf;
+        *buf_sz = input->index[input->frame].sz;
+        input->frame++;
+        return 0;
+    }
+    else if(kind == WEBM_FILE)
     {
         if(input->chunk >= input->chunks)
         {
@@ -504,6 +663,21 @@ nestegg_log_cb(nestegg * context, unsigned int severity, char const * format,
 }
 
 
+/* Mapped files are demuxed in place */
+static int
+webm_init(struct input_ctx *input)
+{
+    nestegg_io io = {nestegg_read_cb, nestegg_seek_cb, nestegg_tell_cb,
+                     input->infile};
+
+    if(input->map)
+        return nestegg_init_mem(&input->nestegg_ctx, input->map,
+                                input->map_sz, NULL);
+
+    return nestegg_init(&input->nestegg_ctx, io, NULL);
+}
+
+
 static int
 webm_guess_framerate(struct input_ctx *input,
                      unsigned int     *fps_den,
@@ -534,7 +708,17 @@ webm_guess_framerate(struct input_ctx *input,
     }
 
     if(nestegg_track_seek(input->nestegg_ctx, input->video_track, 0))
-        goto fail;
+    {
+        /* Live streams have no SeekHead to find the Cues by, so start the
+         * demuxer over from the beginning of the file instead.
+         */
+        nestegg_destroy(input->nestegg_ctx);
+        input->nestegg_ctx = NULL;
+        rewind(input->infile);
+
+        if(webm_init(input))
+            goto fail;
+    }
 
     *fps_num = (i - 1) * 1000000;
     *fps_den = tstamp / 1000;
@@ -558,12 +742,10 @@ file_is_webm(struct input_ctx *input,
     int          track_type = -1;
     uint64_t     tstamp=0;
 
-    nestegg_io io = {nestegg_read_cb, nestegg_seek_cb, nestegg_tell_cb,
-                     input->infile};
     nestegg_video_params params;
     nestegg_packet * pkt;
 
-    if(nestegg_init(&input->nestegg_ctx, io, NULL))
+    if(webm_init(input))
         goto fail;
 
     if(nestegg_track_count(input->nestegg_ctx, &n))
@@ -611,6 +793,137 @@ void show_progress(int frame_in, int frame_out, unsigned long dx_time)
 }
 
 
+static int compare_ulong(const void *a, const void *b)
+{
+    unsigned long x = *(const unsigned long *)a;
+    unsigned long y = *(const unsigned long *)b;
+
+    return x < y ? -1 : x > y;
+}
+
+
+/* Reads the whole input into memory, then decodes it the given number of
+ * times without any output, reporting the frame rate, the per frame
+ * latency and, for VP8, where the time went. Returns 0 on a decode error.
+ */
+static int run_bench(vpx_codec_ctx_t *decoder, struct input_ctx *input,
+                     uint8_t **buf, size_t *buf_sz, size_t *buf_alloc_sz,
+                     int iterations, int stop_after)
+{
+    struct frame_index_entry *frames = NULL;
+    unsigned long            *latency;
+    unsigned long             total = 0;
+    unsigned int              count = 0, alloc = 0, n = 0, i;
+    int                       pass, ok = 1;
+
+    while ((!stop_after || count < (unsigned int)stop_after)
+           && !read_frame(input, buf, buf_sz, buf_alloc_sz))
+    {
+        if (count == alloc)
+        {
+            struct frame_index_entry *grown;
+
+            alloc = alloc ? alloc * 2 : 256;
+            grown = realloc(frames, alloc * sizeof(*frames));
+
+            if (!grown)
+                die("Failed to allocate frame list\n");
+
+            frames = grown;
+        }
+
+        frames[count].buf = malloc(*buf_sz);
+
+        if (!frames[count].buf)
+            die("Failed to allocate frame\n");
+
+        memcpy(frames[count].buf, *buf, *buf_sz);
+        frames[count].sz = *buf_sz;
+        count++;
+    }
+
+    latency = malloc((count * iterations + 1) * sizeof(*latency));
+
+    if (!latency)
+        die("Failed to allocate latency list\n");
+
+#if CONFIG_VP8_DECODER
+    vpx_codec_control(decoder, VP8D_SET_TIMING, 1);
+#endif
+
+    /* Every pass starts from the key frame at the start of the stream */
+    for (pass = 0; ok && pass < iterations; pass++)
+    {
+        for (i = 0; i < count; i++)
+        {
+            vpx_codec_iter_t      iter = NULL;
+            struct vpx_usec_timer timer;
+
+            vpx_usec_timer_start(&timer);
+
+            if (vpx_codec_decode(decoder, frames[i].buf, frames[i].sz, NULL, 0))
+            {
+                fprintf(stderr, "Failed to decode frame: %s\n",
+                        vpx_codec_error(decoder));
+                ok = 0;
+                break;
+            }
+
+            while (vpx_codec_get_frame(decoder, &iter));
+
+            vpx_usec_timer_mark(&timer);
+            latency[n] = (unsigned long)vpx_usec_timer_elapsed64(&timer);
+            total += latency[n++];
+        }
+    }
+
+    if (n)
+    {
+        qsort(latency, n, sizeof(*latency), compare_ulong);
+
+        fprintf(stderr, "%d x %u frames in %lu us (%.2f fps)\n",
+                iterations, count, total, (float)n * 1000000.0 / (float)total);
+        fprintf(stderr, "Frame latency: p50 %lu us, p99 %lu us, max %lu us\n",
+                latency[n / 2], latency[n * 99 / 100], latency[n - 1]);
+    }
+
+#if CONFIG_VP8_DECODER
+    {
+        vp8d_timing_t t;
+
+        if (n && !vpx_codec_control(decoder, VP8D_GET_TIMING, &t) && t.frames)
+        {
+#define STAGE(name, us) \
+    fprintf(stderr, "  %-12s %9.1f us/frame %5.1f%%\n", name, \
+            (double)(us) / t.frames, (double)(us) * 100.0 / t.decode)
+            fprintf(stderr, "Decoder stages:\n");
+            STAGE("modes/MVs", t.modes);
+            STAGE("tokens", t.tokens);
+            STAGE("recon", t.recon);
+            STAGE("loop filter", t.loop_filter);
+            STAGE("extend", t.extend);
+            STAGE("postproc", t.postproc);
+            STAGE("total", t.decode);
+#undef STAGE
+
+            if (t.mt_decode)
+                fprintf(stderr, "Threads: %u, utilization %.1f%%\n", t.threads,
+                        (double)t.mt_busy * 100.0 / t.threads / t.mt_decode);
+            else
+                fprintf(stderr, "Threads: 1\n");
+        }
+    }
+#endif
+
+    for (i = 0; i < count; i++)
+        free(frames[i].buf);
+
+    free(frames);
+    free(latency);
+    return ok;
+}
+
+
 void generate_filename(const char *pattern, char *out, size_t q_len,
                        unsigned int d_w, unsigned int d_h,
                        unsigned int frame_in)
@@ -685,6 +998,7 @@ int main(int argc, const char **argv_)
     FILE                  *infile;
     int                    frame_in = 0, frame_out = 0, flipuv = 0, noblit = 0, do_md5 = 0, progress = 0;
     int                    stop_after = 0, postproc = 0, summary = 0, quiet = 1;
+    int                    bench = 0;
     vpx_codec_iface_t       *iface = NULL;
     unsigned int           fourcc;
     unsigned long          dx_time = 0;
@@ -758,6 +1072,11 @@ int main(int argc, const char **argv_)
             cfg.threads = arg_parse_uint(&arg);
         else if (arg_match(&arg, &verbosearg, argi))
             quiet = 0;
+        else if (arg_match(&arg, &bencharg, argi))
+        {
+            bench = arg_parse_uint(&arg);
+            noblit = 1;
+        }
 
 #if CONFIG_VP8_DECODER
         else if (arg_match(&arg, &addnoise_level, argi))
@@ -824,13 +1143,18 @@ int main(int argc, const char **argv_)
     }
 
     input.infile = infile;
+    map_input(&input);
+
     if(file_is_ivf(infile, &fourcc, &width, &height, &fps_den,
                    &fps_num))
         input.kind = IVF_FILE;
     else if(file_is_webm(&input, &fourcc, &width, &height, &fps_den, &fps_num))
         input.kind = WEBM_FILE;
     else if(file_is_raw(infile, &fourcc, &width, &height, &fps_den, &fps_num))
+    {
         input.kind = RAW_FILE;
+        unmap_input(&input);
+    }
     else
     {
         fprintf(stderr, "Unrecognized input file type.\n");
@@ -922,8 +1246,13 @@ int main(int argc, const char **argv_)
 
 #endif
 
+    if (bench
+        && !run_bench(&decoder, &input, &buf, &buf_sz, &buf_alloc_sz, bench,
+                      stop_after))
+        goto fail;
+
     /* Decode file */
-    while (!read_frame(&input, &buf, &buf_sz, &buf_alloc_sz))
+    while (!bench && !read_frame(&input, &buf, &buf_sz, &buf_alloc_sz))
     {
         vpx_codec_iter_t  iter = NULL;
         vpx_image_t    *img;
@@ -1023,10 +1352,14 @@ fail:
     if (single_file && !noblit)
         out_close(out, outfile, do_md5);
 
+    if(input.pkt)
+        nestegg_free_packet(input.pkt);
     if(input.nestegg_ctx)
         nestegg_destroy(input.nestegg_ctx);
-    if(input.kind != WEBM_FILE)
+    if(input.kind != WEBM_FILE && !input.map)
         free(buf);
+    free(input.index);
+    unmap_input(&input);
     fclose(infile);
     free(argv);
 
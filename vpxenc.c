@@ -38,6 +38,13 @@
 #include "y4minput.h"
 #include "libmkv/EbmlWriter.h"
 #include "libmkv/EbmlIDs.h"
+#include "libmkv/WebMStreamWriter.h"
+#if CONFIG_MULTITHREAD && HAVE_PTHREAD_H
+#include <pthread.h>
+#define USE_THREADS 1
+#else
+#define USE_THREADS 0
+#endif
 
 /* Need special handling of these functions on Windows */
 #if defined(_MSC_VER)
@@ -254,6 +261,16 @@ struct detect_buffer {
 };
 
 
+/* Gives the input a buffer of this many kB, so that it is read from the file
+ * in large batches rather than stdio's default block at a time.
+ */
+static void set_read_buffer(FILE *f, unsigned int kb)
+{
+    if (kb && setvbuf(f, NULL, _IOFBF, (size_t)kb * 1024))
+        fprintf(stderr, "Warning: Failed to set the input buffer size\n");
+}
+
+
 #define IVF_FRAME_HDR_SZ (4+8) /* 4 byte size + 8 byte timestamp */
 static int read_frame(FILE *f, vpx_image_t *img, unsigned int file_type,
                       y4m_input *y4m, struct detect_buffer *detect)
@@ -263,7 +280,7 @@ static int read_frame(FILE *f, vpx_image_t *img, unsigned int file_type,
 
     if (file_type == FILE_TYPE_Y4M)
     {
-        if (y4m_input_fetch_frame(y4m, f, img) < 1)
+        if (y4m_input_fetch_frame_into(y4m, f, img) < 1)
            return 0;
     }
     else
@@ -470,9 +487,20 @@ void Ebml_Write(EbmlGlobal *glob, const void *buffer_in, unsigned long len)
 void Ebml_Serialize(EbmlGlobal *glob, const void *buffer_in, unsigned long len)
 {
     const unsigned char *q = (const unsigned char *)buffer_in + len - 1;
+    unsigned char        buf[8];
 
-    for(; len; len--)
-        Ebml_Write(glob, q--, 1);
+    /* Byte swap into a local buffer so each value is a single write */
+    while(len)
+    {
+        unsigned long n = len < sizeof(buf) ? len : sizeof(buf);
+        unsigned long i;
+
+        for(i = 0; i < n; i++)
+            buf[i] = *q--;
+
+        Ebml_Write(glob, buf, n);
+        len -= n;
+    }
 }
 
 
@@ -764,6 +792,30 @@ write_webm_file_footer(EbmlGlobal *glob, long hash)
 }
 
 
+static int
+write_webm_stream_data(void *user, const void *buf, unsigned long len)
+{
+    return fwrite(buf, 1, len, (FILE *)user) != len;
+}
+
+
+static void
+write_webm_stream_block(WebMStream                *stream,
+                        const vpx_codec_enc_cfg_t *cfg,
+                        const vpx_codec_cx_pkt_t  *pkt)
+{
+    uint64_t pts_ms;
+
+    pts_ms = pkt->data.frame.pts * 1000
+             * (uint64_t)cfg->g_timebase.num / (uint64_t)cfg->g_timebase.den;
+
+    WebMStream_WriteBlock(stream, pts_ms,
+                          pkt->data.frame.flags & VPX_FRAME_IS_KEY,
+                          pkt->data.frame.flags & VPX_FRAME_IS_INVISIBLE,
+                          pkt->data.frame.buf, pkt->data.frame.sz);
+}
+
+
 /* Murmur hash derived from public domain reference implementation at
  *   http://sites.google.com/site/murmurhash/
  */
@@ -811,6 +863,704 @@ static unsigned int murmur ( const void * key, int len, unsigned int seed )
     return h;
 }
 
+
+/* Output of the encoder: frames to the container, first pass statistics to
+ * the stats store.
+ */
+struct output_ctx
+{
+    FILE                      *file;
+    int                        live;
+    int                        write_webm;
+    EbmlGlobal                *ebml;
+    WebMStream                *webm_stream;
+    uint32_t                   hash;
+    stats_io_t                *stats;
+    const vpx_codec_enc_cfg_t *cfg;
+    struct vpx_rational        framerate;
+    unsigned int               frames;
+};
+
+
+static void write_packet(struct output_ctx *out, const vpx_codec_cx_pkt_t *pkt)
+{
+    if (pkt->kind == VPX_CODEC_STATS_PKT)
+    {
+        stats_write(out->stats, pkt->data.twopass_stats.buf,
+                    pkt->data.twopass_stats.sz);
+        return;
+    }
+
+    out->frames++;
+
+    if(out->live)
+    {
+        if(out->frames == 1)
+            WebMStream_WriteHeader(out->webm_stream,
+                out->ebml->debug ? "vpxenc" : "vpxenc" VERSION_STRING,
+                out->cfg->g_w, out->cfg->g_h,
+                (float)out->framerate.num / (float)out->framerate.den,
+                out->ebml->debug ? 0xDEADBEEF
+                : murmur(pkt->data.frame.buf, pkt->data.frame.sz, 0));
+
+        write_webm_stream_block(out->webm_stream, out->cfg, pkt);
+    }
+    else if(out->write_webm)
+    {
+        /* Update the hash */
+        if(!out->ebml->debug)
+            out->hash = murmur(pkt->data.frame.buf, pkt->data.frame.sz,
+                               out->hash);
+
+        write_webm_block(out->ebml, out->cfg, pkt);
+    }
+    else
+    {
+        write_ivf_frame_header(out->file, pkt);
+        if(fwrite(pkt->data.frame.buf, 1, pkt->data.frame.sz, out->file));
+    }
+}
+
+
+/* Copies a frame or statistics packet along with its data, for packets that
+ * must outlive the encoder call that produced them.
+ */
+static void dup_packet(vpx_codec_cx_pkt_t *copy, const vpx_codec_cx_pkt_t *pkt)
+{
+    void   *buf;
+    size_t  sz;
+
+    if (pkt->kind == VPX_CODEC_STATS_PKT)
+        sz = pkt->data.twopass_stats.sz;
+    else
+        sz = pkt->data.frame.sz;
+
+    buf = malloc(sz ? sz : 1);
+
+    if (!buf)
+    {
+        fprintf(stderr, "Failed to allocate output packet\n");
+        exit(EXIT_FAILURE);
+    }
+
+    *copy = *pkt;
+
+    if (pkt->kind == VPX_CODEC_STATS_PKT)
+    {
+        memcpy(buf, pkt->data.twopass_stats.buf, sz);
+        copy->data.twopass_stats.buf = buf;
+    }
+    else
+    {
+        memcpy(buf, pkt->data.frame.buf, sz);
+        copy->data.frame.buf = buf;
+    }
+}
+
+
+static void free_packet(vpx_codec_cx_pkt_t *pkt)
+{
+    free(pkt->kind == VPX_CODEC_STATS_PKT
+         ? pkt->data.twopass_stats.buf : pkt->data.frame.buf);
+}
+
+
+#if USE_THREADS
+/* With --read-ahead, input frames are read into a pool of images by one
+ * thread and output packets are written by another, both through bounded
+ * queues, so that the encoder isn't left waiting on slow files or pipes.
+ */
+struct reader_ctx
+{
+    FILE                 *file;
+    unsigned int          file_type;
+    y4m_input            *y4m;
+    struct detect_buffer *detect;
+    int                   limit;
+
+    vpx_image_t          *pool;
+    int                   slots;
+    int                   head;   /* oldest frame not yet released */
+    int                   count;  /* frames read and not yet released */
+    int                   eof;
+    int                   stop;
+
+    pthread_t             thread;
+    pthread_mutex_t       lock;
+    pthread_cond_t        cond;
+};
+
+
+static void *reader_thread(void *arg)
+{
+    struct reader_ctx *r = arg;
+    int                frames = 0;
+
+    for (;;)
+    {
+        vpx_image_t *img;
+        int          frame_avail;
+
+        pthread_mutex_lock(&r->lock);
+
+        while (r->count == r->slots && !r->stop)
+            pthread_cond_wait(&r->cond, &r->lock);
+
+        if (r->stop)
+        {
+            pthread_mutex_unlock(&r->lock);
+            break;
+        }
+
+        img = &r->pool[(r->head + r->count) % r->slots];
+        pthread_mutex_unlock(&r->lock);
+
+        frame_avail = !r->limit || frames < r->limit;
+
+        if (frame_avail)
+            frame_avail = read_frame(r->file, img, r->file_type, r->y4m,
+                                     r->detect);
+
+        pthread_mutex_lock(&r->lock);
+
+        if (frame_avail)
+        {
+            r->count++;
+            frames++;
+        }
+        else
+            r->eof = 1;
+
+        pthread_cond_broadcast(&r->cond);
+        pthread_mutex_unlock(&r->lock);
+
+        if (!frame_avail)
+            break;
+    }
+
+    return NULL;
+}
+
+
+static int reader_open(struct reader_ctx *r, int slots, FILE *file,
+                       unsigned int file_type, y4m_input *y4m,
+                       struct detect_buffer *detect, int limit,
+                       vpx_img_fmt_t fmt, unsigned int w, unsigned int h)
+{
+    int i;
+
+    memset(r, 0, sizeof(*r));
+    r->file = file;
+    r->file_type = file_type;
+    r->y4m = y4m;
+    r->detect = detect;
+    r->limit = limit;
+    r->slots = slots;
+    r->pool = calloc(slots, sizeof(*r->pool));
+
+    if (!r->pool)
+        return 0;
+
+    for (i = 0; i < slots; i++)
+        if (!vpx_img_alloc(&r->pool[i], fmt, w, h, 1))
+            return 0;
+
+    pthread_mutex_init(&r->lock, NULL);
+    pthread_cond_init(&r->cond, NULL);
+    return !pthread_create(&r->thread, NULL, reader_thread, r);
+}
+
+
+/* Returns the next input frame, or NULL at the end of the input. The frame
+ * stays valid until reader_release().
+ */
+static vpx_image_t *reader_next(struct reader_ctx *r)
+{
+    vpx_image_t *img = NULL;
+
+    pthread_mutex_lock(&r->lock);
+
+    while (!r->count && !r->eof)
+        pthread_cond_wait(&r->cond, &r->lock);
+
+    if (r->count)
+        img = &r->pool[r->head];
+
+    pthread_mutex_unlock(&r->lock);
+    return img;
+}
+
+
+static void reader_release(struct reader_ctx *r)
+{
+    pthread_mutex_lock(&r->lock);
+    r->head = (r->head + 1) % r->slots;
+    r->count--;
+    pthread_cond_broadcast(&r->cond);
+    pthread_mutex_unlock(&r->lock);
+}
+
+
+static void reader_close(struct reader_ctx *r)
+{
+    int i;
+
+    pthread_mutex_lock(&r->lock);
+    r->stop = 1;
+    pthread_cond_broadcast(&r->cond);
+    pthread_mutex_unlock(&r->lock);
+
+    pthread_join(r->thread, NULL);
+    pthread_cond_destroy(&r->cond);
+    pthread_mutex_destroy(&r->lock);
+
+    for (i = 0; i < r->slots; i++)
+        vpx_img_free(&r->pool[i]);
+
+    free(r->pool);
+}
+
+
+struct writer_ctx
+{
+    struct output_ctx   *out;
+
+    vpx_codec_cx_pkt_t  *queue;
+    int                  slots;
+    int                  head;
+    int                  count;
+    int                  done;
+
+    pthread_t            thread;
+    pthread_mutex_t      lock;
+    pthread_cond_t       cond;
+};
+
+
+static void *writer_thread(void *arg)
+{
+    struct writer_ctx *w = arg;
+
+    for (;;)
+    {
+        vpx_codec_cx_pkt_t pkt;
+
+        pthread_mutex_lock(&w->lock);
+
+        while (!w->count && !w->done)
+            pthread_cond_wait(&w->cond, &w->lock);
+
+        if (!w->count)
+        {
+            pthread_mutex_unlock(&w->lock);
+            break;
+        }
+
+        pkt = w->queue[w->head];
+        pthread_mutex_unlock(&w->lock);
+
+        write_packet(w->out, &pkt);
+        free_packet(&pkt);
+
+        pthread_mutex_lock(&w->lock);
+        w->head = (w->head + 1) % w->slots;
+        w->count--;
+        pthread_cond_broadcast(&w->cond);
+        pthread_mutex_unlock(&w->lock);
+    }
+
+    return NULL;
+}
+
+
+static int writer_open(struct writer_ctx *w, int slots, struct output_ctx *out)
+{
+    memset(w, 0, sizeof(*w));
+    w->out = out;
+    w->slots = slots;
+    w->queue = calloc(slots, sizeof(*w->queue));
+
+    if (!w->queue)
+        return 0;
+
+    pthread_mutex_init(&w->lock, NULL);
+    pthread_cond_init(&w->cond, NULL);
+    return !pthread_create(&w->thread, NULL, writer_thread, w);
+}
+
+
+/* Queues a copy of the packet, as the encoder reuses its buffers */
+static void writer_push(struct writer_ctx *w, const vpx_codec_cx_pkt_t *pkt)
+{
+    vpx_codec_cx_pkt_t copy;
+
+    dup_packet(&copy, pkt);
+    pthread_mutex_lock(&w->lock);
+
+    while (w->count == w->slots)
+        pthread_cond_wait(&w->cond, &w->lock);
+
+    w->queue[(w->head + w->count) % w->slots] = copy;
+    w->count++;
+    pthread_cond_broadcast(&w->cond);
+    pthread_mutex_unlock(&w->lock);
+}
+
+
+/* Waits for everything queued to be written */
+static void writer_close(struct writer_ctx *w)
+{
+    pthread_mutex_lock(&w->lock);
+    w->done = 1;
+    pthread_cond_broadcast(&w->cond);
+    pthread_mutex_unlock(&w->lock);
+
+    pthread_join(w->thread, NULL);
+    pthread_cond_destroy(&w->cond);
+    pthread_mutex_destroy(&w->lock);
+    free(w->queue);
+}
+#endif
+
+
+/* With --segments, the second pass is split into runs of frames that are
+ * encoded concurrently, each by its own encoder from its own slice of the
+ * first pass statistics, and then written out in order.
+ */
+struct segment
+{
+    /* Common to all segments */
+    const char                *in_fn;
+    unsigned int               file_type;
+    int                        use_i420;
+    unsigned int               read_buffer;
+    vpx_codec_iface_t         *iface;
+    vpx_codec_enc_cfg_t        cfg;
+    vpx_codec_flags_t          flags;
+    int                      (*ctrls)[2];
+    int                        ctrl_cnt;
+    unsigned long              deadline;
+    struct vpx_rational        framerate;
+
+    /* Frames first .. first + frames - 1 of the input */
+    int                        first;
+    int                        frames;
+
+    /* Output */
+    vpx_codec_cx_pkt_t        *pkts;
+    int                        pkt_cnt;
+    int                        pkt_alloc;
+    int                        frames_in;
+    unsigned long              cx_time;
+    uint64_t                   psnr_sse_total;
+    uint64_t                   psnr_samples_total;
+    double                     psnr_totals[4];
+    int                        psnr_count;
+    int                        failed;
+
+#if USE_THREADS
+    pthread_t                  thread;
+#endif
+};
+
+
+/* Number of doubles at the start of each VP8 first pass packet, the first
+ * of which is the frame number. They are followed by a per macroblock
+ * motion map that is not part of the sums.
+ */
+#define FIRSTPASS_STATS_DOUBLES 16
+
+/* The final first pass packet holds the sums of the doubles of all the
+ * others, with the rest of the packet zeroed. Each segment gets its frames
+ * renumbered from zero, followed by such a packet for its own frames.
+ */
+static vpx_fixed_buf_t segment_stats(vpx_fixed_buf_t stats, size_t pkt_sz,
+                                     int first, int frames)
+{
+    vpx_fixed_buf_t  buf;
+    size_t           n = pkt_sz / sizeof(double);
+    double          *in, *total;
+    int              i;
+    size_t           j;
+
+    if (n > FIRSTPASS_STATS_DOUBLES)
+        n = FIRSTPASS_STATS_DOUBLES;
+
+    buf.sz = (frames + 1) * pkt_sz;
+    buf.buf = malloc(buf.sz);
+
+    if (!buf.buf)
+    {
+        fprintf(stderr, "Failed to allocate first-pass stats buffer\n");
+        exit(EXIT_FAILURE);
+    }
+
+    memcpy(buf.buf, (char *)stats.buf + first * pkt_sz, frames * pkt_sz);
+    in = buf.buf;
+    total = (double *)((char *)buf.buf + frames * pkt_sz);
+    memset(total, 0, pkt_sz);
+
+    for (i = 0; i < frames; i++, in += pkt_sz / sizeof(double))
+    {
+        in[0] -= first;
+
+        for (j = 0; j < n; j++)
+            total[j] += in[j];
+    }
+
+    return buf;
+}
+
+
+/* Opens the input positioned at the segment's first frame */
+static FILE *open_segment_input(const struct segment *seg, y4m_input *y4m,
+                                struct detect_buffer *detect)
+{
+    FILE   *f = fopen(seg->in_fn, "rb");
+    size_t  frame_sz;
+    int     i;
+
+    if (!f)
+        return NULL;
+
+    set_read_buffer(f, seg->read_buffer);
+    detect->valid = 0;
+
+    if (seg->file_type == FILE_TYPE_Y4M)
+    {
+        vpx_image_t img;
+
+        if (fread(detect->buf, 1, 4, f) != 4
+            || y4m_input_open(y4m, f, detect->buf, 4) < 0)
+        {
+            fclose(f);
+            return NULL;
+        }
+
+        /* Frame headers may carry parameters, so read up to the start */
+        for (i = 0; i < seg->first; i++)
+            if (y4m_input_fetch_frame(y4m, f, &img) < 1)
+                break;
+
+        return f;
+    }
+
+    frame_sz = seg->cfg.g_w * seg->cfg.g_h
+               + 2 * ((seg->cfg.g_w + 1) / 2) * ((seg->cfg.g_h + 1) / 2);
+
+    if (seg->file_type == FILE_TYPE_IVF)
+        fseek(f, IVF_FILE_HDR_SZ
+              + (long)seg->first * (IVF_FRAME_HDR_SZ + frame_sz), SEEK_SET);
+    else
+        fseek(f, (long)seg->first * frame_sz, SEEK_SET);
+
+    return f;
+}
+
+
+/* Reports a codec error of a segment encoder. Segments run on their own
+ * threads, so rather than exiting the failure is left for the thread that
+ * joins the segment.
+ */
+static int segment_ctx_error(struct segment *seg, vpx_codec_ctx_t *ctx,
+                             const char *s)
+{
+    if (ctx->err)
+    {
+        const char *detail = vpx_codec_error_detail(ctx);
+
+        fprintf(stderr, "\nSegment at frame %d: %s: %s\n", seg->first, s,
+                vpx_codec_error(ctx));
+
+        if (detail)
+            fprintf(stderr, "    %s\n", detail);
+
+        seg->failed = 1;
+    }
+
+    return seg->failed;
+}
+
+
+static void encode_segment_frames(struct segment *seg,
+                                  vpx_codec_ctx_t *encoder, FILE *infile,
+                                  y4m_input *y4m, struct detect_buffer *detect,
+                                  vpx_image_t *raw)
+{
+    const vpx_codec_enc_cfg_t *cfg = &seg->cfg;
+    int                    frame_avail = 1, got_data = 0, i;
+
+    for (i = 0; i < seg->ctrl_cnt; i++)
+    {
+        vpx_codec_control_(encoder, seg->ctrls[i][0], seg->ctrls[i][1]);
+
+        if (segment_ctx_error(seg, encoder, "Failed to control codec"))
+            return;
+    }
+
+    while (frame_avail || got_data)
+    {
+        vpx_codec_iter_t iter = NULL;
+        const vpx_codec_cx_pkt_t *pkt;
+        struct vpx_usec_timer timer;
+        int64_t frame_start;
+
+        if (seg->frames_in < seg->frames)
+            frame_avail = read_frame(infile, raw, seg->file_type, y4m,
+                                     detect);
+        else
+            frame_avail = 0;
+
+        if (frame_avail)
+            seg->frames_in++;
+
+        /* Time stamps carry on from the previous segment */
+        frame_start = (cfg->g_timebase.den
+                       * (int64_t)(seg->first + seg->frames_in - 1)
+                       * seg->framerate.den)
+                      / cfg->g_timebase.num / seg->framerate.num;
+        vpx_usec_timer_start(&timer);
+        vpx_codec_encode(encoder, frame_avail ? raw : NULL, frame_start,
+                         cfg->g_timebase.den * seg->framerate.den
+                         / cfg->g_timebase.num / seg->framerate.num,
+                         0, seg->deadline);
+        vpx_usec_timer_mark(&timer);
+        seg->cx_time += vpx_usec_timer_elapsed(&timer);
+
+        if (segment_ctx_error(seg, encoder, "Failed to encode frame"))
+            return;
+
+        got_data = 0;
+
+        while ((pkt = vpx_codec_get_cx_data(encoder, &iter)))
+        {
+            got_data = 1;
+
+            if (pkt->kind == VPX_CODEC_CX_FRAME_PKT)
+            {
+                if (seg->pkt_cnt == seg->pkt_alloc)
+                {
+                    vpx_codec_cx_pkt_t *pkts;
+
+                    seg->pkt_alloc = seg->pkt_alloc ? seg->pkt_alloc * 2 : 64;
+                    pkts = realloc(seg->pkts,
+                                   seg->pkt_alloc * sizeof(*seg->pkts));
+
+                    if (!pkts)
+                    {
+                        fprintf(stderr, "\nSegment at frame %d: Failed to "
+                                "allocate output packet list\n", seg->first);
+                        seg->failed = 1;
+                        return;
+                    }
+
+                    seg->pkts = pkts;
+                }
+
+                dup_packet(&seg->pkts[seg->pkt_cnt++], pkt);
+            }
+            else if (pkt->kind == VPX_CODEC_PSNR_PKT)
+            {
+                seg->psnr_sse_total += pkt->data.psnr.sse[0];
+                seg->psnr_samples_total += pkt->data.psnr.samples[0];
+
+                for (i = 0; i < 4; i++)
+                    seg->psnr_totals[i] += pkt->data.psnr.psnr[i];
+
+                seg->psnr_count++;
+            }
+        }
+    }
+}
+
+
+static void *encode_segment(void *arg)
+{
+    struct segment        *seg = arg;
+    vpx_codec_ctx_t        encoder;
+    FILE                  *infile;
+    y4m_input              y4m;
+    struct detect_buffer   detect;
+    vpx_image_t            raw;
+
+    infile = open_segment_input(seg, &y4m, &detect);
+
+    if (!infile)
+    {
+        fprintf(stderr, "\nFailed to open input file for segment at frame "
+                "%d\n", seg->first);
+        seg->failed = 1;
+        free(seg->cfg.rc_twopass_stats_in.buf);
+        return NULL;
+    }
+
+    vpx_img_alloc(&raw, seg->file_type == FILE_TYPE_Y4M || seg->use_i420
+                  ? VPX_IMG_FMT_I420 : VPX_IMG_FMT_YV12,
+                  seg->cfg.g_w, seg->cfg.g_h, 1);
+
+    vpx_codec_enc_init(&encoder, seg->iface, &seg->cfg, seg->flags);
+
+    if (!segment_ctx_error(seg, &encoder, "Failed to initialize encoder"))
+    {
+        encode_segment_frames(seg, &encoder, infile, &y4m, &detect, &raw);
+        vpx_codec_destroy(&encoder);
+    }
+
+    fclose(infile);
+
+    if (seg->file_type == FILE_TYPE_Y4M)
+        y4m_input_close(&y4m);
+
+    vpx_img_free(&raw);
+
+    free(seg->cfg.rc_twopass_stats_in.buf);
+    return NULL;
+}
+
+
+/* Splits the frames counted by the first pass into at most count segments.
+ * Where key frames are at most kf_max_dist apart, segments start on a
+ * multiple of it so that the key frame spacing is kept.
+ */
+static struct segment *split_segments(const struct segment *tmpl,
+                                      vpx_fixed_buf_t stats, size_t pkt_sz,
+                                      int *count)
+{
+    struct segment *seg;
+    int             frames = pkt_sz ? stats.sz / pkt_sz - 1 : 0;
+    int             n = 0, first = 0, k;
+
+    seg = calloc(*count, sizeof(*seg));
+
+    if (!seg || frames < 1)
+        die("No first pass statistics to split into segments\n");
+
+    for (k = 1; k <= *count; k++)
+    {
+        int end = (int)((int64_t)frames * k / *count);
+
+        if (k < *count && tmpl->cfg.kf_mode == VPX_KF_AUTO
+            && tmpl->cfg.kf_max_dist
+            && (int)tmpl->cfg.kf_max_dist <= frames / *count)
+            end -= end % tmpl->cfg.kf_max_dist;
+
+        if (end <= first)
+            continue;
+
+        seg[n] = *tmpl;
+        seg[n].first = first;
+        seg[n].frames = end - first;
+        seg[n].cfg.rc_twopass_stats_in =
+            segment_stats(stats, pkt_sz, first, end - first);
+        first = end;
+        n++;
+    }
+
+    *count = n;
+    return seg;
+}
+
+
 #include "math.h"
 
 static double vp8_mse2psnr(double Samples, double Peak, double Mse)
@@ -829,6 +1579,50 @@ static double vp8_mse2psnr(double Samples, double Peak, double Mse)
 }
 
 
+static void show_frame_stats(const vp8e_frame_stats_t *s)
+{
+    static const char *mode_names[VP8E_FRAME_STATS_MODES] =
+    {
+        "DC", "V", "H", "TM", "B", "NEAREST", "NEAR", "ZERO", "NEW", "SPLIT"
+    };
+    uint64_t staged = s->motion_search + s->mode_decision + s->transform
+                      + s->tokenize + s->pick_lpf + s->pack;
+    unsigned int mbs = 0;
+    int i;
+
+    for (i = 0; i < VP8E_FRAME_STATS_MODES; i++)
+        mbs += s->modes[i];
+
+#define STAGE(name, us) \
+    fprintf(stderr, "  %-14s %9.1f us/frame %5.1f%%\n", name, \
+            (double)(us) / s->frames, (double)(us) * 100.0 / s->total)
+    fprintf(stderr, "\nEncoder stages:\n");
+    STAGE("motion search", s->motion_search);
+    STAGE("mode decision", s->mode_decision);
+    STAGE("transform", s->transform);
+    STAGE("tokenize", s->tokenize);
+    STAGE("loop filter", s->pick_lpf);
+    STAGE("pack", s->pack);
+    STAGE("other", s->total > staged ? s->total - staged : 0);
+    STAGE("total", s->total);
+#undef STAGE
+
+    fprintf(stderr, "Recodes: %u in %u frames\n", s->recodes, s->frames);
+
+    if (mbs)
+    {
+        fprintf(stderr, "Modes:");
+
+        for (i = 0; i < VP8E_FRAME_STATS_MODES; i++)
+            fprintf(stderr, " %s %.1f%%", mode_names[i],
+                    s->modes[i] * 100.0 / mbs);
+
+        fprintf(stderr, "\nSkipped: %.1f%% of %u macroblocks\n",
+                s->skips * 100.0 / mbs, mbs);
+    }
+}
+
+
 #include "args.h"
 
 static const arg_def_t debugmode = ARG_DEF("D", "debug", 0,
@@ -865,13 +1659,23 @@ static const arg_def_t framerate        = ARG_DEF(NULL, "fps", 1,
         "Stream frame rate (rate/scale)");
 static const arg_def_t use_ivf          = ARG_DEF(NULL, "ivf", 0,
         "Output IVF (default is WebM)");
+static const arg_def_t live_webm        = ARG_DEF(NULL, "live", 0,
+        "Output WebM for live streaming (implied for pipes)");
+static const arg_def_t read_ahead       = ARG_DEF(NULL, "read-ahead", 1,
+        "Frames to read ahead of the encoder on a separate thread");
+static const arg_def_t read_buffer      = ARG_DEF(NULL, "read-buffer", 1,
+        "Read the input in batches of this many kB");
+static const arg_def_t segments         = ARG_DEF(NULL, "segments", 1,
+        "Encode the second pass as this many concurrent segments");
+static const arg_def_t frame_stats_arg  = ARG_DEF(NULL, "frame-stats", 0,
+        "Show where the encoder spent its time");
 static const arg_def_t *main_args[] =
 {
     &debugmode,
     &outputfile, &codecarg, &passes, &pass_arg, &fpf_name, &limit, &deadline,
     &best_dl, &good_dl, &rt_dl,
-    &verbosearg, &psnrarg, &use_ivf, &framerate,
-    NULL
+    &verbosearg, &psnrarg, &use_ivf, &live_webm, &framerate,
+    &read_ahead, &read_buffer, &segments, &frame_stats_arg, NULL
 };
 
 static const arg_def_t usage            = ARG_DEF("u", "usage", 1,
@@ -983,18 +1787,24 @@ static const arg_def_t arnr_strength = ARG_DEF(NULL, "arnr-strength", 1,
                                        "alt_ref Strength");
 static const arg_def_t arnr_type = ARG_DEF(NULL, "arnr-type", 1,
                                    "alt_ref Type");
+static const arg_def_t low_memory = ARG_DEF(NULL, "low-memory", 1,
+                                    "Reduce encoder memory footprint (0-1)");
+static const arg_def_t max_frame_size = ARG_DEF(NULL, "max-frame-size", 1,
+                                        "Hard cap on the size of each frame (bytes)");
 
 static const arg_def_t *vp8_args[] =
 {
     &cpu_used, &auto_altref, &noise_sens, &sharpness, &static_thresh,
-    &token_parts, &arnr_maxframes, &arnr_strength, &arnr_type, NULL
+    &token_parts, &arnr_maxframes, &arnr_strength, &arnr_type,
+    &low_memory, &max_frame_size, NULL
 };
 static const int vp8_arg_ctrl_map[] =
 {
     VP8E_SET_CPUUSED, VP8E_SET_ENABLEAUTOALTREF,
     VP8E_SET_NOISE_SENSITIVITY, VP8E_SET_SHARPNESS, VP8E_SET_STATIC_THRESHOLD,
     VP8E_SET_TOKEN_PARTITIONS,
-    VP8E_SET_ARNR_MAXFRAMES, VP8E_SET_ARNR_STRENGTH , VP8E_SET_ARNR_TYPE, 0
+    VP8E_SET_ARNR_MAXFRAMES, VP8E_SET_ARNR_STRENGTH , VP8E_SET_ARNR_TYPE,
+    VP8E_SET_LOW_MEMORY, VP8E_SET_MAX_FRAME_SIZE, 0
 };
 #endif
 
@@ -1057,7 +1867,7 @@ int main(int argc, const char **argv_)
     int                      arg_limit = 0;
     static const arg_def_t **ctrl_args = no_args;
     static const int        *ctrl_args_map = NULL;
-    int                      verbose = 0, show_psnr = 0;
+    int                      verbose = 0, show_psnr = 0, show_stats = 0;
     int                      arg_use_i420 = 1;
     unsigned long            cx_time = 0;
     unsigned int             file_type, fourcc;
@@ -1065,12 +1875,22 @@ int main(int argc, const char **argv_)
     struct vpx_rational      arg_framerate = {30, 1};
     int                      arg_have_framerate = 0;
     int                      write_webm = 1;
+    int                      arg_live = 0, live, seekable;
+    int                      arg_read_ahead = 0, arg_segments = 0;
+    unsigned int             arg_read_buffer = 0;
+    size_t                   stats_pkt_sz = 0;
     EbmlGlobal               ebml = {0};
-    uint32_t                 hash = 0;
+    WebMStream              *webm_stream = NULL;
+    struct output_ctx        out;
+#if USE_THREADS
+    struct reader_ctx        reader;
+    struct writer_ctx        writer;
+#endif
     uint64_t                 psnr_sse_total = 0;
     uint64_t                 psnr_samples_total = 0;
     double                   psnr_totals[4] = {0, 0, 0, 0};
     int                      psnr_count = 0;
+    vp8e_frame_stats_t       frame_stats;
 
     exec_name = argv_[0];
 
@@ -1149,6 +1969,16 @@ int main(int argc, const char **argv_)
         }
         else if (arg_match(&arg, &use_ivf, argi))
             write_webm = 0;
+        else if (arg_match(&arg, &live_webm, argi))
+            arg_live = 1;
+        else if (arg_match(&arg, &read_ahead, argi))
+            arg_read_ahead = arg_parse_uint(&arg);
+        else if (arg_match(&arg, &read_buffer, argi))
+            arg_read_buffer = arg_parse_uint(&arg);
+        else if (arg_match(&arg, &segments, argi))
+            arg_segments = arg_parse_uint(&arg);
+        else if (arg_match(&arg, &frame_stats_arg, argi))
+            show_stats = 1;
         else if (arg_match(&arg, &outputfile, argi))
             out_fn = arg.val;
         else if (arg_match(&arg, &debugmode, argi))
@@ -1324,6 +2154,28 @@ int main(int argc, const char **argv_)
     if(!out_fn)
         die("Error: Output file is required (specify with -o)\n");
 
+    /* Segments are cut from the first pass run here, and each reopens the
+     * input.
+     */
+    if (arg_segments > 1
+        && (arg_passes != 2 || one_pass_only || !strcmp(in_fn, "-")))
+        die("Error: --segments requires --passes=2 and a file input, "
+            "without --pass\n");
+
+    if (arg_segments > 1 && show_stats)
+        die("Error: --frame-stats can not be used with --segments\n");
+
+#if !USE_THREADS
+
+    if (arg_read_ahead)
+    {
+        fprintf(stderr, "Warning: --read-ahead requires thread support, "
+                "ignored\n");
+        arg_read_ahead = 0;
+    }
+
+#endif
+
     memset(&stats, 0, sizeof(stats));
 
     for (pass = one_pass_only ? one_pass_only - 1 : 0; pass < arg_passes; pass++)
@@ -1342,6 +2194,8 @@ int main(int argc, const char **argv_)
             return EXIT_FAILURE;
         }
 
+        set_read_buffer(infile, arg_read_buffer);
+
         /* For RAW input sources, these bytes will applied on the first frame
          *  in read_frame().
          * We can always read 4 bytes because the minimum supported frame size
@@ -1439,14 +2293,10 @@ int main(int argc, const char **argv_)
         }
 
         if(pass == (one_pass_only ? one_pass_only - 1 : 0)) {
-            if (file_type == FILE_TYPE_Y4M)
-                /*The Y4M reader does its own allocation.
-                  Just initialize this here to avoid problems if we never read any
-                   frames.*/
-                memset(&raw, 0, sizeof(raw));
-            else
-                vpx_img_alloc(&raw, arg_use_i420 ? VPX_IMG_FMT_I420 : VPX_IMG_FMT_YV12,
-                              cfg.g_w, cfg.g_h, 1);
+            /* The Y4M reader converts straight into this image, in I420 */
+            vpx_img_alloc(&raw, file_type == FILE_TYPE_Y4M || arg_use_i420
+                          ? VPX_IMG_FMT_I420 : VPX_IMG_FMT_YV12,
+                          cfg.g_w, cfg.g_h, 1);
         }
 
         outfile = strcmp(out_fn, "-") ? fopen(out_fn, "wb") : stdout;
@@ -1457,11 +2307,9 @@ int main(int argc, const char **argv_)
             return EXIT_FAILURE;
         }
 
-        if(write_webm && fseek(outfile, 0, SEEK_CUR))
-        {
-            fprintf(stderr, "WebM output to pipes not supported.\n");
-            return EXIT_FAILURE;
-        }
+        /* WebM that can't be patched up afterwards is streamed live */
+        seekable = !fseek(outfile, 0, SEEK_CUR);
+        live = write_webm && (arg_live || !seekable);
 
         if (stats_fn)
         {
@@ -1492,7 +2340,20 @@ int main(int argc, const char **argv_)
 
 #endif
 
-        if(write_webm)
+        if(live)
+        {
+            /* The header goes out with the first frame, which the track
+             * UID is derived from.
+             */
+            webm_stream = WebMStream_Create(write_webm_stream_data, outfile);
+
+            if (!webm_stream)
+            {
+                fprintf(stderr, "Failed to allocate WebM stream\n");
+                return EXIT_FAILURE;
+            }
+        }
+        else if(write_webm)
         {
             ebml.stream = outfile;
             write_webm_file_header(&ebml, &cfg, &arg_framerate);
@@ -1501,122 +2362,291 @@ int main(int argc, const char **argv_)
             write_ivf_file_header(outfile, &cfg, codec->fourcc, 0);
 
 
-        /* Construct Encoder Context */
-        vpx_codec_enc_init(&encoder, codec->iface, &cfg,
-                           show_psnr ? VPX_CODEC_USE_PSNR : 0);
-        ctx_exit_on_error(&encoder, "Failed to initialize encoder");
+        out.file = outfile;
+        out.live = live;
+        out.write_webm = write_webm;
+        out.ebml = &ebml;
+        out.webm_stream = webm_stream;
+        out.hash = 0;
+        out.stats = &stats;
+        out.cfg = &cfg;
+        out.framerate = arg_framerate;
+        out.frames = 0;
 
-        /* Note that we bypass the vpx_codec_control wrapper macro because
-         * we're being clever to store the control IDs in an array. Real
-         * applications will want to make use of the enumerations directly
-         */
-        for (i = 0; i < arg_ctrl_cnt; i++)
+        if (pass && arg_segments > 1)
         {
-            if (vpx_codec_control_(&encoder, arg_ctrls[i][0], arg_ctrls[i][1]))
-                fprintf(stderr, "Error: Tried to set control %d = %d\n",
-                        arg_ctrls[i][0], arg_ctrls[i][1]);
+            struct segment  tmpl, *seg;
+            int             count = arg_segments;
+            int             seg_failed = 0;
+            unsigned long   seg_time = 0;
+
+            memset(&tmpl, 0, sizeof(tmpl));
+            tmpl.in_fn = in_fn;
+            tmpl.file_type = file_type;
+            tmpl.use_i420 = arg_use_i420;
+            tmpl.read_buffer = arg_read_buffer;
+            tmpl.iface = codec->iface;
+            tmpl.cfg = cfg;
+            tmpl.flags = show_psnr ? VPX_CODEC_USE_PSNR : 0;
+            tmpl.ctrls = arg_ctrls;
+            tmpl.ctrl_cnt = arg_ctrl_cnt;
+            tmpl.deadline = arg_deadline;
+            tmpl.framerate = arg_framerate;
+
+            seg = split_segments(&tmpl, stats_get(&stats), stats_pkt_sz,
+                                 &count);
+#if USE_THREADS
+
+            for (i = 0; i < count; i++)
+                if (pthread_create(&seg[i].thread, NULL, encode_segment,
+                                   &seg[i]))
+                    die("Failed to start segment encoder\n");
 
-            ctx_exit_on_error(&encoder, "Failed to control codec");
-        }
+#endif
 
-        frame_avail = 1;
-        got_data = 0;
+            /* Segments are written as they finish, in order. After a
+             * failure the remaining segments are only waited for.
+             */
+            for (i = 0; i < count; i++)
+            {
+                int j;
+
+#if USE_THREADS
+                pthread_join(seg[i].thread, NULL);
+#else
+
+                if (!seg_failed)
+                    encode_segment(&seg[i]);
+                else
+                    free(seg[i].cfg.rc_twopass_stats_in.buf);
+
+#endif
+
+                seg_failed |= seg[i].failed;
+
+                for (j = 0; j < seg[i].pkt_cnt; j++)
+                {
+                    if (!seg_failed)
+                    {
+                        write_packet(&out, &seg[i].pkts[j]);
+                        nbytes += seg[i].pkts[j].data.frame.sz;
+                    }
+
+                    free_packet(&seg[i].pkts[j]);
+                }
+
+                free(seg[i].pkts);
+
+                if (seg_failed)
+                    continue;
+
+                frames_in += seg[i].frames_in;
+                frames_out += seg[i].pkt_cnt;
+
+                if (seg[i].cx_time > seg_time)
+                    seg_time = seg[i].cx_time;
+
+                psnr_sse_total += seg[i].psnr_sse_total;
+                psnr_samples_total += seg[i].psnr_samples_total;
+
+                for (j = 0; j < 4; j++)
+                    psnr_totals[j] += seg[i].psnr_totals[j];
+
+                psnr_count += seg[i].psnr_count;
+
+                fprintf(stderr,
+                        "\rPass %d/%d segment %d/%d frame %4d/%-4d %7ldB \033[K",
+                        pass + 1, arg_passes, i + 1, count, frames_in,
+                        frames_out, nbytes);
+            }
+
+            free(seg);
 
-        while (frame_avail || got_data)
+            if (seg_failed)
+                die("Failed to encode the second pass segments\n");
+
+            /* The segments run side by side, so the slowest sets the time */
+            cx_time += seg_time;
+        }
+        else
         {
-            vpx_codec_iter_t iter = NULL;
-            const vpx_codec_cx_pkt_t *pkt;
-            struct vpx_usec_timer timer;
-            int64_t frame_start;
+            /* Construct Encoder Context */
+            vpx_codec_enc_init(&encoder, codec->iface, &cfg,
+                               show_psnr ? VPX_CODEC_USE_PSNR : 0);
+            ctx_exit_on_error(&encoder, "Failed to initialize encoder");
+
+            /* Note that we bypass the vpx_codec_control wrapper macro because
+             * we're being clever to store the control IDs in an array. Real
+             * applications will want to make use of the enumerations directly
+             */
+            for (i = 0; i < arg_ctrl_cnt; i++)
+            {
+                if (vpx_codec_control_(&encoder, arg_ctrls[i][0], arg_ctrls[i][1]))
+                    fprintf(stderr, "Error: Tried to set control %d = %d\n",
+                            arg_ctrls[i][0], arg_ctrls[i][1]);
+
+                ctx_exit_on_error(&encoder, "Failed to control codec");
+            }
 
-            if (!arg_limit || frames_in < arg_limit)
+            memset(&frame_stats, 0, sizeof(frame_stats));
+
+            if (show_stats)
             {
-                frame_avail = read_frame(infile, &raw, file_type, &y4m,
-                                         &detect);
+                vpx_codec_control(&encoder, VP8E_SET_FRAME_STATS, 1);
+                ctx_exit_on_error(&encoder, "Failed to enable frame stats");
+            }
 
-                if (frame_avail)
-                    frames_in++;
+#if USE_THREADS
 
-                fprintf(stderr,
-                        "\rPass %d/%d frame %4d/%-4d %7ldB \033[K", pass + 1,
-                        arg_passes, frames_in, frames_out, nbytes);
+            if (arg_read_ahead)
+            {
+                if (!reader_open(&reader, arg_read_ahead, infile, file_type, &y4m,
+                                 &detect, arg_limit,
+                                 file_type == FILE_TYPE_Y4M || arg_use_i420
+                                 ? VPX_IMG_FMT_I420 : VPX_IMG_FMT_YV12,
+                                 cfg.g_w, cfg.g_h)
+                    || !writer_open(&writer, arg_read_ahead, &out))
+                {
+                    fprintf(stderr, "Failed to start I/O threads\n");
+                    return EXIT_FAILURE;
+                }
             }
-            else
-                frame_avail = 0;
-
-            vpx_usec_timer_start(&timer);
-
-            frame_start = (cfg.g_timebase.den * (int64_t)(frames_in - 1)
-                          * arg_framerate.den) / cfg.g_timebase.num / arg_framerate.num;
-            vpx_codec_encode(&encoder, frame_avail ? &raw : NULL, frame_start,
-                             cfg.g_timebase.den * arg_framerate.den
-                             / cfg.g_timebase.num / arg_framerate.num,
-                             0, arg_deadline);
-            vpx_usec_timer_mark(&timer);
-            cx_time += vpx_usec_timer_elapsed(&timer);
-            ctx_exit_on_error(&encoder, "Failed to encode frame");
+
+#endif
+
+            frame_avail = 1;
             got_data = 0;
 
-            while ((pkt = vpx_codec_get_cx_data(&encoder, &iter)))
+            while (frame_avail || got_data)
             {
-                got_data = 1;
+                vpx_codec_iter_t iter = NULL;
+                const vpx_codec_cx_pkt_t *pkt;
+                struct vpx_usec_timer timer;
+                int64_t frame_start;
+                vpx_image_t *img = &raw;
 
-                switch (pkt->kind)
+                if (!arg_limit || frames_in < arg_limit)
                 {
-                case VPX_CODEC_CX_FRAME_PKT:
-                    frames_out++;
-                    fprintf(stderr, " %6luF",
-                            (unsigned long)pkt->data.frame.sz);
+#if USE_THREADS
 
-                    if(write_webm)
+                    if (arg_read_ahead)
                     {
-                        /* Update the hash */
-                        if(!ebml.debug)
-                            hash = murmur(pkt->data.frame.buf,
-                                          pkt->data.frame.sz, hash);
-
-                        write_webm_block(&ebml, &cfg, pkt);
+                        img = reader_next(&reader);
+                        frame_avail = img != NULL;
                     }
                     else
+#endif
+                        frame_avail = read_frame(infile, &raw, file_type, &y4m,
+                                                 &detect);
+
+                    if (frame_avail)
+                        frames_in++;
+
+                    fprintf(stderr,
+                            "\rPass %d/%d frame %4d/%-4d %7ldB \033[K", pass + 1,
+                            arg_passes, frames_in, frames_out, nbytes);
+                }
+                else
+                    frame_avail = 0;
+
+                vpx_usec_timer_start(&timer);
+
+                frame_start = (cfg.g_timebase.den * (int64_t)(frames_in - 1)
+                              * arg_framerate.den) / cfg.g_timebase.num / arg_framerate.num;
+                vpx_codec_encode(&encoder, frame_avail ? img : NULL, frame_start,
+                                 cfg.g_timebase.den * arg_framerate.den
+                                 / cfg.g_timebase.num / arg_framerate.num,
+                                 0, arg_deadline);
+                vpx_usec_timer_mark(&timer);
+#if USE_THREADS
+
+                /* The encoder has taken its own copy of the frame */
+                if (arg_read_ahead && frame_avail)
+                    reader_release(&reader);
+
+#endif
+                cx_time += vpx_usec_timer_elapsed(&timer);
+                ctx_exit_on_error(&encoder, "Failed to encode frame");
+                got_data = 0;
+
+                while ((pkt = vpx_codec_get_cx_data(&encoder, &iter)))
+                {
+                    got_data = 1;
+
+                    switch (pkt->kind)
                     {
-                        write_ivf_frame_header(outfile, pkt);
-                        if(fwrite(pkt->data.frame.buf, 1,
-                                  pkt->data.frame.sz, outfile));
-                    }
-                    nbytes += pkt->data.raw.sz;
-                    break;
-                case VPX_CODEC_STATS_PKT:
-                    frames_out++;
-                    fprintf(stderr, " %6luS",
-                           (unsigned long)pkt->data.twopass_stats.sz);
-                    stats_write(&stats,
-                                pkt->data.twopass_stats.buf,
-                                pkt->data.twopass_stats.sz);
-                    nbytes += pkt->data.raw.sz;
-                    break;
-                case VPX_CODEC_PSNR_PKT:
-
-                    if (show_psnr)
-                    {
-                        int i;
+                    case VPX_CODEC_CX_FRAME_PKT:
+                        frames_out++;
+                        fprintf(stderr, " %6luF",
+                                (unsigned long)pkt->data.frame.sz);
+#if USE_THREADS
+
+                        if (arg_read_ahead)
+                            writer_push(&writer, pkt);
+                        else
+#endif
+                            write_packet(&out, pkt);
+
+                        nbytes += pkt->data.raw.sz;
+                        break;
+                    case VPX_CODEC_STATS_PKT:
+                        frames_out++;
+                        fprintf(stderr, " %6luS",
+                               (unsigned long)pkt->data.twopass_stats.sz);
+                        stats_pkt_sz = pkt->data.twopass_stats.sz;
+#if USE_THREADS
+
+                        if (arg_read_ahead)
+                            writer_push(&writer, pkt);
+                        else
+#endif
+                            write_packet(&out, pkt);
+
+                        nbytes += pkt->data.raw.sz;
+                        break;
+                    case VPX_CODEC_PSNR_PKT:
 
-                        psnr_sse_total += pkt->data.psnr.sse[0];
-                        psnr_samples_total += pkt->data.psnr.samples[0];
-                        for (i = 0; i < 4; i++)
+                        if (show_psnr)
                         {
-                            fprintf(stderr, "%.3lf ", pkt->data.psnr.psnr[i]);
-                            psnr_totals[i] += pkt->data.psnr.psnr[i];
+                            int i;
+
+                            psnr_sse_total += pkt->data.psnr.sse[0];
+                            psnr_samples_total += pkt->data.psnr.samples[0];
+                            for (i = 0; i < 4; i++)
+                            {
+                                fprintf(stderr, "%.3lf ", pkt->data.psnr.psnr[i]);
+                                psnr_totals[i] += pkt->data.psnr.psnr[i];
+                            }
+                            psnr_count++;
                         }
-                        psnr_count++;
-                    }
 
-                    break;
-                default:
-                    break;
+                        break;
+                    default:
+                        break;
+                    }
                 }
+
+                fflush(stdout);
             }
 
-            fflush(stdout);
+#if USE_THREADS
+
+            if (arg_read_ahead)
+            {
+                reader_close(&reader);
+                writer_close(&writer);
+            }
+
+#endif
+
+            if (show_stats)
+            {
+                vpx_codec_control(&encoder, VP8E_GET_FRAME_STATS_TOTAL,
+                                  &frame_stats);
+                ctx_exit_on_error(&encoder, "Failed to get frame stats");
+            }
+
+            vpx_codec_destroy(&encoder);
         }
 
         fprintf(stderr,
@@ -1643,13 +2673,20 @@ int main(int argc, const char **argv_)
             }
         }
 
-        vpx_codec_destroy(&encoder);
+        if (show_stats && frame_stats.frames)
+            show_frame_stats(&frame_stats);
 
         fclose(infile);
 
-        if(write_webm)
+        if(live)
+        {
+            /* Cues are only of use to a file */
+            if(WebMStream_Close(webm_stream, seekable))
+                fprintf(stderr, "\nFailed to write WebM stream");
+        }
+        else if(write_webm)
         {
-            write_webm_file_footer(&ebml, hash);
+            write_webm_file_footer(&ebml, out.hash);
         }
         else
         {
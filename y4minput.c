@@ -144,9 +144,8 @@ static int y4m_parse_tags(y4m_input *_y4m,char *_tags){
   The 4:2:2 modes look exactly the same, except there are twice as many chroma
    lines, and they are vertically co-sited with the luma samples in both the
    mpeg2 and jpeg cases (thus requiring no vertical resampling).*/
-static void y4m_42xmpeg2_42xjpeg_helper(unsigned char *_dst,
+static void y4m_42xmpeg2_42xjpeg_helper(unsigned char *_dst,int _dst_stride,
  const unsigned char *_src,int _c_w,int _c_h){
-  int pli;
   int y;
   int x;
   for(y=0;y<_c_h;y++){
@@ -166,33 +165,73 @@ static void y4m_42xmpeg2_42xjpeg_helper(unsigned char *_dst,
        114*_src[x]+35*_src[OC_MINI(x+1,_c_w-1)]-9*_src[OC_MINI(x+2,_c_w-1)]+
        _src[_c_w-1]+64)>>7,255);
     }
-    _dst+=_c_w;
+    _dst+=_dst_stride;
     _src+=_c_w;
   }
 }
 
 /*Handles both 422 and 420mpeg2 to 422jpeg and 420jpeg, respectively.*/
-static void y4m_convert_42xmpeg2_42xjpeg(y4m_input *_y4m,unsigned char *_dst,
+static void y4m_convert_42xmpeg2_42xjpeg(y4m_input *_y4m,vpx_image_t *_img,
  unsigned char *_aux){
   int c_w;
   int c_h;
   int c_sz;
   int pli;
-  int y;
-  int x;
-  /*Skip past the luma data.*/
-  _dst+=_y4m->pic_w*_y4m->pic_h;
   /*Compute the size of each chroma plane.*/
   c_w=(_y4m->pic_w+_y4m->dst_c_dec_h-1)/_y4m->dst_c_dec_h;
   c_h=(_y4m->pic_h+_y4m->dst_c_dec_v-1)/_y4m->dst_c_dec_v;
   c_sz=c_w*c_h;
   for(pli=1;pli<3;pli++){
-    y4m_42xmpeg2_42xjpeg_helper(_dst,_aux,c_w,c_h);
-    _dst+=c_sz;
+    y4m_42xmpeg2_42xjpeg_helper(_img->planes[pli],_img->stride[pli],
+     _aux,c_w,c_h);
     _aux+=c_sz;
   }
 }
 
+/*Apply a vertical 6-tap filter to every _step'th row of a plane, with the
+   taps starting _off rows above it.
+  Rows outside the plane are clamped to the edge, which is what the column by
+   column loops these replace did.
+  Working a row at a time keeps the inner loop on contiguous memory with
+   fixed taps, so the compiler can vectorize it.*/
+static void y4m_vfilter6(unsigned char *_dst,int _dst_stride,
+ const unsigned char *_src,int _c_w,int _c_h,const int _taps[6],int _off,
+ int _step){
+  const unsigned char *s0;
+  const unsigned char *s1;
+  const unsigned char *s2;
+  const unsigned char *s3;
+  const unsigned char *s4;
+  const unsigned char *s5;
+  int                  t0;
+  int                  t1;
+  int                  t2;
+  int                  t3;
+  int                  t4;
+  int                  t5;
+  int                  y;
+  int                  x;
+  t0=_taps[0];
+  t1=_taps[1];
+  t2=_taps[2];
+  t3=_taps[3];
+  t4=_taps[4];
+  t5=_taps[5];
+  for(y=0;y<_c_h;y+=_step){
+    s0=_src+OC_CLAMPI(0,y+_off,_c_h-1)*_c_w;
+    s1=_src+OC_CLAMPI(0,y+_off+1,_c_h-1)*_c_w;
+    s2=_src+OC_CLAMPI(0,y+_off+2,_c_h-1)*_c_w;
+    s3=_src+OC_CLAMPI(0,y+_off+3,_c_h-1)*_c_w;
+    s4=_src+OC_CLAMPI(0,y+_off+4,_c_h-1)*_c_w;
+    s5=_src+OC_CLAMPI(0,y+_off+5,_c_h-1)*_c_w;
+    for(x=0;x<_c_w;x++){
+      _dst[x]=(unsigned char)OC_CLAMPI(0,(t0*s0[x]+t1*s1[x]+t2*s2[x]
+       +t3*s3[x]+t4*s4[x]+t5*s5[x]+64)>>7,255);
+    }
+    _dst+=_dst_stride;
+  }
+}
+
 /*This format is only used for interlaced content, but is included for
    completeness.
 
@@ -236,17 +275,19 @@ static void y4m_convert_42xmpeg2_42xjpeg(y4m_input *_y4m,unsigned char *_dst,
    the chroma plane's resolution) to the right.
   Then we use another filter to move the C_r location down one quarter pixel,
    and the C_b location up one quarter pixel.*/
-static void y4m_convert_42xpaldv_42xjpeg(y4m_input *_y4m,unsigned char *_dst,
+static void y4m_convert_42xpaldv_42xjpeg(y4m_input *_y4m,vpx_image_t *_img,
  unsigned char *_aux){
+  /*Slide C_b up a quarter-pel.
+    This is the same filter used horizontally, but in the other order.*/
+  static const int UP[6]={1,-9,35,114,-17,4};
+  /*Slide C_r down a quarter-pel.
+    This is the same as the horizontal filter.*/
+  static const int DOWN[6]={4,-17,114,35,-9,1};
   unsigned char *tmp;
   int            c_w;
   int            c_h;
   int            c_sz;
   int            pli;
-  int            y;
-  int            x;
-  /*Skip past the luma data.*/
-  _dst+=_y4m->pic_w*_y4m->pic_h;
   /*Compute the size of each chroma plane.*/
   c_w=(_y4m->pic_w+1)/2;
   c_h=(_y4m->pic_h+_y4m->dst_c_dec_h-1)/_y4m->dst_c_dec_h;
@@ -256,60 +297,11 @@ static void y4m_convert_42xpaldv_42xjpeg(y4m_input *_y4m,unsigned char *_dst,
     /*First do the horizontal re-sampling.
       This is the same as the mpeg2 case, except that after the horizontal
        case, we need to apply a second vertical filter.*/
-    y4m_42xmpeg2_42xjpeg_helper(tmp,_aux,c_w,c_h);
+    y4m_42xmpeg2_42xjpeg_helper(tmp,c_w,_aux,c_w,c_h);
     _aux+=c_sz;
-    switch(pli){
-      case 1:{
-        /*Slide C_b up a quarter-pel.
-          This is the same filter used above, but in the other order.*/
-        for(x=0;x<c_w;x++){
-          for(y=0;y<OC_MINI(c_h,3);y++){
-            _dst[y*c_w]=(unsigned char)OC_CLAMPI(0,(tmp[0]
-             -9*tmp[OC_MAXI(y-2,0)*c_w]+35*tmp[OC_MAXI(y-1,0)*c_w]
-             +114*tmp[y*c_w]-17*tmp[OC_MINI(y+1,c_h-1)*c_w]
-             +4*tmp[OC_MINI(y+2,c_h-1)*c_w]+64)>>7,255);
-          }
-          for(;y<c_h-2;y++){
-            _dst[y*c_w]=(unsigned char)OC_CLAMPI(0,(tmp[(y-3)*c_w]
-             -9*tmp[(y-2)*c_w]+35*tmp[(y-1)*c_w]+114*tmp[y*c_w]
-             -17*tmp[(y+1)*c_w]+4*tmp[(y+2)*c_w]+64)>>7,255);
-          }
-          for(;y<c_h;y++){
-            _dst[y*c_w]=(unsigned char)OC_CLAMPI(0,(tmp[(y-3)*c_w]
-             -9*tmp[(y-2)*c_w]+35*tmp[(y-1)*c_w]+114*tmp[y*c_w]
-             -17*tmp[OC_MINI(y+1,c_h-1)*c_w]+4*tmp[(c_h-1)*c_w]+64)>>7,255);
-          }
-          _dst++;
-          tmp++;
-        }
-        _dst+=c_sz-c_w;
-        tmp-=c_w;
-      }break;
-      case 2:{
-        /*Slide C_r down a quarter-pel.
-          This is the same as the horizontal filter.*/
-        for(x=0;x<c_w;x++){
-          for(y=0;y<OC_MINI(c_h,2);y++){
-            _dst[y*c_w]=(unsigned char)OC_CLAMPI(0,(4*tmp[0]
-             -17*tmp[OC_MAXI(y-1,0)*c_w]+114*tmp[y*c_w]
-             +35*tmp[OC_MINI(y+1,c_h-1)*c_w]-9*tmp[OC_MINI(y+2,c_h-1)*c_w]
-             +tmp[OC_MINI(y+3,c_h-1)*c_w]+64)>>7,255);
-          }
-          for(;y<c_h-3;y++){
-            _dst[y*c_w]=(unsigned char)OC_CLAMPI(0,(4*tmp[(y-2)*c_w]
-             -17*tmp[(y-1)*c_w]+114*tmp[y*c_w]+35*tmp[(y+1)*c_w]
-             -9*tmp[(y+2)*c_w]+tmp[(y+3)*c_w]+64)>>7,255);
-          }
-          for(;y<c_h;y++){
-            _dst[y*c_w]=(unsigned char)OC_CLAMPI(0,(4*tmp[(y-2)*c_w]
-             -17*tmp[(y-1)*c_w]+114*tmp[y*c_w]+35*tmp[OC_MINI(y+1,c_h-1)*c_w]
-             -9*tmp[OC_MINI(y+2,c_h-1)*c_w]+tmp[(c_h-1)*c_w]+64)>>7,255);
-          }
-          _dst++;
-          tmp++;
-        }
-      }break;
-    }
+    /*Then apply the second, vertical filter.*/
+    y4m_vfilter6(_img->planes[pli],_img->stride[pli],tmp,c_w,c_h,
+     pli==1?UP:DOWN,pli==1?-3:-2,1);
     /*For actual interlaced material, this would have to be done separately on
        each field, and the shift amounts would be different.
       C_r moves down 1/8, C_b up 3/8 in the top field, and C_r moves down 3/8,
@@ -322,32 +314,11 @@ static void y4m_convert_42xpaldv_42xjpeg(y4m_input *_y4m,unsigned char *_dst,
 
 /*Perform vertical filtering to reduce a single plane from 4:2:2 to 4:2:0.
   This is used as a helper by several converation routines.*/
-static void y4m_422jpeg_420jpeg_helper(unsigned char *_dst,
+static void y4m_422jpeg_420jpeg_helper(unsigned char *_dst,int _dst_stride,
  const unsigned char *_src,int _c_w,int _c_h){
-  int y;
-  int x;
   /*Filter: [3 -17 78 78 -17 3]/128, derived from a 6-tap Lanczos window.*/
-  for(x=0;x<_c_w;x++){
-    for(y=0;y<OC_MINI(_c_h,2);y+=2){
-      _dst[(y>>1)*_c_w]=OC_CLAMPI(0,(64*_src[0]
-       +78*_src[OC_MINI(1,_c_h-1)*_c_w]
-       -17*_src[OC_MINI(2,_c_h-1)*_c_w]
-       +3*_src[OC_MINI(3,_c_h-1)*_c_w]+64)>>7,255);
-    }
-    for(;y<_c_h-3;y+=2){
-      _dst[(y>>1)*_c_w]=OC_CLAMPI(0,(3*(_src[(y-2)*_c_w]+_src[(y+3)*_c_w])
-       -17*(_src[(y-1)*_c_w]+_src[(y+2)*_c_w])
-       +78*(_src[y*_c_w]+_src[(y+1)*_c_w])+64)>>7,255);
-    }
-    for(;y<_c_h;y+=2){
-      _dst[(y>>1)*_c_w]=OC_CLAMPI(0,(3*(_src[(y-2)*_c_w]
-       +_src[(_c_h-1)*_c_w])-17*(_src[(y-1)*_c_w]
-       +_src[OC_MINI(y+2,_c_h-1)*_c_w])
-       +78*(_src[y*_c_w]+_src[OC_MINI(y+1,_c_h-1)*_c_w])+64)>>7,255);
-    }
-    _src++;
-    _dst++;
-  }
+  static const int TAPS[6]={3,-17,78,78,-17,3};
+  y4m_vfilter6(_dst,_dst_stride,_src,_c_w,_c_h,TAPS,-2,2);
 }
 
 /*420jpeg chroma samples are sited like:
@@ -388,30 +359,22 @@ static void y4m_422jpeg_420jpeg_helper(unsigned char *_dst,
 
   We use a resampling filter to decimate the chroma planes by two in the
    vertical direction.*/
-static void y4m_convert_422jpeg_420jpeg(y4m_input *_y4m,unsigned char *_dst,
+static void y4m_convert_422jpeg_420jpeg(y4m_input *_y4m,vpx_image_t *_img,
  unsigned char *_aux){
   int c_w;
   int c_h;
   int c_sz;
-  int dst_c_w;
-  int dst_c_h;
-  int dst_c_sz;
   int tmp_sz;
   int pic_sz;
   int pli;
-  /*Skip past the luma data.*/
-  _dst+=_y4m->pic_w*_y4m->pic_h;
   /*Compute the size of each chroma plane.*/
   c_w=(_y4m->pic_w+_y4m->src_c_dec_h-1)/_y4m->src_c_dec_h;
   c_h=_y4m->pic_h;
-  dst_c_w=(_y4m->pic_w+_y4m->dst_c_dec_h-1)/_y4m->dst_c_dec_h;
-  dst_c_h=(_y4m->pic_h+_y4m->dst_c_dec_v-1)/_y4m->dst_c_dec_v;
   c_sz=c_w*c_h;
-  dst_c_sz=dst_c_w*dst_c_h;
   for(pli=1;pli<3;pli++){
-    y4m_422jpeg_420jpeg_helper(_dst,_aux,c_w,c_h);
+    y4m_422jpeg_420jpeg_helper(_img->planes[pli],_img->stride[pli],_aux,
+     c_w,c_h);
     _aux+=c_sz;
-    _dst+=dst_c_sz;
   }
 }
 
@@ -455,37 +418,28 @@ static void y4m_convert_422jpeg_420jpeg(y4m_input *_y4m,unsigned char *_dst,
    pixel (at the original chroma resolution) to the right.
   Then we use a second resampling filter to decimate the chroma planes by two
    in the vertical direction.*/
-static void y4m_convert_422_420jpeg(y4m_input *_y4m,unsigned char *_dst,
+static void y4m_convert_422_420jpeg(y4m_input *_y4m,vpx_image_t *_img,
  unsigned char *_aux){
   unsigned char *tmp;
   int            c_w;
   int            c_h;
   int            c_sz;
-  int            dst_c_w;
-  int            dst_c_h;
-  int            dst_c_sz;
   int            pli;
-  int            y;
-  int            x;
-  /*Skip past the luma data.*/
-  _dst+=_y4m->pic_w*_y4m->pic_h;
   /*Compute the size of each chroma plane.*/
   c_w=(_y4m->pic_w+_y4m->src_c_dec_h-1)/_y4m->src_c_dec_h;
   c_h=_y4m->pic_h;
-  dst_c_h=(_y4m->pic_h+_y4m->dst_c_dec_v-1)/_y4m->dst_c_dec_v;
   c_sz=c_w*c_h;
-  dst_c_sz=c_w*dst_c_h;
   tmp=_aux+2*c_sz;
   for(pli=1;pli<3;pli++){
     /*In reality, the horizontal and vertical steps could be pipelined, for
        less memory consumption and better cache performance, but we do them
        separately for simplicity.*/
     /*First do horizontal filtering (convert to 422jpeg)*/
-    y4m_42xmpeg2_42xjpeg_helper(tmp,_aux,c_w,c_h);
+    y4m_42xmpeg2_42xjpeg_helper(tmp,c_w,_aux,c_w,c_h);
     /*Now do the vertical filtering.*/
-    y4m_422jpeg_420jpeg_helper(_dst,tmp,c_w,c_h);
+    y4m_422jpeg_420jpeg_helper(_img->planes[pli],_img->stride[pli],tmp,
+     c_w,c_h);
     _aux+=c_sz;
-    _dst+=dst_c_sz;
   }
 }
 
@@ -530,28 +484,22 @@ static void y4m_convert_422_420jpeg(y4m_input *_y4m,unsigned char *_dst,
    right.
   Then we use another filter to decimate the planes by 2 in the vertical
    direction.*/
-static void y4m_convert_411_420jpeg(y4m_input *_y4m,unsigned char *_dst,
+static void y4m_convert_411_420jpeg(y4m_input *_y4m,vpx_image_t *_img,
  unsigned char *_aux){
   unsigned char *tmp;
   int            c_w;
   int            c_h;
   int            c_sz;
   int            dst_c_w;
-  int            dst_c_h;
-  int            dst_c_sz;
   int            tmp_sz;
   int            pli;
   int            y;
   int            x;
-  /*Skip past the luma data.*/
-  _dst+=_y4m->pic_w*_y4m->pic_h;
   /*Compute the size of each chroma plane.*/
   c_w=(_y4m->pic_w+_y4m->src_c_dec_h-1)/_y4m->src_c_dec_h;
   c_h=_y4m->pic_h;
   dst_c_w=(_y4m->pic_w+_y4m->dst_c_dec_h-1)/_y4m->dst_c_dec_h;
-  dst_c_h=(_y4m->pic_h+_y4m->dst_c_dec_v-1)/_y4m->dst_c_dec_v;
   c_sz=c_w*c_h;
-  dst_c_sz=dst_c_w*dst_c_h;
   tmp_sz=dst_c_w*c_h;
   tmp=_aux+2*c_sz;
   for(pli=1;pli<3;pli++){
@@ -565,8 +513,10 @@ static void y4m_convert_411_420jpeg(y4m_input *_y4m,unsigned char *_dst,
       for(x=0;x<OC_MINI(c_w,1);x++){
         tmp[x<<1]=(unsigned char)OC_CLAMPI(0,(111*_aux[0]
          +18*_aux[OC_MINI(1,c_w-1)]-_aux[OC_MINI(2,c_w-1)]+64)>>7,255);
-        tmp[x<<1|1]=(unsigned char)OC_CLAMPI(0,(47*_aux[0]
-         +86*_aux[OC_MINI(1,c_w-1)]-5*_aux[OC_MINI(2,c_w-1)]+64)>>7,255);
+        if((x<<1|1)<dst_c_w){
+          tmp[x<<1|1]=(unsigned char)OC_CLAMPI(0,(47*_aux[0]
+           +86*_aux[OC_MINI(1,c_w-1)]-5*_aux[OC_MINI(2,c_w-1)]+64)>>7,255);
+        }
       }
       for(;x<c_w-2;x++){
         tmp[x<<1]=(unsigned char)OC_CLAMPI(0,(_aux[x-1]+110*_aux[x]
@@ -587,34 +537,29 @@ static void y4m_convert_411_420jpeg(y4m_input *_y4m,unsigned char *_dst,
     }
     tmp-=tmp_sz;
     /*Now do the vertical filtering.*/
-    y4m_422jpeg_420jpeg_helper(_dst,tmp,dst_c_w,c_h);
-    _dst+=dst_c_sz;
+    y4m_422jpeg_420jpeg_helper(_img->planes[pli],_img->stride[pli],tmp,
+     dst_c_w,c_h);
   }
 }
 
 /*Convert 444 to 420jpeg.*/
-static void y4m_convert_444_420jpeg(y4m_input *_y4m,unsigned char *_dst,
+static void y4m_convert_444_420jpeg(y4m_input *_y4m,vpx_image_t *_img,
  unsigned char *_aux){
   unsigned char *tmp;
   int            c_w;
   int            c_h;
   int            c_sz;
   int            dst_c_w;
-  int            dst_c_h;
-  int            dst_c_sz;
   int            tmp_sz;
   int            pli;
   int            y;
   int            x;
-  /*Skip past the luma data.*/
-  _dst+=_y4m->pic_w*_y4m->pic_h;
+  int            i;
   /*Compute the size of each chroma plane.*/
   c_w=(_y4m->pic_w+_y4m->src_c_dec_h-1)/_y4m->src_c_dec_h;
   c_h=_y4m->pic_h;
   dst_c_w=(_y4m->pic_w+_y4m->dst_c_dec_h-1)/_y4m->dst_c_dec_h;
-  dst_c_h=(_y4m->pic_h+_y4m->dst_c_dec_v-1)/_y4m->dst_c_dec_v;
   c_sz=c_w*c_h;
-  dst_c_sz=dst_c_w*dst_c_h;
   tmp_sz=dst_c_w*c_h;
   tmp=_aux+2*c_sz;
   for(pli=1;pli<3;pli++){
@@ -625,10 +570,13 @@ static void y4m_convert_444_420jpeg(y4m_input *_y4m,unsigned char *_dst,
          -17*_aux[OC_MINI(2,c_w-1)]
          +3*_aux[OC_MINI(3,c_w-1)]+64)>>7,255);
       }
-      for(;x<c_w-3;x+=2){
-        tmp[x>>1]=OC_CLAMPI(0,(3*(_aux[x-2]+_aux[x+3])
-         -17*(_aux[x-1]+_aux[x+2])+78*(_aux[x]+_aux[x+1])+64)>>7,255);
+      /*Count the interior in output samples, which the compiler vectorizes
+         more readily than the input stepping by two.*/
+      for(i=x>>1;i<(c_w-2)>>1;i++){
+        tmp[i]=OC_CLAMPI(0,(3*(_aux[2*i-2]+_aux[2*i+3])
+         -17*(_aux[2*i-1]+_aux[2*i+2])+78*(_aux[2*i]+_aux[2*i+1])+64)>>7,255);
       }
+      x=i<<1;
       for(;x<c_w;x+=2){
         tmp[x>>1]=OC_CLAMPI(0,(3*(_aux[x-2]+_aux[c_w-1])-
          17*(_aux[x-1]+_aux[OC_MINI(x+2,c_w-1)])+
@@ -639,23 +587,29 @@ static void y4m_convert_444_420jpeg(y4m_input *_y4m,unsigned char *_dst,
     }
     tmp-=tmp_sz;
     /*Now do the vertical filtering.*/
-    y4m_422jpeg_420jpeg_helper(_dst,tmp,dst_c_w,c_h);
-    _dst+=dst_c_sz;
+    y4m_422jpeg_420jpeg_helper(_img->planes[pli],_img->stride[pli],tmp,
+     dst_c_w,c_h);
   }
 }
 
 /*The image is padded with empty chroma components at 4:2:0.*/
-static void y4m_convert_mono_420jpeg(y4m_input *_y4m,unsigned char *_dst,
+static void y4m_convert_mono_420jpeg(y4m_input *_y4m,vpx_image_t *_img,
  unsigned char *_aux){
-  int c_sz;
-  _dst+=_y4m->pic_w*_y4m->pic_h;
-  c_sz=((_y4m->pic_w+_y4m->dst_c_dec_h-1)/_y4m->dst_c_dec_h)*
-   ((_y4m->pic_h+_y4m->dst_c_dec_v-1)/_y4m->dst_c_dec_v);
-  memset(_dst,128,c_sz*2);
+  int c_w;
+  int c_h;
+  int pli;
+  int y;
+  c_w=(_y4m->pic_w+_y4m->dst_c_dec_h-1)/_y4m->dst_c_dec_h;
+  c_h=(_y4m->pic_h+_y4m->dst_c_dec_v-1)/_y4m->dst_c_dec_v;
+  for(pli=1;pli<3;pli++){
+    for(y=0;y<c_h;y++){
+      memset(_img->planes[pli]+y*_img->stride[pli],128,c_w);
+    }
+  }
 }
 
 /*No conversion function needed.*/
-static void y4m_convert_null(y4m_input *_y4m,unsigned char *_dst,
+static void y4m_convert_null(y4m_input *_y4m,vpx_image_t *_img,
  unsigned char *_aux){
 }
 
@@ -706,15 +660,12 @@ int y4m_input_open(y4m_input *_y4m,FILE *_fin,char *_skip,int _nskip){
   if(strcmp(_y4m->chroma_type,"420")==0||
    strcmp(_y4m->chroma_type,"420jpeg")==0){
     _y4m->src_c_dec_h=_y4m->dst_c_dec_h=_y4m->src_c_dec_v=_y4m->dst_c_dec_v=2;
-    _y4m->dst_buf_read_sz=_y4m->pic_w*_y4m->pic_h
-     +2*((_y4m->pic_w+1)/2)*((_y4m->pic_h+1)/2);
     /*Natively supported: no conversion required.*/
     _y4m->aux_buf_sz=_y4m->aux_buf_read_sz=0;
     _y4m->convert=y4m_convert_null;
   }
   else if(strcmp(_y4m->chroma_type,"420mpeg2")==0){
     _y4m->src_c_dec_h=_y4m->dst_c_dec_h=_y4m->src_c_dec_v=_y4m->dst_c_dec_v=2;
-    _y4m->dst_buf_read_sz=_y4m->pic_w*_y4m->pic_h;
     /*Chroma filter required: read into the aux buf first.*/
     _y4m->aux_buf_sz=_y4m->aux_buf_read_sz=
      2*((_y4m->pic_w+1)/2)*((_y4m->pic_h+1)/2);
@@ -722,7 +673,6 @@ int y4m_input_open(y4m_input *_y4m,FILE *_fin,char *_skip,int _nskip){
   }
   else if(strcmp(_y4m->chroma_type,"420paldv")==0){
     _y4m->src_c_dec_h=_y4m->dst_c_dec_h=_y4m->src_c_dec_v=_y4m->dst_c_dec_v=2;
-    _y4m->dst_buf_read_sz=_y4m->pic_w*_y4m->pic_h;
     /*Chroma filter required: read into the aux buf first.
       We need to make two filter passes, so we need some extra space in the
        aux buffer.*/
@@ -734,7 +684,6 @@ int y4m_input_open(y4m_input *_y4m,FILE *_fin,char *_skip,int _nskip){
     _y4m->src_c_dec_h=_y4m->dst_c_dec_h=2;
     _y4m->src_c_dec_v=1;
     _y4m->dst_c_dec_v=2;
-    _y4m->dst_buf_read_sz=_y4m->pic_w*_y4m->pic_h;
     /*Chroma filter required: read into the aux buf first.*/
     _y4m->aux_buf_sz=_y4m->aux_buf_read_sz=2*((_y4m->pic_w+1)/2)*_y4m->pic_h;
     _y4m->convert=y4m_convert_422jpeg_420jpeg;
@@ -743,7 +692,6 @@ int y4m_input_open(y4m_input *_y4m,FILE *_fin,char *_skip,int _nskip){
     _y4m->src_c_dec_h=_y4m->dst_c_dec_h=2;
     _y4m->src_c_dec_v=1;
     _y4m->dst_c_dec_v=2;
-    _y4m->dst_buf_read_sz=_y4m->pic_w*_y4m->pic_h;
     /*Chroma filter required: read into the aux buf first.
       We need to make two filter passes, so we need some extra space in the
        aux buffer.*/
@@ -756,7 +704,6 @@ int y4m_input_open(y4m_input *_y4m,FILE *_fin,char *_skip,int _nskip){
     _y4m->dst_c_dec_h=2;
     _y4m->src_c_dec_v=1;
     _y4m->dst_c_dec_v=2;
-    _y4m->dst_buf_read_sz=_y4m->pic_w*_y4m->pic_h;
     /*Chroma filter required: read into the aux buf first.
       We need to make two filter passes, so we need some extra space in the
        aux buffer.*/
@@ -769,7 +716,6 @@ int y4m_input_open(y4m_input *_y4m,FILE *_fin,char *_skip,int _nskip){
     _y4m->dst_c_dec_h=2;
     _y4m->src_c_dec_v=1;
     _y4m->dst_c_dec_v=2;
-    _y4m->dst_buf_read_sz=_y4m->pic_w*_y4m->pic_h;
     /*Chroma filter required: read into the aux buf first.
       We need to make two filter passes, so we need some extra space in the
        aux buffer.*/
@@ -782,7 +728,6 @@ int y4m_input_open(y4m_input *_y4m,FILE *_fin,char *_skip,int _nskip){
     _y4m->dst_c_dec_h=2;
     _y4m->src_c_dec_v=1;
     _y4m->dst_c_dec_v=2;
-    _y4m->dst_buf_read_sz=_y4m->pic_w*_y4m->pic_h;
     /*Chroma filter required: read into the aux buf first.
       We need to make two filter passes, so we need some extra space in the
        aux buffer.
@@ -794,7 +739,6 @@ int y4m_input_open(y4m_input *_y4m,FILE *_fin,char *_skip,int _nskip){
   else if(strcmp(_y4m->chroma_type,"mono")==0){
     _y4m->src_c_dec_h=_y4m->src_c_dec_v=0;
     _y4m->dst_c_dec_h=_y4m->dst_c_dec_v=2;
-    _y4m->dst_buf_read_sz=_y4m->pic_w*_y4m->pic_h;
     /*No extra space required, but we need to clear the chroma planes.*/
     _y4m->aux_buf_sz=_y4m->aux_buf_read_sz=0;
     _y4m->convert=y4m_convert_mono_420jpeg;
@@ -808,7 +752,7 @@ int y4m_input_open(y4m_input *_y4m,FILE *_fin,char *_skip,int _nskip){
   _y4m->dst_buf_sz=_y4m->pic_w*_y4m->pic_h
    +2*((_y4m->pic_w+_y4m->dst_c_dec_h-1)/_y4m->dst_c_dec_h)*
    ((_y4m->pic_h+_y4m->dst_c_dec_v-1)/_y4m->dst_c_dec_v);
-  _y4m->dst_buf=(unsigned char *)malloc(_y4m->dst_buf_sz);
+  _y4m->dst_buf=NULL;
   _y4m->aux_buf=(unsigned char *)malloc(_y4m->aux_buf_sz);
   return 0;
 }
@@ -818,15 +762,28 @@ void y4m_input_close(y4m_input *_y4m){
   free(_y4m->aux_buf);
 }
 
-int y4m_input_fetch_frame(y4m_input *_y4m,FILE *_fin,vpx_image_t *_img){
+/*Read one plane into an image, a row at a time if it is padded.*/
+static int y4m_read_plane(FILE *_fin,unsigned char *_dst,int _stride,
+ int _w,int _h){
+  int y;
+  if(_stride==_w)return fread(_dst,1,(size_t)_w*_h,_fin)==(size_t)_w*_h;
+  for(y=0;y<_h;y++){
+    if(fread(_dst,1,_w,_fin)!=(size_t)_w)return 0;
+    _dst+=_stride;
+  }
+  return 1;
+}
+
+int y4m_input_fetch_frame_into(y4m_input *_y4m,FILE *_fin,vpx_image_t *_img){
   char frame[6];
-  int  pic_sz;
-  int  frame_c_w;
-  int  frame_c_h;
   int  c_w;
   int  c_h;
-  int  c_sz;
+  int  ok;
   int  ret;
+  if(_img->d_w!=(unsigned)_y4m->pic_w||_img->d_h!=(unsigned)_y4m->pic_h){
+    fprintf(stderr,"Y4M frame does not fit the destination image.\n");
+    return -1;
+  }
   /*Read and skip the frame header.*/
   ret=fread(frame,1,6,_fin);
   if(ret<6)return 0;
@@ -843,18 +800,38 @@ int y4m_input_fetch_frame(y4m_input *_y4m,FILE *_fin,vpx_image_t *_img){
       return -1;
     }
   }
-  /*Read the frame data that needs no conversion.*/
-  if(fread(_y4m->dst_buf,1,_y4m->dst_buf_read_sz,_fin)!=_y4m->dst_buf_read_sz){
-    fprintf(stderr,"Error reading Y4M frame data.\n");
-    return -1;
+  c_w=(_y4m->pic_w+_y4m->dst_c_dec_h-1)/_y4m->dst_c_dec_h;
+  c_h=(_y4m->pic_h+_y4m->dst_c_dec_v-1)/_y4m->dst_c_dec_v;
+  /*Read the frame data that needs no conversion straight into the image.*/
+  ok=y4m_read_plane(_fin,_img->planes[PLANE_Y],_img->stride[PLANE_Y],
+   _y4m->pic_w,_y4m->pic_h);
+  if(_y4m->convert==y4m_convert_null){
+    ok=ok&&y4m_read_plane(_fin,_img->planes[PLANE_U],_img->stride[PLANE_U],
+     c_w,c_h);
+    ok=ok&&y4m_read_plane(_fin,_img->planes[PLANE_V],_img->stride[PLANE_V],
+     c_w,c_h);
   }
   /*Read the frame data that does need conversion.*/
-  if(fread(_y4m->aux_buf,1,_y4m->aux_buf_read_sz,_fin)!=_y4m->aux_buf_read_sz){
+  if(!ok||fread(_y4m->aux_buf,1,_y4m->aux_buf_read_sz,_fin)!=
+   _y4m->aux_buf_read_sz){
     fprintf(stderr,"Error reading Y4M frame data.\n");
     return -1;
   }
-  /*Now convert the just read frame.*/
-  (*_y4m->convert)(_y4m,_y4m->dst_buf,_y4m->aux_buf);
+  /*Now convert the just read frame into the chroma planes.*/
+  (*_y4m->convert)(_y4m,_img,_y4m->aux_buf);
+  return 1;
+}
+
+int y4m_input_fetch_frame(y4m_input *_y4m,FILE *_fin,vpx_image_t *_img){
+  int  pic_sz;
+  int  c_w;
+  int  c_h;
+  int  c_sz;
+  /*The frame buffer is only needed here, so allocate it on first use.*/
+  if(_y4m->dst_buf==NULL){
+    _y4m->dst_buf=(unsigned char *)malloc(_y4m->dst_buf_sz);
+    if(_y4m->dst_buf==NULL)return -1;
+  }
   /*Fill in the frame buffer pointers.
     We don't use vpx_img_wrap() because it forces padding for odd picture
      sizes, which would require a separate fread call for every row.*/
@@ -877,5 +854,5 @@ int y4m_input_fetch_frame(y4m_input *_y4m,FILE *_fin,vpx_image_t *_img){
   _img->planes[PLANE_Y]=_y4m->dst_buf;
   _img->planes[PLANE_U]=_y4m->dst_buf+pic_sz;
   _img->planes[PLANE_V]=_y4m->dst_buf+pic_sz+c_sz;
-  return 1;
+  return y4m_input_fetch_frame_into(_y4m,_fin,_img);
 }
@@ -21,9 +21,10 @@ typedef struct y4m_input y4m_input;
 
 
 
-/*The function used to perform chroma conversion.*/
+/*The function used to perform chroma conversion into the image's chroma
+   planes.*/
 typedef void (*y4m_convert_func)(y4m_input *_y4m,
- unsigned char *_dst,unsigned char *_src);
+ vpx_image_t *_img,unsigned char *_src);
 
 
 
@@ -40,10 +41,8 @@ struct y4m_input{
   int               dst_c_dec_h;
   int               dst_c_dec_v;
   char              chroma_type[16];
-  /*The size of each converted frame buffer.*/
+  /*The size of the converted frame buffer used by y4m_input_fetch_frame().*/
   size_t            dst_buf_sz;
-  /*The amount to read directly into the converted frame buffer.*/
-  size_t            dst_buf_read_sz;
   /*The size of the auxilliary buffer.*/
   size_t            aux_buf_sz;
   /*The amount to read into the auxilliary buffer.*/
@@ -55,6 +54,11 @@ struct y4m_input{
 
 int y4m_input_open(y4m_input *_y4m,FILE *_fin,char *_skip,int _nskip);
 void y4m_input_close(y4m_input *_y4m);
+/*Reads the next frame into a buffer owned by the reader and points img at it.
+  The buffer is overwritten by the next call.*/
 int y4m_input_fetch_frame(y4m_input *_y4m,FILE *_fin,vpx_image_t *img);
+/*Reads and converts the next frame directly into an allocated 4:2:0 image of
+   the picture size, without the intermediate copy.*/
+int y4m_input_fetch_frame_into(y4m_input *_y4m,FILE *_fin,vpx_image_t *img);
 
 #endif